@@ -0,0 +1,69 @@
+/**
+ * @file    CatchUpPlan.h
+ * @brief   Catch-up plan/progress types shared by the clock engine and the web layer.
+ *
+ * Plain data shared between SystemManager (producer) and the web layer
+ * (consumer) without either including the other.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @enum CatchUpPlanStatus
+ * @brief Outcome of a manual-set command.
+ */
+enum class CatchUpPlanStatus : uint8_t {
+    PLANNED,    ///< Position stored; catch-up started (or none needed).
+    HOLD,       ///< Position stored; dial ahead, pulses paused until real time catches up.
+    REJECTED,   ///< Position stored; both strategies exceed max_catchup_minutes.
+    QUEUED,     ///< Command accepted, engine did not answer in time.
+    DROPPED,    ///< Command queue full; nothing changed.
+    INVALID     ///< Unknown channel; nothing changed.
+};
+
+/// JSON name of a plan status ("planned", "hold", …) for /api/set-state and the "plan" event.
+inline const char* catchUpPlanStatusName(CatchUpPlanStatus s) {
+    switch (s) {
+        case CatchUpPlanStatus::PLANNED:  return "planned";
+        case CatchUpPlanStatus::HOLD:     return "hold";
+        case CatchUpPlanStatus::REJECTED: return "rejected";
+        case CatchUpPlanStatus::QUEUED:   return "queued";
+        case CatchUpPlanStatus::DROPPED:  return "dropped";
+        default:                          return "invalid";
+    }
+}
+
+/**
+ * @struct CatchUpPlan
+ * @brief What the clock engine will do after a manual HH:MM entry.
+ */
+struct CatchUpPlan {
+    CatchUpPlanStatus status     = CatchUpPlanStatus::DROPPED;
+    int               pulses     = 0;   ///< Forward steps to emit.
+    int               holdMinutes = 0;  ///< Minutes the dial is ahead (HOLD).
+    uint32_t          intervalMs = 0;   ///< Cruise spacing between catch-up pulses (profile minimum).
+    uint32_t          etaMs      = 0;   ///< Estimated time until the dial shows real time.
+    uint32_t          seq        = 0;   ///< Command id; the engine's "plan" event carries it too.
+};
+
+/**
+ * @struct CatchUpStatus
+ * @brief Live catch-up progress snapshot for /api/status.
+ */
+struct CatchUpStatus {
+    char     name[16]      = "";    ///< Channel name from config.
+    int      clockMinutes  = -1;    ///< Dial position (minutes of day), -1 if unknown.
+    bool     active        = false;
+    bool     holding       = false; ///< Dial ahead; waiting (etaMs = time left).
+    int      done          = 0;     ///< Pulses emitted in this session.
+    int      remaining     = 0;
+    uint32_t intervalMs    = 0;     ///< Period used for the next pulse.
+    uint32_t etaMs         = 0;     ///< Estimated time to the last step's completion.
+    float    pulsesPerSec  = 0.0f;  ///< Achieved rate since the session started.
+    int32_t  edgeOffsetUs  = -1;    ///< Last minute pulse start after :00 (µs), -1 = none yet.
+    const char* feedback   = "off"; ///< Step verification: "off" | "current" | "sensor" | "fault".
+    uint32_t minIntervalMs = 0;     ///< Cruise period in use (learned while feedback confirms steps).
+    uint32_t missed        = 0;     ///< Steps retried after a feedback miss (since boot).
+};
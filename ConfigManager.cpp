@@ -3,72 +3,175 @@
  * @brief   Loads and exposes runtime configuration from /config.json on SD.
  *
  * Responsibilities:
- *  - Mount SD (fallback to defaults if SD/JSON is unavailable or invalid)
- *  - Parse JSON via ArduinoJson
- *  - Provide a strongly-typed Config instance to the rest of the app
+ *  - Parse JSON via ArduinoJson (fallback to defaults if it is missing or invalid)
+ *  - Validate it once into a typed Config (enums, fixed-size strings)
+ *  - Cache that Config in NVS keyed by the JSON's CRC32, so unchanged config
+ *    boots without parsing
  *
  * Notes:
  *  - This module prints short Slovak status lines to Serial (kept as-is).
- *  - `begin()` calls `SD.begin()` with default CS; your main() already does
- *    `SD.begin(SD_CS)`. This duplication is harmless; left unchanged by request.
+ *  - SD is mounted by setup() (`SD.begin(SD_CS)`); `begin()` no longer
+ *    mounts it a second time with the default CS.
  */
 
 #include "ConfigManager.h"
+#include <Preferences.h>
+#include <esp_rom_crc.h>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Config>::value, "Config is stored byte-for-byte in NVS");
 
 /**
- * @brief Initialize configuration by attempting to mount SD and read JSON.
+ * @brief Load configuration from the NVS snapshot or, if the JSON changed, by parsing it.
  * @param path Path to the JSON config file (default: "/config.json").
  * @return true if configuration was loaded successfully; false if defaults used.
  *
  * Behavior:
- *  - If SD mount fails → apply defaults and return false.
- *  - If JSON load/parse fails → apply defaults and return false.
- *  - Otherwise → store parsed values and return true.
+ *  - If the file is missing (or SD not mounted) → apply defaults and return false.
+ *  - If the snapshot matches the file's size and CRC32 → restore it, no parse.
+ *  - Else parse; on success store a new snapshot, on failure apply defaults.
  */
 bool ConfigManager::begin(const char* path) {
-    if (!SD.begin()) {
-        Serial.println("❌ SD initialization failed.");
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        Serial.printf("⚠️ Config file %s not found, using defaults.\n", path);
         applyDefaults();
         return false;
     }
 
-    if (!loadFromFile(path)) {
+    uint32_t crc = 0, size = 0;
+    checksumFile(file, crc, size);
+    if (loadSnapshot(size, crc)) {
+        file.close();
+        Serial.println("✅ Config restored from NVS (config.json unchanged).");
+        printSummary();
+        return true;
+    }
+
+    file.seek(0);
+    const bool ok = parseJson(file);
+    file.close();
+    if (!ok) {
         Serial.println("⚠️ Loading config failed, using defaults.");
         applyDefaults();
         return false;
     }
 
+    saveSnapshot(size, crc);
     Serial.println("✅ Config loaded successfully.");
+    printSummary();
     return true;
 }
 
 /**
- * @brief Load and parse configuration from the given JSON file.
- * @param path Absolute path on SD (e.g., "/config.json").
- * @return true on success, false if file missing or JSON invalid.
+ * @brief CRC32 over the file in 256-byte chunks.
+ */
+void ConfigManager::checksumFile(File& file, uint32_t& crc, uint32_t& size) {
+    uint8_t buf[256];
+    crc  = 0;
+    size = 0;
+    size_t n;
+    while ((n = file.read(buf, sizeof(buf))) > 0) {
+        crc   = esp_rom_crc32_le(crc, buf, n);
+        size += n;
+    }
+}
+
+/**
+ * @brief Restore @ref config from NVS.
+ * @return false if there is no snapshot or it was built from another JSON,
+ *         by another parser version or for another Config layout.
+ */
+bool ConfigManager::loadSnapshot(uint32_t jsonSize, uint32_t jsonCrc) {
+    Preferences prefs;
+    if (!prefs.begin("config", /*readOnly=*/true)) return false;
+
+    struct {
+        SnapshotHeader h;
+        Config         c;
+    } blob;
+    bool ok = prefs.getBytesLength("snap") == sizeof(blob) &&
+              prefs.getBytes("snap", &blob, sizeof(blob)) == sizeof(blob);
+    prefs.end();
+
+    ok = ok && blob.h.magic == SNAPSHOT_MAGIC && blob.h.version == SNAPSHOT_VERSION &&
+         blob.h.configSize == sizeof(Config) &&
+         blob.h.jsonSize == jsonSize && blob.h.jsonCrc == jsonCrc;
+    if (ok) config = blob.c;
+    return ok;
+}
+
+/**
+ * @brief Store @ref config in NVS (only after a successful parse, i.e. when the JSON changed).
+ */
+void ConfigManager::saveSnapshot(uint32_t jsonSize, uint32_t jsonCrc) {
+    Preferences prefs;
+    if (!prefs.begin("config", /*readOnly=*/false)) return;
+
+    struct {
+        SnapshotHeader h;
+        Config         c;
+    } blob;
+    blob.h = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, (uint16_t)sizeof(Config), jsonSize, jsonCrc };
+    blob.c = config;
+    if (prefs.putBytes("snap", &blob, sizeof(blob)) != sizeof(blob)) {
+        Serial.println("⚠️ Config snapshot not stored in NVS (next boot parses again).");
+    }
+    prefs.end();
+}
+
+/**
+ * @brief Copy a JSON string into a fixed Config field.
+ */
+void ConfigManager::copyField(char* dst, size_t size, const char* src, const char* key) {
+    if (strlcpy(dst, src ? src : "", size) >= size) {
+        Serial.printf("⚠️ %s longer than %u characters — truncated.\n", key, (unsigned)(size - 1));
+    }
+}
+
+/**
+ * @brief Parse configuration from an open JSON file.
+ * @param file Open file positioned at its start.
+ * @return true on success, false if the JSON is invalid.
  *
  * JSON schema (selected keys):
  *  - wifi_ssid, wifi_password, ntp_server
  *  - tz_mode: "posix" | "eu" | "fixed"
  *  - posix_tz: e.g., "CET-1CEST,M3.5.0/2,M10.5.0/3"
  *  - time_zone_offset_hrs, time_zone_offset_min, use_eu_dst
- *  - mode: "auto"...
+ *  - mode: "auto" | "manual"
  *  - impulse_interval_sec, impulse_delay_ms
  *  - resync_rtc_if_diff_seconds, max_catchup_minutes
  *  - web_edit_enabled, debug_serial
- *  - ntp_resync_every_minutes
+ *  - ntp_resync_every_minutes, ntp_resync_max_minutes
+ *  - power_mode: "normal" | "low", power_active_ma, power_idle_ma, power_sleep_ma
+ *  - fleet_mode: "off" | "auto" | "leader" | "follower", fleet_group,
+ *    fleet_port, fleet_priority, fleet_name
+ *  - web_cache_kb, static_max_age_s, web_max_clients
+ *  - log_retention_days, log_max_total_kb, log_archive, event_log
+ *  - pulse_backend: "loop" | "esp_timer", pulse_width_us, pulse_dead_time_us
+ *  - clock_type, catchup_profiles: { "<clock_type>": { start_interval_ms,
+ *    min_interval_ms, ramp_pulses, slowdown_pulses } }
+ *  - feedback: "off" | "current" | "sensor", feedback_pin, feedback_threshold
+ *  - channels: [ { name, in1, in2, pulse_width_us, pulse_dead_time_us,
+ *    clock_type, feedback, feedback_pin, feedback_threshold } ],
+ *    max_concurrent_drives
  */
-bool ConfigManager::loadFromFile(const char* path) {
-    File file = SD.open(path, FILE_READ);
-    if (!file) {
-        Serial.printf("⚠️ Config file %s not found.\n", path);
+bool ConfigManager::parseJson(File& file) {
+    // Twice the file covers the slots even for short keys and values.
+    const size_t capacity = min(max((size_t)file.size() * 2, JSON_DOC_MIN), JSON_DOC_MAX);
+    DynamicJsonDocument doc(capacity);
+    if (doc.capacity() == 0) {
+        Serial.printf("❌ No heap for a %u-byte config parse buffer.\n", (unsigned)capacity);
         return false;
     }
-
-    StaticJsonDocument<2048> doc; // Adjust capacity if config grows.
     DeserializationError error = deserializeJson(doc, file);
-    file.close();
 
+    if (error == DeserializationError::NoMemory) {
+        Serial.printf("❌ config.json too large: %u bytes do not fit the %u-byte parse buffer.\n",
+                      (unsigned)file.size(), (unsigned)capacity);
+        return false;
+    }
     if (error) {
         Serial.print("❌ Failed to parse config.json: ");
         Serial.println(error.c_str());
@@ -76,37 +179,29 @@ bool ConfigManager::loadFromFile(const char* path) {
     }
 
     // ---- WiFi & NTP ----
-    {
-        const char* s = doc["wifi_ssid"]    | "";
-        config.wifiSsid = String(s);
-    }
-    {
-        const char* s = doc["wifi_password"]| "";
-        config.wifiPassword = String(s);
-    }
-    {
-        const char* s = doc["ntp_server"]   | "pool.ntp.org";
-        config.ntpServer = String(s);
-    }
+    copyField(config.wifiSsid,     sizeof(config.wifiSsid),     doc["wifi_ssid"]     | "", "wifi_ssid");
+    copyField(config.wifiPassword, sizeof(config.wifiPassword), doc["wifi_password"] | "", "wifi_password");
+    copyField(config.ntpServer,    sizeof(config.ntpServer),    doc["ntp_server"]    | "pool.ntp.org", "ntp_server");
 
     // ---- Timezone mode selection ----
-    {
-        const char* s = doc["tz_mode"] | "eu";             // "posix"|"eu"|"fixed"
-        config.tz_mode = toLowerTrim(String(s));
-    }
-    {
-        const char* s = doc["posix_tz"] | "";
-        config.posix_tz = String(s);
-    }
+    // Resolved once as SystemManager used to at every boot: posix needs a
+    // string, otherwise "eu" or use_eu_dst select CET/CEST, else the fixed offset.
+    copyField(config.posixTz, sizeof(config.posixTz), doc["posix_tz"] | "", "posix_tz");
     config.timeZoneOffsetHrs = doc["time_zone_offset_hrs"] | 0;
     config.timeZoneOffsetMin = doc["time_zone_offset_min"] | 0;
     config.useEuDst          = doc["use_eu_dst"]           | true;
-
-    // ---- App behavior ----
     {
-        const char* s = doc["mode"] | "auto";
-        config.mode = String(s);
+        const String m = toLowerTrim(String((const char*)(doc["tz_mode"] | "eu")));   // "posix"|"eu"|"fixed"
+        if (m == "posix" && config.posixTz[0] != '\0') config.tzMode = TzMode::POSIX;
+        else if (m == "eu" || config.useEuDst)           config.tzMode = TzMode::EU;
+        else                                             config.tzMode = TzMode::FIXED;
+        if (m == "posix" && config.tzMode != TzMode::POSIX) {
+            Serial.printf("⚠️ tz_mode \"posix\" without posix_tz — using %s.\n", tzModeName(config.tzMode));
+        }
     }
+
+    // ---- App behavior ----
+    config.mode = (strcmp(doc["mode"] | "auto", "auto") == 0) ? ClockMode::AUTO : ClockMode::MANUAL;
     config.impulseIntervalSec     = doc["impulse_interval_sec"]       | 60;
     config.impulseDelayMs         = doc["impulse_delay_ms"]           | 500;
     config.resyncRtcIfDiffSeconds = doc["resync_rtc_if_diff_seconds"] | 60;
@@ -118,34 +213,182 @@ bool ConfigManager::loadFromFile(const char* path) {
     config.ntpResyncEveryMinutes = doc["ntp_resync_every_minutes"] | 15;
     // allow 0 = disabled, clamp negatives to 0
     if (config.ntpResyncEveryMinutes < 0) config.ntpResyncEveryMinutes = 0;
+    // Adaptive poll ceiling; never below the base cadence
+    config.ntpResyncMaxMinutes = doc["ntp_resync_max_minutes"] | 720;
+    if (config.ntpResyncMaxMinutes < config.ntpResyncEveryMinutes)
+        config.ntpResyncMaxMinutes = config.ntpResyncEveryMinutes;
+
+    // Static asset cache / browser caching
+    config.webCacheKb      = doc["web_cache_kb"]     | 48;
+    config.staticMaxAgeSec = doc["static_max_age_s"] | 300;
+    if (config.webCacheKb < 0)      config.webCacheKb = 0;
+    if (config.staticMaxAgeSec < 0) config.staticMaxAgeSec = 0;
+    config.webMaxClients   = doc["web_max_clients"]  | 4;
+    if (config.webMaxClients < 1)   config.webMaxClients = 1;
+
+    // Log retention (background job, see LogRetention)
+    config.logRetentionDays = doc["log_retention_days"] | 60;
+    config.logMaxTotalKb    = doc["log_max_total_kb"]   | 0;
+    config.logArchive       = doc["log_archive"]        | true;
+    config.eventLog         = doc["event_log"]          | true;
+    if (config.logRetentionDays < 0) config.logRetentionDays = 0;
+    if (config.logMaxTotalKb < 0)    config.logMaxTotalKb = 0;
+
+    // Power mode + current model for the status estimate
+    config.powerMode = (toLowerTrim(String((const char*)(doc["power_mode"] | "normal"))) == "low")
+                       ? PowerMode::LOW_POWER : PowerMode::NORMAL;
+    config.powerActiveMa = doc["power_active_ma"] | 80;
+    config.powerIdleMa   = doc["power_idle_ma"]   | 40;
+    config.powerSleepMa  = doc["power_sleep_ma"]  | 4;
+
+    // Fleet mode (see FleetManager)
+    {
+        const String m = toLowerTrim(String((const char*)(doc["fleet_mode"] | "off")));
+        config.fleetMode = m == "auto"     ? FleetMode::AUTO
+                         : m == "leader"   ? FleetMode::LEADER
+                         : m == "follower" ? FleetMode::FOLLOWER
+                         :                   FleetMode::OFF;
+        if (m != "off" && config.fleetMode == FleetMode::OFF) {
+            Serial.printf("⚠️ Unknown fleet_mode \"%s\" — fleet off.\n", m.c_str());
+        }
+    }
+    copyField(config.fleetGroup, sizeof(config.fleetGroup), doc["fleet_group"] | "239.255.42.99", "fleet_group");
+    copyField(config.fleetName,  sizeof(config.fleetName),  doc["fleet_name"]  | "", "fleet_name");
+    config.fleetPort     = doc["fleet_port"]     | 4210;
+    config.fleetPriority = doc["fleet_priority"] | 100;
+    if (config.fleetPort < 1 || config.fleetPort > 65535) config.fleetPort = 4210;
+    if (config.fleetPriority < 0)   config.fleetPriority = 0;
+    if (config.fleetPriority > 255) config.fleetPriority = 255;
+
+    // Pulse waveform (µs); width defaults to the legacy impulse_delay_ms
+    config.pulseBackend = (toLowerTrim(String((const char*)(doc["pulse_backend"] | "loop"))) == "esp_timer")
+                          ? PulseTiming::ESP_TIMER : PulseTiming::LOOP;
+    config.pulseWidthUs    = doc["pulse_width_us"]     | (config.impulseDelayMs * 1000);
+    config.pulseDeadTimeUs = doc["pulse_dead_time_us"] | 150000;
 
     // Sanity clamps
+    if (config.pulseWidthUs    < 1000) config.pulseWidthUs    = 1000;
+    if (config.pulseDeadTimeUs < 0)    config.pulseDeadTimeUs = 0;
     if (config.timeZoneOffsetMin < 0)  config.timeZoneOffsetMin = 0;
     if (config.timeZoneOffsetMin > 59) config.timeZoneOffsetMin = 59;
 
-    // Short summary to Serial (useful for field debugging)
+    // Catch-up profile for this movement; missing keys keep the generic curve
+    copyField(config.clockType, sizeof(config.clockType),
+              toLowerTrim(String((const char*)(doc["clock_type"] | "generic"))).c_str(), "clock_type");
+    resolveCatchUpProfile(doc["catchup_profiles"], config.clockType,
+                          config.pulseWidthUs, config.pulseDeadTimeUs, config.catchup);
+
+    // Step feedback; channels inherit mode and threshold, channel 0 also the pin
+    config.feedback          = parseFeedbackMode(doc["feedback"] | "off");
+    config.feedbackPin       = doc["feedback_pin"]       | -1;
+    config.feedbackThreshold = doc["feedback_threshold"] | 400;
+    if (config.feedbackThreshold < 0) config.feedbackThreshold = 0;
+
+    // Channels: absent → one line built from the settings above
+    applyDefaultChannels();
+    config.maxConcurrentDrives = doc["max_concurrent_drives"] | 1;
+    if (config.maxConcurrentDrives < 1) config.maxConcurrentDrives = 1;
+    {
+        JsonArray arr = doc["channels"].as<JsonArray>();
+        int n = 0;
+        for (JsonVariant c : arr) {
+            if (n >= MAX_CHANNELS) {
+                Serial.printf("⚠️ More than %d channels configured — extra entries ignored.\n", MAX_CHANNELS);
+                break;
+            }
+            ChannelConfig& ch = config.channels[n];
+            char defName[8]; snprintf(defName, sizeof(defName), "ch%d", n);
+            copyField(ch.name, sizeof(ch.name), c["name"] | defName, "channels[].name");
+            ch.pinIn1          = c["in1"] | (n == 0 ? -1 : -2);
+            ch.pinIn2          = c["in2"] | (n == 0 ? -1 : -2);
+            ch.pulseWidthUs    = c["pulse_width_us"]     | config.pulseWidthUs;
+            ch.pulseDeadTimeUs = c["pulse_dead_time_us"] | config.pulseDeadTimeUs;
+            copyField(ch.clockType, sizeof(ch.clockType),
+                      toLowerTrim(String((const char*)(c["clock_type"] | (const char*)config.clockType))).c_str(),
+                      "channels[].clock_type");
+            if (ch.pinIn1 == -2 || ch.pinIn2 == -2) {
+                Serial.printf("⚠️ Channel '%s' has no in1/in2 pins — skipped.\n", ch.name);
+                continue;
+            }
+            if (ch.pulseWidthUs    < 1000) ch.pulseWidthUs    = 1000;
+            if (ch.pulseDeadTimeUs < 0)    ch.pulseDeadTimeUs = 0;
+            resolveCatchUpProfile(doc["catchup_profiles"], ch.clockType,
+                                  ch.pulseWidthUs, ch.pulseDeadTimeUs, ch.catchup);
+            ch.feedback          = c["feedback"].isNull() ? config.feedback
+                                                          : parseFeedbackMode(c["feedback"] | "off");
+            ch.feedbackPin       = c["feedback_pin"]       | (n == 0 ? config.feedbackPin : -1);
+            ch.feedbackThreshold = c["feedback_threshold"] | config.feedbackThreshold;
+            if (ch.feedbackThreshold < 0) ch.feedbackThreshold = 0;
+            if (ch.feedback != FeedbackMode::OFF && ch.feedbackPin < 0) {
+                Serial.printf("⚠️ Channel '%s' has feedback but no feedback_pin — open loop.\n", ch.name);
+                ch.feedback = FeedbackMode::OFF;
+            }
+            n++;
+        }
+        if (n > 0) config.channelCount = n;
+        else if (config.feedback != FeedbackMode::OFF && config.feedbackPin < 0) {
+            Serial.println(F("⚠️ feedback set without feedback_pin — open loop."));
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Print the effective configuration (after a parse or a snapshot restore).
+ */
+void ConfigManager::printSummary() const {
     Serial.println(F("---- Loaded Config ----"));
-    Serial.printf("WiFi SSID: %s\n", config.wifiSsid.c_str());
-    Serial.printf("NTP Server: %s\n", config.ntpServer.c_str());
-    Serial.printf("TZ Mode: %s\n",   config.tz_mode.c_str());
-    if (config.tz_mode == "posix") {
-        Serial.printf("POSIX TZ: %s\n", config.posix_tz.c_str());
-    } else if (config.tz_mode == "fixed") {
+    Serial.printf("WiFi SSID: %s\n", config.wifiSsid);
+    Serial.printf("NTP Server: %s\n", config.ntpServer);
+    Serial.printf("Mode: %s, TZ Mode: %s\n", modeName(config.mode), tzModeName(config.tzMode));
+    if (config.tzMode == TzMode::POSIX) {
+        Serial.printf("POSIX TZ: %s\n", config.posixTz);
+    } else if (config.tzMode == TzMode::FIXED) {
         Serial.printf("Fixed Offset: %d:%02d (useEuDst=%s)\n",
                       config.timeZoneOffsetHrs, config.timeZoneOffsetMin, config.useEuDst ? "true" : "false");
     } else {
         Serial.printf("EU DST: %s (CET/CEST)\n", config.useEuDst ? "true" : "false");
     }
-    Serial.printf("Resync every : %d min\n", config.ntpResyncEveryMinutes);
+    Serial.printf("Resync every : %d..%d min (adaptive)\n",
+                  config.ntpResyncEveryMinutes, config.ntpResyncMaxMinutes);
+    Serial.printf("Web: cache=%d KB, max-age=%ds, max clients=%d\n",
+                  config.webCacheKb, config.staticMaxAgeSec, config.webMaxClients);
+    Serial.printf("Log retention: %d days, cap=%d KB, %s; event log: %s\n", config.logRetentionDays,
+                  config.logMaxTotalKb, config.logArchive ? "archive monthly" : "delete",
+                  config.eventLog ? "binary" : "text");
+    Serial.printf("Power: mode=%s (model %d/%d/%d mA active/idle/sleep)\n", powerModeName(config.powerMode),
+                  config.powerActiveMa, config.powerIdleMa, config.powerSleepMa);
+    if (config.fleetMode != FleetMode::OFF) {
+        Serial.printf("Fleet: mode=%s, group=%s:%d, priority=%d, name=%s\n", fleetModeName(config.fleetMode),
+                      config.fleetGroup, config.fleetPort, config.fleetPriority,
+                      config.fleetName[0] ? config.fleetName : "(mac)");
+    } else {
+        Serial.println(F("Fleet: off"));
+    }
     Serial.printf("Impulse: interval=%ds, delay=%dms\n", config.impulseIntervalSec, config.impulseDelayMs);
+    Serial.printf("Pulse: backend=%s, width=%dus, dead-time=%dus\n",
+                  pulseTimingName(config.pulseBackend), config.pulseWidthUs, config.pulseDeadTimeUs);
     Serial.printf("Resync RTC if diff: %ds\n", config.resyncRtcIfDiffSeconds);
     Serial.printf("Max catch-up: %d min\n", config.maxCatchupMinutes);
+    Serial.printf("Channels: %d (max concurrent drives %d)\n",
+                  config.channelCount, config.maxConcurrentDrives);
+    for (int i = 0; i < config.channelCount; i++) {
+        const ChannelConfig& ch = config.channels[i];
+        Serial.printf("  [%s] pins=%d/%d, width=%dus, dead-time=%dus, catch-up (%s): %d→%d ms, ramp %d, slowdown %d\n",
+                      ch.name, ch.pinIn1, ch.pinIn2, ch.pulseWidthUs, ch.pulseDeadTimeUs,
+                      ch.clockType, ch.catchup.startIntervalMs, ch.catchup.minIntervalMs,
+                      ch.catchup.rampPulses, ch.catchup.slowdownPulses);
+        if (ch.feedback == FeedbackMode::CURRENT) {
+            Serial.printf("  [%s] feedback=current, pin=%d, threshold=%d\n", ch.name, ch.feedbackPin, ch.feedbackThreshold);
+        } else if (ch.feedback == FeedbackMode::SENSOR) {
+            Serial.printf("  [%s] feedback=sensor, pin=%d\n", ch.name, ch.feedbackPin);
+        }
+    }
     Serial.printf("WebEdit: %s, DebugSerial: %s\n",
                   config.webEditEnabled ? "true" : "false",
                   config.debugSerial ? "true" : "false");
     Serial.println(F("-----------------------"));
-
-    return true;
 }
 
 /**
@@ -157,22 +400,27 @@ bool ConfigManager::loadFromFile(const char* path) {
  *  - Impulse timing: 60s interval, 500ms delay
  *  - Catch-up cap: 180 minutes
  *  - Periodic NTP re-sync: 15 minutes
+ *  - Pulse backend: loop, 500ms width, 150ms dead-time
+ *  - Catch-up: clock_type "generic" (see applyDefaultCatchUpProfile())
+ *  - Channels: one ("main") on the default pins, one coil energized at a time
+ *  - Step feedback: off (open loop)
+ *  - Fleet: off (239.255.42.99:4210, priority 100 once enabled)
  */
 void ConfigManager::applyDefaults() {
     // WiFi & NTP
-    config.wifiSsid   = "";
-    config.wifiPassword = "";
-    config.ntpServer  = "pool.ntp.org";
+    config.wifiSsid[0]     = '\0';
+    config.wifiPassword[0] = '\0';
+    strlcpy(config.ntpServer, "pool.ntp.org", sizeof(config.ntpServer));
 
     // TZ default: EU mode (CET/CEST)
-    config.tz_mode           = "eu";
-    config.posix_tz          = "";
+    config.tzMode            = TzMode::EU;
+    config.posixTz[0]        = '\0';
     config.timeZoneOffsetHrs = 0;
     config.timeZoneOffsetMin = 0;
     config.useEuDst          = true;
 
     // App
-    config.mode                   = "auto";
+    config.mode                   = ClockMode::AUTO;
     config.impulseIntervalSec     = 60;
     config.impulseDelayMs         = 500;
     config.resyncRtcIfDiffSeconds = 60;
@@ -180,6 +428,109 @@ void ConfigManager::applyDefaults() {
     config.webEditEnabled         = false;
     config.debugSerial            = false;
     config.ntpResyncEveryMinutes  = 15;
+    config.ntpResyncMaxMinutes    = 720;
+
+    // Web static assets
+    config.webCacheKb             = 48;
+    config.staticMaxAgeSec        = 300;
+    config.webMaxClients          = 4;
+
+    // Log retention
+    config.logRetentionDays       = 60;
+    config.logMaxTotalKb          = 0;
+    config.logArchive             = true;
+    config.eventLog               = true;
+
+    // Power
+    config.powerMode              = PowerMode::NORMAL;
+    config.powerActiveMa          = 80;
+    config.powerIdleMa            = 40;
+    config.powerSleepMa           = 4;
+
+    // Fleet
+    config.fleetMode              = FleetMode::OFF;
+    strlcpy(config.fleetGroup, "239.255.42.99", sizeof(config.fleetGroup));
+    config.fleetPort              = 4210;
+    config.fleetPriority          = 100;
+    config.fleetName[0]           = '\0';
+
+    // Pulse waveform
+    config.pulseBackend           = PulseTiming::LOOP;
+    config.pulseWidthUs           = config.impulseDelayMs * 1000;
+    config.pulseDeadTimeUs        = 150000;
+
+    // Catch-up
+    strlcpy(config.clockType, "generic", sizeof(config.clockType));
+    applyDefaultCatchUpProfile(config.catchup, config.pulseWidthUs, config.pulseDeadTimeUs);
+
+    // Step feedback
+    config.feedback               = FeedbackMode::OFF;
+    config.feedbackPin            = -1;
+    config.feedbackThreshold      = 400;
+
+    // Channels
+    applyDefaultChannels();
+    config.maxConcurrentDrives    = 1;
+}
+
+/**
+ * @brief One channel ("main") on the firmware's default pins with the
+ *        top-level waveform and catch-up profile.
+ */
+void ConfigManager::applyDefaultChannels() {
+    ChannelConfig& ch = config.channels[0];
+    strlcpy(ch.name, "main", sizeof(ch.name));
+    ch.pinIn1          = -1;
+    ch.pinIn2          = -1;
+    ch.pulseWidthUs    = config.pulseWidthUs;
+    ch.pulseDeadTimeUs = config.pulseDeadTimeUs;
+    strlcpy(ch.clockType, config.clockType, sizeof(ch.clockType));
+    ch.catchup         = config.catchup;
+    ch.feedback          = config.feedbackPin >= 0 ? config.feedback : FeedbackMode::OFF;
+    ch.feedbackPin       = config.feedbackPin;
+    ch.feedbackThreshold = config.feedbackThreshold;
+    config.channelCount = 1;
+}
+
+/**
+ * @brief Generic curve overlaid with catchup_profiles[clockType], then clamped.
+ */
+void ConfigManager::resolveCatchUpProfile(JsonVariant profiles, const char* clockType,
+                                          int widthUs, int deadUs, CatchUpProfile& out) {
+    applyDefaultCatchUpProfile(out, widthUs, deadUs);
+    JsonVariant p = profiles[clockType];
+    if (p.isNull() && strcmp(clockType, "generic") != 0) {
+        Serial.printf("⚠️ No catchup_profiles entry for '%s' — using generic.\n", clockType);
+    }
+    out.startIntervalMs = p["start_interval_ms"] | out.startIntervalMs;
+    out.minIntervalMs   = p["min_interval_ms"]   | out.minIntervalMs;
+    out.rampPulses      = p["ramp_pulses"]       | out.rampPulses;
+    out.slowdownPulses  = p["slowdown_pulses"]   | out.slowdownPulses;
+    clampCatchUpProfile(out, widthUs, deadUs);
+}
+
+/**
+ * @brief Generic curve from the waveform: starts at the legacy cadence
+ *        (cycle + gap + 50 ms), runs at cycle + 50 ms, 8-step ramp, 3-step slowdown.
+ */
+void ConfigManager::applyDefaultCatchUpProfile(CatchUpProfile& p, int widthUs, int deadUs) {
+    const int cycleMs = (widthUs + deadUs) / 1000;
+    p.startIntervalMs = 2 * cycleMs + 50;
+    p.minIntervalMs   = cycleMs + 50;
+    p.rampPulses      = 8;
+    p.slowdownPulses  = 3;
+}
+
+/**
+ * @brief A period can never be shorter than one pulse plus a 20 ms guard,
+ *        and the start period is never faster than the minimum.
+ */
+void ConfigManager::clampCatchUpProfile(CatchUpProfile& p, int widthUs, int deadUs) {
+    const int floorMs = (widthUs + deadUs) / 1000 + 20;
+    if (p.minIntervalMs   < floorMs)         p.minIntervalMs   = floorMs;
+    if (p.startIntervalMs < p.minIntervalMs) p.startIntervalMs = p.minIntervalMs;
+    if (p.rampPulses      < 0)               p.rampPulses      = 0;
+    if (p.slowdownPulses  < 0)               p.slowdownPulses  = 0;
 }
 
 /**
@@ -189,3 +540,22 @@ void ConfigManager::applyDefaults() {
 const Config& ConfigManager::getConfig() const {
     return config;
 }
+
+const char* ConfigManager::modeName(ClockMode m)       { return m == ClockMode::AUTO ? "auto" : "manual"; }
+const char* ConfigManager::tzModeName(TzMode m)        { return m == TzMode::POSIX ? "posix" : m == TzMode::FIXED ? "fixed" : "eu"; }
+const char* ConfigManager::pulseTimingName(PulseTiming t) { return t == PulseTiming::ESP_TIMER ? "esp_timer" : "loop"; }
+const char* ConfigManager::powerModeName(PowerMode m)  { return m == PowerMode::LOW_POWER ? "low" : "normal"; }
+const char* ConfigManager::fleetModeName(FleetMode m) {
+    return m == FleetMode::AUTO ? "auto" : m == FleetMode::LEADER ? "leader" : m == FleetMode::FOLLOWER ? "follower" : "off";
+}
+const char* ConfigManager::feedbackModeName(FeedbackMode m) {
+    return m == FeedbackMode::CURRENT ? "current" : m == FeedbackMode::SENSOR ? "sensor" : "off";
+}
+
+FeedbackMode ConfigManager::parseFeedbackMode(const char* value) {
+    const String m = toLowerTrim(String(value));
+    if (m == "current") return FeedbackMode::CURRENT;
+    if (m == "sensor")  return FeedbackMode::SENSOR;
+    if (m != "off") Serial.printf("⚠️ Unknown feedback \"%s\" — open loop.\n", m.c_str());
+    return FeedbackMode::OFF;
+}
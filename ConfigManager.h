@@ -3,11 +3,16 @@
  * @brief   Configuration model and loader for the Pragotron controller.
  *
  * Usage:
+ *   SD.begin(SD_CS);                 // the caller mounts the card
  *   ConfigManager cfg;
  *   if (!cfg.begin("/config.json")) {
  *       // Defaults applied; proceed in degraded mode if necessary.
  *   }
  *   const Config& c = cfg.getConfig();
+ *
+ * The JSON is validated once into a plain struct (enums, fixed char arrays)
+ * and cached in NVS with the CRC32 of the file: while /config.json is
+ * unchanged, boot restores the snapshot instead of parsing it.
  */
 
 #pragma once
@@ -16,25 +21,80 @@
 #include <ArduinoJson.h>
 #include <SD.h>
 
+/**
+ * @struct CatchUpProfile
+ * @brief  Catch-up speed curve for one movement type (all periods start-to-start).
+ *
+ * period(i) ramps linearly from startIntervalMs to minIntervalMs over the
+ * first rampPulses steps and back up to startIntervalMs over the last
+ * slowdownPulses steps.
+ */
+struct CatchUpProfile {
+    int startIntervalMs;    ///< Period of the first (and last) pulse.
+    int minIntervalMs;      ///< Fastest reliable period for the movement.
+    int rampPulses;         ///< Steps to accelerate from start to min.
+    int slowdownPulses;     ///< Final steps stretched back towards start.
+};
+
+/// Upper bound on slave-clock lines driven by one controller.
+static constexpr int MAX_CHANNELS = 4;
+
+/// `mode`: AUTO keeps time from NTP, MANUAL from the RTC only (any value but "auto").
+enum class ClockMode : uint8_t { AUTO, MANUAL };
+
+/// `tz_mode`: CET/CEST rules, a POSIX TZ string, or a fixed offset.
+enum class TzMode : uint8_t { EU, POSIX, FIXED };
+
+/// `pulse_backend`: loop-polled edges or hardware-timed esp_timer edges.
+enum class PulseTiming : uint8_t { LOOP, ESP_TIMER };
+
+/// `power_mode`: always on, or light sleep between events with Wi-Fi modem sleep.
+enum class PowerMode : uint8_t { NORMAL, LOW_POWER };
+
+/// `fleet_mode`: standalone, elected role, or a fixed leader/follower role.
+enum class FleetMode : uint8_t { OFF, AUTO, LEADER, FOLLOWER };
+
+/// `feedback`: open loop, coil current on an ADC pin, or a dial position sensor on a GPIO.
+enum class FeedbackMode : uint8_t { OFF, CURRENT, SENSOR };
+
+/**
+ * @struct ChannelConfig
+ * @brief  One slave-clock line: bridge pins, waveform, catch-up curve and step feedback.
+ */
+struct ChannelConfig {
+    char           name[16];        ///< Label used in logs and /api/status.
+    int            pinIn1;          ///< Bridge IN1 GPIO (-1 → firmware default, channel 0 only).
+    int            pinIn2;          ///< Bridge IN2 GPIO (-1 → firmware default, channel 0 only).
+    int            pulseWidthUs;    ///< Drive time per pulse (µs).
+    int            pulseDeadTimeUs; ///< Coast/dead-time after each pulse (µs).
+    char           clockType[24];   ///< Movement type; selects catchup_profiles[clock_type].
+    CatchUpProfile catchup;         ///< Resolved profile for clockType.
+    FeedbackMode   feedback;        ///< Step verification (OFF when no pin is known).
+    int            feedbackPin;     ///< ADC (current) or GPIO (sensor) input, -1 = none.
+    int            feedbackThreshold; ///< CURRENT: minimum ADC reading late in the drive.
+};
+
 /**
  * @struct Config
  * @brief  In-memory configuration snapshot parsed from JSON (or defaults).
+ *
+ * Trivially copyable on purpose: it is stored byte-for-byte in NVS.
  */
 struct Config {
     // ── WiFi & NTP ────────────────────────────────────────────────────────────
-    String wifiSsid;        ///< Wi-Fi SSID (may be empty when offline usage).
-    String wifiPassword;    ///< Wi-Fi password (not printed to logs).
-    String ntpServer;       ///< NTP server hostname (e.g., "pool.ntp.org").
+    char   wifiSsid[33];     ///< Wi-Fi SSID (may be empty when offline usage).
+    char   wifiPassword[65]; ///< Wi-Fi password (not printed to logs).
+    char   ntpServer[64];    ///< NTP server hostname (e.g., "pool.ntp.org").
 
     // ── Timezone configuration ────────────────────────────────────────────────
-    String tz_mode;         ///< "posix" | "eu" | "fixed"
-    String posix_tz;        ///< POSIX TZ string if tz_mode=="posix".
-    int    timeZoneOffsetHrs; ///< Hours offset for tz_mode=="fixed".
-    int    timeZoneOffsetMin; ///< Minutes (0..59) for tz_mode=="fixed".
-    bool   useEuDst;        ///< If true and tz_mode=="eu", use CET/CEST rules.
+    TzMode tzMode;          ///< tz_mode: "posix" | "eu" | "fixed"
+    char   posixTz[64];     ///< POSIX TZ string if tzMode == POSIX.
+    int    timeZoneOffsetHrs; ///< Hours offset for tzMode == FIXED.
+    int    timeZoneOffsetMin; ///< Minutes (0..59) for tzMode == FIXED.
+    bool   useEuDst;        ///< If true, CET/CEST rules apply unless tzMode == POSIX.
 
     // ── Application behavior ─────────────────────────────────────────────────
-    String mode;                 ///< Operating mode, e.g., "auto".
+    ClockMode mode;              ///< Operating mode ("auto" | "manual").
     int    impulseIntervalSec;   ///< Impulse interval (seconds) for minute ticks.
     int    impulseDelayMs;       ///< Inter-pulse delay (milliseconds).
     int    resyncRtcIfDiffSeconds; ///< NTP resync if RTC differs by ≥ this (s).
@@ -43,7 +103,51 @@ struct Config {
     bool   debugSerial;          ///< Verbose serial logging toggle.
 
     // ── Periodic NTP re-sync ─────────────────────────────────────────────────
-    int    ntpResyncEveryMinutes; ///< Auto NTP sync cadence (min), min 1.
+    int    ntpResyncEveryMinutes; ///< Auto NTP sync cadence (min), min 1; shortest adaptive poll.
+    int    ntpResyncMaxMinutes;   ///< Longest adaptive poll once the RTC drift model predicts well.
+
+    // ── Pulse waveform ───────────────────────────────────────────────────────
+    PulseTiming pulseBackend;    ///< "loop" (service() polling) | "esp_timer" (hardware-timed).
+    int    pulseWidthUs;         ///< Drive time per pulse (µs); defaults to impulseDelayMs*1000.
+    int    pulseDeadTimeUs;      ///< Coast/dead-time after each pulse (µs).
+
+    // ── Catch-up ─────────────────────────────────────────────────────────────
+    char           clockType[24]; ///< Movement type; selects catchup_profiles[clock_type].
+    CatchUpProfile catchup;      ///< Resolved profile for clockType.
+
+    // ── Step feedback (channels inherit; only channels[0] inherits the pin) ──
+    FeedbackMode feedback;       ///< "off" | "current" | "sensor".
+    int    feedbackPin;          ///< Input for channel 0 (-1 = none).
+    int    feedbackThreshold;    ///< CURRENT: ADC counts (0..4095) that mean "coil driven".
+
+    // ── Channels ─────────────────────────────────────────────────────────────
+    ChannelConfig  channels[MAX_CHANNELS]; ///< channels[0] defaults to the settings above.
+    int            channelCount;           ///< 1..MAX_CHANNELS.
+    int            maxConcurrentDrives;    ///< Power budget: coils energized at the same time.
+
+    // ── Web static assets ────────────────────────────────────────────────────
+    int    webCacheKb;           ///< RAM/PSRAM budget for static files cached at boot (0 = off).
+    int    staticMaxAgeSec;      ///< Cache-Control max-age for static files (ETag revalidates).
+    int    webMaxClients;        ///< Concurrent requests on the async web backend (503 beyond).
+
+    // ── Log retention ────────────────────────────────────────────────────────
+    int    logRetentionDays;     ///< Daily logs older than this are archived/deleted (0 = keep).
+    int    logMaxTotalKb;        ///< Cap for /logs incl. archives; oldest go first (0 = no cap).
+    bool   logArchive;           ///< true: fold old days into /logs/archive/YYYY-MM.txt; false: delete.
+    bool   eventLog;             ///< Pulses/catch-up steps to binary /logs/YYYY-MM-DD.evl instead of text.
+
+    // ── Power ────────────────────────────────────────────────────────────────
+    PowerMode powerMode;         ///< "normal" | "low" (light sleep between events, Wi-Fi modem sleep).
+    int    powerActiveMa;        ///< Current estimate while a task runs (mA).
+    int    powerIdleMa;          ///< Current estimate while idle without light sleep (mA).
+    int    powerSleepMa;         ///< Current estimate in light sleep incl. modem-sleep DTIM wakes (mA).
+
+    // ── Fleet (UDP multicast time sharing) ───────────────────────────────────
+    FleetMode fleetMode;         ///< "off" | "auto" | "leader" | "follower".
+    char   fleetGroup[16];       ///< IPv4 multicast group, e.g. "239.255.42.99".
+    int    fleetPort;            ///< UDP port of the group.
+    int    fleetPriority;        ///< Election rank 0..255, lower wins (ties: lower node id).
+    char   fleetName[16];        ///< Label on the leader dashboard (empty → from the MAC).
 };
 
 /**
@@ -51,13 +155,15 @@ struct Config {
  * @brief Loads configuration from SD JSON and exposes it to the system.
  *
  * Contract:
- *  - `begin()` must be called before `getConfig()`.
+ *  - SD must already be mounted; `begin()` must be called before `getConfig()`.
  *  - On any load failure, safe defaults are applied and `begin()` returns false.
+ *  - A successful parse is cached in NVS (namespace "config"); it is used only
+ *    while the file's size and CRC32 match what it was built from.
  */
 class ConfigManager {
 public:
     /**
-     * @brief Initialize the configuration system and load JSON from SD.
+     * @brief Load the configuration: NVS snapshot if the JSON is unchanged, else parse it.
      * @param path Path to the JSON file (default: "/config.json").
      * @return true on successful load; false if defaults were applied.
      */
@@ -69,17 +175,76 @@ public:
      */
     const Config& getConfig() const;
 
+    /// JSON spelling of the enum values (logs, /api/status).
+    static const char* modeName(ClockMode m);
+    static const char* tzModeName(TzMode m);
+    static const char* pulseTimingName(PulseTiming t);
+    static const char* powerModeName(PowerMode m);
+    static const char* fleetModeName(FleetMode m);
+    static const char* feedbackModeName(FeedbackMode m);
+
 private:
-    Config config;
+    Config config = {};
+
+    /**
+     * @struct SnapshotHeader
+     * @brief Prefix of the NVS blob; the Config bytes follow.
+     */
+    struct SnapshotHeader {
+        uint32_t magic;         ///< SNAPSHOT_MAGIC.
+        uint16_t version;       ///< SNAPSHOT_VERSION (bump when parsing rules change).
+        uint16_t configSize;    ///< sizeof(Config) when written (layout guard).
+        uint32_t jsonSize;      ///< Size of the JSON it was parsed from.
+        uint32_t jsonCrc;       ///< CRC32 of that JSON.
+    };
+    static constexpr uint32_t SNAPSHOT_MAGIC   = 0x31474643;   // "CFG1"
+    static constexpr uint16_t SNAPSHOT_VERSION = 3;
+
+    // Parse buffer: keys and strings are copied out of the file stream, plus
+    // one 16-byte slot per member. The full schema (4 channels, feedback,
+    // catch-up profiles) needs about 3.5 KB; larger files scale with their size.
+    static constexpr size_t JSON_DOC_MIN = 4096;
+    static constexpr size_t JSON_DOC_MAX = 16384;
 
-    /// @brief Open, parse, and map JSON fields into @ref config.
-    bool loadFromFile(const char* path);
+    /// @brief Parse and map JSON fields into @ref config.
+    bool parseJson(File& file);
+
+    /// @brief CRC32 and size of the whole file (leaves it at EOF).
+    static void checksumFile(File& file, uint32_t& crc, uint32_t& size);
+
+    /// @brief Restore @ref config from NVS if it was built from this JSON.
+    bool loadSnapshot(uint32_t jsonSize, uint32_t jsonCrc);
+
+    /// @brief Store @ref config in NVS together with the JSON's size and CRC.
+    void saveSnapshot(uint32_t jsonSize, uint32_t jsonCrc);
+
+    /// @brief Short summary to Serial (useful for field debugging).
+    void printSummary() const;
 
     /// @brief Fill @ref config with safe defaults.
     void applyDefaults();
 
+    /// @brief Built-in "generic" profile derived from a pulse waveform.
+    static void applyDefaultCatchUpProfile(CatchUpProfile& p, int widthUs, int deadUs);
+
+    /// @brief Keep the profile physically possible for the given waveform.
+    static void clampCatchUpProfile(CatchUpProfile& p, int widthUs, int deadUs);
+
+    /// @brief Resolve catchup_profiles[clockType] over the generic curve.
+    static void resolveCatchUpProfile(JsonVariant profiles, const char* clockType,
+                                      int widthUs, int deadUs, CatchUpProfile& out);
+
+    /// @brief Channel 0 from the top-level settings (the single-line setup).
+    void applyDefaultChannels();
+
+    /// @brief `feedback` value → enum; unknown spellings warn and give OFF.
+    static FeedbackMode parseFeedbackMode(const char* value);
+
+    /// @brief strlcpy() into a fixed field, warning if @p key's value was cut.
+    static void copyField(char* dst, size_t size, const char* src, const char* key);
+
     /**
-     * @brief Helper: trim and lowercase a String (used for tz_mode).
+     * @brief Helper: trim and lowercase a String (used for enum keys and clock_type).
      * @param s Input string (copied).
      * @return Normalized string (trimmed, to lower case).
      */
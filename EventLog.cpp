@@ -0,0 +1,214 @@
+/**
+ * @file    EventLog.cpp
+ * @brief   Binary event log: ring buffer, per-day files, text/JSON decoding.
+ */
+
+#include "EventLog.h"
+#include "TimeSource.h"
+#include "NetWake.h"
+#include <esp_system.h>
+
+constexpr uint8_t EventLog::MAGIC[4];
+EventLog* EventLog::shutdownLog = nullptr;
+
+/**
+ * @brief Start recording into @p logDir; buffered records are flushed on esp_restart().
+ */
+bool EventLog::begin(const char* logDir, LogIndex* index) {
+    strlcpy(dir, logDir, sizeof(dir));
+    logIndex    = index;
+    lastFlushMs = millis();
+    shutdownLog = this;
+    esp_register_shutdown_handler(&EventLog::onShutdown);
+    started     = true;
+    return true;
+}
+
+void EventLog::onShutdown() {
+    if (shutdownLog) shutdownLog->flush();
+}
+
+void EventLog::record(EvlType type, uint8_t channel, uint16_t a, int32_t b) {
+    if (!started) return;
+    if (!TimeSource::isValid()) return;   // would land in a 0000-00-00 file retention never sees
+
+    EventRecord r;
+    r.time    = (uint32_t)time(nullptr);
+    r.type    = (uint8_t)type;
+    r.channel = channel;
+    r.a       = a;
+    r.b       = b;
+
+    bool   stored = false;
+    size_t used   = 0;
+    portENTER_CRITICAL(&lock);
+    const size_t next = (head + 1) % RING_RECORDS;
+    if (next != tail) {
+        ring[head] = r;
+        head       = next;
+        stored     = true;
+    }
+    used = (head + RING_RECORDS - tail) % RING_RECORDS;
+    portEXIT_CRITICAL(&lock);
+    if (!stored) dropped++;
+    if (used >= FLUSH_THRESHOLD) NetWake::notify();
+}
+
+void EventLog::service() {
+    if (!started) return;
+    const size_t used = (head + RING_RECORDS - tail) % RING_RECORDS;
+    if (used == 0) return;
+    if (used >= FLUSH_THRESHOLD || (uint32_t)(millis() - lastFlushMs) >= FLUSH_INTERVAL_MS) flush();
+}
+
+/**
+ * @brief Write [tail, head) grouped into runs of the same file.
+ */
+void EventLog::flush() {
+    if (!started) return;
+    lastFlushMs = millis();
+
+    const size_t h = head;
+    size_t t = tail;
+    while (t != h) {
+        char date[11];
+        localDate(ring[t].time, date);
+        const bool ok = openFor(date);
+
+        // Longest run that is contiguous in the ring and has the same date
+        const size_t limit = (h > t ? h : RING_RECORDS) - t;
+        size_t n = 1;
+        for (char d[11]; n < limit; n++) {
+            localDate(ring[t + n].time, d);
+            if (strcmp(d, date) != 0) break;
+        }
+        if (ok) {
+            file.write((const uint8_t*)&ring[t], n * sizeof(EventRecord));
+            if (logIndex) logIndex->update(strrchr(filePath, '/') + 1, (uint32_t)file.size());
+        }
+        t = (t + n) % RING_RECORDS;
+    }
+    if (file) file.flush();
+    tail = h;   // on open failure the batch is discarded, like Logger
+}
+
+bool EventLog::openFor(const char* date) {
+    char path[40];
+    pathFor(date, path, sizeof(path));
+    if (file && strcmp(path, filePath) == 0) return true;
+
+    if (file) file.close();
+    file = SD.open(path, FILE_APPEND);
+    if (!file) { filePath[0] = '\0'; return false; }
+    strlcpy(filePath, path, sizeof(filePath));
+    if (file.size() == 0) file.write(MAGIC, sizeof(MAGIC));
+    return true;
+}
+
+void EventLog::pathFor(const char* date, char* out, size_t size) const {
+    snprintf(out, size, "%s/%s.evl", dir, date);
+}
+
+void EventLog::localDate(uint32_t utc, char out[11]) {
+    if (utc == 0) { strcpy(out, "0000-00-00"); return; }
+    const time_t t = (time_t)utc;
+    tm lt;
+    localtime_r(&t, &lt);
+    strftime(out, 11, "%Y-%m-%d", &lt);
+}
+
+void EventLog::localStamp(uint32_t utc, char out[20]) {
+    if (utc == 0) { strcpy(out, "0000-00-00 00:00:00"); return; }
+    const time_t t = (time_t)utc;
+    tm lt;
+    localtime_r(&t, &lt);
+    strftime(out, 20, "%Y-%m-%d %H:%M:%S", &lt);
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Decoding
+// ──────────────────────────────────────────────────────────────────────────────
+
+namespace {
+const char* const TYPE_NAMES[] = {
+    nullptr, "pulse", "catchup_start", "catchup_step", "catchup_end", "hold_start", "hold_end",
+    "pulse_missed"
+};
+constexpr size_t TYPE_COUNT = sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]);
+}
+
+const char* EventLog::typeName(uint8_t type) {
+    return (type > 0 && type < TYPE_COUNT) ? TYPE_NAMES[type] : "unknown";
+}
+
+bool EventLog::typeFromName(const char* name, uint8_t& type) {
+    for (size_t i = 1; i < TYPE_COUNT; i++) {
+        if (strcmp(name, TYPE_NAMES[i]) == 0) { type = (uint8_t)i; return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief One line in the style of the text log.
+ */
+int EventLog::formatText(const EventRecord& r, char* out, size_t size) {
+    char ts[20];
+    localStamp(r.time, ts);
+    const int n = snprintf(out, size, "[%s] [EVT] [ch%u] ", ts, (unsigned)r.channel);
+    if (n < 0 || (size_t)n >= size) return n;
+    char* p = out + n;
+    const size_t left = size - (size_t)n;
+
+    int m;
+    switch ((EvlType)r.type) {
+        case EvlType::PULSE:
+            m = snprintf(p, left, "🕒 Pulse for %02u:%02u (+%ld.%ld ms)", r.a / 60, r.a % 60,
+                         (long)(r.b / 1000), (long)(r.b % 1000 / 100));
+            break;
+        case EvlType::CATCHUP_START:
+            m = snprintf(p, left, "⚙️ Catch-up start: %u pulses, ETA %ld ms", r.a, (long)r.b);
+            break;
+        case EvlType::CATCHUP_STEP:
+            m = snprintf(p, left, "📌 Catch-up remaining: %u (dial %02ld:%02ld)", r.a,
+                         (long)(r.b / 60), (long)(r.b % 60));
+            break;
+        case EvlType::CATCHUP_END:
+            m = snprintf(p, left, "✅ Catch-up finished: %u pulses in %ld ms", r.a, (long)r.b);
+            break;
+        case EvlType::HOLD_START:
+            m = snprintf(p, left, "⏸️ Hold: dial %u min ahead, ~%ld ms", r.a, (long)r.b);
+            break;
+        case EvlType::HOLD_END:
+            m = snprintf(p, left, "▶️ Hold finished at %02u:%02u", r.a / 60, r.a % 60);
+            break;
+        case EvlType::PULSE_MISSED:
+            m = snprintf(p, left, "⚠️ Step missed at %02u:%02u (feedback %ld)", r.a / 60, r.a % 60, (long)r.b);
+            break;
+        default:
+            m = snprintf(p, left, "type %u a=%u b=%ld", (unsigned)r.type, r.a, (long)r.b);
+            break;
+    }
+    return m < 0 ? m : n + m;
+}
+
+/**
+ * @brief One JSON object with argument names per type.
+ */
+int EventLog::formatJson(const EventRecord& r, char* out, size_t size) {
+    char ts[20];
+    localStamp(r.time, ts);
+    const char* ka = "a";
+    const char* kb = "b";
+    switch ((EvlType)r.type) {
+        case EvlType::PULSE:         ka = "clock_minutes"; kb = "edge_offset_us"; break;
+        case EvlType::CATCHUP_START: ka = "pulses";        kb = "eta_ms";         break;
+        case EvlType::CATCHUP_STEP:  ka = "remaining";     kb = "clock_minutes";  break;
+        case EvlType::CATCHUP_END:   ka = "pulses";        kb = "elapsed_ms";     break;
+        case EvlType::HOLD_START:    ka = "ahead_minutes"; kb = "eta_ms";         break;
+        case EvlType::HOLD_END:      ka = "clock_minutes"; kb = "b";              break;
+        case EvlType::PULSE_MISSED:  ka = "clock_minutes"; kb = "feedback";       break;
+        default: break;
+    }
+    return snprintf(out, size, "{\"t\":\"%s\",\"type\":\"%s\",\"channel\":%u,\"%s\":%u,\"%s\":%ld}",
+                    ts, typeName(r.type), (unsigned)r.channel, ka, (unsigned)r.a, kb, (long)r.b);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file    EventLog.h
+ * @brief   Compact binary log of high-volume clock events (per-day *.evl files).
+ *
+ * Minute pulses and catch-up steps make up most of the text log. They are
+ * recorded here as 12-byte EventRecords instead of ~60-byte text lines and
+ * decoded to text/JSON only when /api/eventlog asks for them.
+ *
+ * File layout: "/logs/YYYY-MM-DD.evl" (local date of the record), a 4-byte
+ * magic "PEV1" when the file is created, then packed EventRecords. A file
+ * can be appended across reboots; records are never rewritten.
+ *
+ * Like Logger's deferred mode, record() only copies into a RAM ring (safe
+ * from any task, never waits for SD); service() on the I/O task writes
+ * batches — at half a ring or every FLUSH_INTERVAL_MS, so a power cut loses
+ * at most a few minutes of records (the shutdown hook covers reboots).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include "LogIndex.h"
+
+/**
+ * @enum EvlType
+ * @brief Record type and the meaning of its arguments.
+ */
+enum class EvlType : uint8_t {
+    PULSE         = 1,   ///< a = dial minutes after the pulse, b = edge offset (µs after :00).
+    CATCHUP_START = 2,   ///< a = planned pulses, b = ETA (ms).
+    CATCHUP_STEP  = 3,   ///< a = pulses remaining, b = dial minutes after the step.
+    CATCHUP_END   = 4,   ///< a = pulses done, b = elapsed (ms).
+    HOLD_START    = 5,   ///< a = minutes the dial is ahead, b = ETA (ms).
+    HOLD_END      = 6,   ///< a = dial minutes, b = 0.
+    PULSE_MISSED  = 7    ///< a = dial minutes (step retried), b = feedback reading.
+};
+
+/**
+ * @struct EventRecord
+ * @brief One binary event (12 bytes on SD).
+ */
+struct __attribute__((packed)) EventRecord {
+    uint32_t time;      ///< UTC epoch seconds (always a set clock; see record()).
+    uint8_t  type;      ///< EvlType.
+    uint8_t  channel;
+    uint16_t a;
+    int32_t  b;
+};
+static_assert(sizeof(EventRecord) == 12, "EventRecord must stay 12 bytes (file format)");
+
+/**
+ * @class EventLog
+ * @brief RAM ring + batched per-day binary files.
+ */
+class EventLog {
+public:
+    static constexpr uint8_t MAGIC[4] = { 'P', 'E', 'V', '1' };
+
+    /// Select the directory (shared with Logger's daily files); file sizes go to @p index.
+    bool begin(const char* dir = "/logs", LogIndex* index = nullptr);
+
+    /// Queue one record; drops it while the clock is not set (no date file to
+    /// put it in), and drops and counts it if the ring is full.
+    void record(EvlType type, uint8_t channel, uint16_t a, int32_t b);
+
+    /// Write a batch when the ring is half full or FLUSH_INTERVAL_MS passed (I/O task).
+    void service();
+
+    /// Write everything buffered now.
+    void flush();
+
+    uint32_t droppedCount() const { return dropped; }
+
+    /// "/logs/YYYY-MM-DD.evl" for a local date string "YYYY-MM-DD".
+    void pathFor(const char* date, char* out, size_t size) const;
+
+    // Decoding (web layer)
+    static const char* typeName(uint8_t type);
+    static bool        typeFromName(const char* name, uint8_t& type);
+    static int         formatText(const EventRecord& r, char* out, size_t size);
+    static int         formatJson(const EventRecord& r, char* out, size_t size);
+
+private:
+    static constexpr size_t   RING_RECORDS      = 128;
+    static constexpr size_t   FLUSH_THRESHOLD   = RING_RECORDS / 2;
+    static constexpr uint32_t FLUSH_INTERVAL_MS = 5UL * 60UL * 1000UL;   ///< ~5 pulses per SD append.
+
+    char              dir[24] = "/logs";
+    LogIndex*         logIndex = nullptr;  ///< Logger's index (retention counts *.evl from it).
+    EventRecord       ring[RING_RECORDS];
+    volatile size_t   head = 0;          ///< Producers, under lock.
+    volatile size_t   tail = 0;          ///< Flusher only.
+    portMUX_TYPE      lock = portMUX_INITIALIZER_UNLOCKED;
+    volatile uint32_t dropped = 0;
+    uint32_t          lastFlushMs = 0;
+    bool              started = false;
+
+    File  file;
+    char  filePath[40] = "";
+
+    bool  openFor(const char* date);     ///< Open/rotate to the file of a local date.
+    static EventLog* shutdownLog;                  ///< Target of the esp_restart() hook.
+    static void onShutdown();
+    static void localDate(uint32_t utc, char out[11]);
+    static void localStamp(uint32_t utc, char out[20]);
+};
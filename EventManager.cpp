@@ -0,0 +1,64 @@
+/**
+ * @file    EventManager.cpp
+ * @brief   FreeRTOS-queue backed event feed for Server-Sent Events.
+ *
+ * Notes
+ * -----
+ * - Records are copied into the queue by value (no heap per event).
+ * - Ids are assigned under a spinlock so they are unique across tasks; a
+ *   gap in the ids a client sees means events were dropped.
+ */
+
+#include "EventManager.h"
+#include "NetWake.h"
+
+bool EventManager::begin(size_t depth) {
+    if (queue) return true;
+    queue = xQueueCreate(depth, sizeof(StreamEvent));
+    return queue != nullptr;
+}
+
+bool EventManager::publish(EventType type, const char* data) {
+    if (!active()) return false;
+
+    StreamEvent ev;
+    ev.type = type;
+    strlcpy(ev.data, data, sizeof(ev.data));
+
+    portENTER_CRITICAL(&idLock);
+    ev.id = nextId++;
+    portEXIT_CRITICAL(&idLock);
+
+    if (xQueueSend(queue, &ev, 0) != pdTRUE) {
+        dropped++;
+        return false;
+    }
+    NetWake::notify();   // live feed: push now, not at the next poll
+    return true;
+}
+
+bool EventManager::publishf(EventType type, const char* fmt, ...) {
+    if (!active()) return false;
+
+    char buf[StreamEvent::DATA_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return publish(type, buf);
+}
+
+bool EventManager::next(StreamEvent& out) {
+    return queue && xQueueReceive(queue, &out, 0) == pdTRUE;
+}
+
+const char* EventManager::typeName(EventType type) {
+    switch (type) {
+        case EventType::LOG:     return "log";
+        case EventType::PULSE:   return "pulse";
+        case EventType::CATCHUP: return "catchup";
+        case EventType::NTP:     return "ntp";
+        case EventType::PLAN:    return "plan";
+        default:                 return "message";
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * @file    EventManager.h
+ * @brief   Live event feed (log lines, pulses, catch-up, NTP) for /api/events.
+ *
+ * Producers (Logger, SystemManager) publish small text/JSON records from any
+ * task; nothing blocks and nothing touches the network there. The web server
+ * drains the queue on the network task and pushes each record to the
+ * connected Server-Sent-Events clients. While nobody is subscribed,
+ * publishers skip formatting altogether (active()).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+/**
+ * @enum EventType
+ * @brief SSE "event:" name of a record (see EventManager::typeName()).
+ */
+enum class EventType : uint8_t {
+    LOG,        ///< data: one formatted log line (plain text).
+    PULSE,      ///< data: JSON, regular minute pulse of one channel.
+    CATCHUP,    ///< data: JSON, catch-up/hold progress of one channel.
+    NTP,        ///< data: JSON, outcome of an NTP sync.
+    PLAN        ///< data: JSON, the engine's answer to a manual set (same fields as /api/set-state).
+};
+
+/**
+ * @struct StreamEvent
+ * @brief One queued record; id increases by one per published event.
+ */
+struct StreamEvent {
+    static constexpr size_t DATA_MAX = 232;   ///< Fits a full Logger entry.
+    uint32_t  id;
+    EventType type;
+    char      data[DATA_MAX];
+};
+
+/**
+ * @class EventManager
+ * @brief Bounded multi-producer / single-consumer event queue.
+ */
+class EventManager {
+public:
+    /// Create the queue; events published before begin() are ignored.
+    bool begin(size_t depth = QUEUE_DEPTH);
+
+    /// True while at least one client is subscribed (set by the consumer).
+    bool active() const { return subscribed && queue != nullptr; }
+    void setActive(bool on) { subscribed = on; }
+
+    /// Queue one record; never blocks. false (and counted) if the queue is full.
+    bool publish(EventType type, const char* data);
+    bool publishf(EventType type, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    /// Consumer side (network task): pop the next record, false if none.
+    bool next(StreamEvent& out);
+
+    /// Events lost to a full queue since boot.
+    uint32_t droppedCount() const { return dropped; }
+
+    static const char* typeName(EventType type);
+
+private:
+    static constexpr size_t QUEUE_DEPTH = 16;
+
+    QueueHandle_t     queue      = nullptr;
+    volatile bool     subscribed = false;
+    volatile uint32_t nextId     = 1;
+    volatile uint32_t dropped    = 0;
+    portMUX_TYPE      idLock     = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,373 @@
+/**
+ * @file    FleetManager.cpp
+ * @brief   Fleet mode over UDP multicast: election, time beacons, status reports.
+ *
+ * Notes
+ * -----
+ * - Only the leader talks to NTP; followers stop SNTP while locked
+ *   (SystemManager::setFleetFollower()) and fall back to it once the leader
+ *   has been silent for LEADER_TIMEOUT_MS.
+ * - A beacon carries the leader's system clock read right before sending.
+ *   Receive delay (Wi-Fi, DTIM buffering of multicast, the network task's poll)
+ *   only ever makes the sample (leader − local) smaller, so the largest sample
+ *   of a window is the least delayed one and is what gets applied.
+ * - Beacons go out half-way between minute edges, so a follower's steps never
+ *   land right on a tick.
+ * - Multicast is best effort: lost beacons only delay the next step, lost
+ *   reports only age a dashboard row.
+ */
+
+#include "FleetManager.h"
+#include "TimeSource.h"
+#include "Metrics.h"
+#include <WiFi.h>
+#include <stdlib.h> // llabs
+
+FleetManager::FleetManager(ConfigManager* config, Logger* logger, SystemManager* system)
+    : configManager(config), logger(logger), system(system) {}
+
+/**
+ * @brief Read fleet_* from config and the node identity from the eFuse MAC.
+ */
+void FleetManager::begin() {
+    const auto& cfg = configManager->getConfig();
+    mode    = cfg.fleetMode;
+    selfId  = ESP.getEfuseMac();
+    startMs = millis();
+    if (cfg.fleetName[0]) strlcpy(selfName, cfg.fleetName, sizeof(selfName));
+    else snprintf(selfName, sizeof(selfName), "node-%06lx", (unsigned long)((selfId >> 24) & 0xFFFFFF));
+    lastStatusMs = startMs - (uint32_t)(selfId % STATUS_EVERY_MS);   // spread reports across nodes
+
+    if (mode == FleetMode::OFF) return;
+    if (!group.fromString(cfg.fleetGroup)) {
+        logger->errorf("❌ Fleet: bad fleet_group \"%s\" — fleet off.", cfg.fleetGroup);
+        mode = FleetMode::OFF;
+        return;
+    }
+    logger->infof("🛰️ Fleet: %s as \"%s\" (priority %d), group %s:%d",
+                  ConfigManager::fleetModeName(mode), selfName, cfg.fleetPriority,
+                  cfg.fleetGroup, cfg.fleetPort);
+}
+
+/**
+ * @brief Network task step; a few packets in, election, at most one packet out.
+ */
+void FleetManager::service() {
+    if (mode == FleetMode::OFF) return;
+    if (!ensureSocket()) return;
+
+    receive();
+    const uint32_t nowMs = millis();
+    updateRole(nowMs);
+
+    if (role == FleetRole::LEADER) {
+        const int64_t nowUs  = TimeSource::epochUs();
+        const int64_t periodUs = (int64_t)BEACON_EVERY_S * 1000000LL;
+        const int64_t slot   = nowUs / periodUs;
+        if (slot != lastBeaconSlot && nowUs % periodUs >= BEACON_PHASE_US) {
+            lastBeaconSlot = slot;
+            send(MsgType::BEACON);
+            Metrics::count(Metric::FLEET_BEACONS_SENT);
+        }
+        return;
+    }
+
+    // Reports only matter while someone is listening
+    if (leaderId == 0 || (uint32_t)(nowMs - leaderSeenMs) >= LEADER_TIMEOUT_MS) return;
+    if ((uint32_t)(nowMs - lastStatusMs) < STATUS_EVERY_MS) return;
+    lastStatusMs = nowMs;
+    send(MsgType::STATUS);
+}
+
+/**
+ * @brief Until the leader's next beacon, or the follower's next receive
+ *        window / status report; UINT32_MAX while the fleet is idle.
+ */
+uint32_t FleetManager::idleWaitMs() const {
+    if (mode == FleetMode::OFF || !socketOpen) return UINT32_MAX;
+
+    const int64_t periodUs = (int64_t)BEACON_EVERY_S * 1000000LL;
+    const int64_t nowUs    = TimeSource::epochUs();
+    const int64_t slot     = nowUs / periodUs;
+    const int64_t intoUs   = nowUs % periodUs;
+
+    if (role == FleetRole::LEADER) {
+        if (slot != lastBeaconSlot && intoUs >= BEACON_PHASE_US) return 0;
+        const int64_t untilUs = intoUs < BEACON_PHASE_US ? BEACON_PHASE_US - intoUs
+                                                         : periodUs - intoUs + BEACON_PHASE_US;
+        return (uint32_t)((untilUs + 999) / 1000);
+    }
+
+    uint32_t wait = UINT32_MAX;
+    if (role == FleetRole::FOLLOWER) {
+        const int64_t openUs  = BEACON_PHASE_US - RX_GUARD_US;
+        const int64_t closeUs = BEACON_PHASE_US + RX_WINDOW_US;
+        if (intoUs >= openUs && intoUs < closeUs && slot != lastRxSlot) return RX_POLL_MS;
+        const int64_t untilUs = intoUs < openUs ? openUs - intoUs : periodUs - intoUs + openUs;
+        wait = (uint32_t)(untilUs / 1000);
+    }
+    const uint32_t nowMs = millis();
+    if (leaderId != 0 && (uint32_t)(nowMs - leaderSeenMs) < LEADER_TIMEOUT_MS) {
+        const uint32_t since = nowMs - lastStatusMs;
+        wait = min(wait, since >= STATUS_EVERY_MS ? 0 : STATUS_EVERY_MS - since);
+    }
+    return wait;
+}
+
+/**
+ * @brief Join the group once the station has an IP; drop the socket with the link.
+ */
+bool FleetManager::ensureSocket() {
+    if (WiFi.status() != WL_CONNECTED) {
+        if (socketOpen) {
+            udp.stop();
+            socketOpen = false;
+        }
+        return false;
+    }
+    if (socketOpen) return true;
+
+    const auto& cfg = configManager->getConfig();
+    socketOpen = udp.beginMulticast(group, (uint16_t)cfg.fleetPort);
+    if (!socketOpen) logger->warn("⚠️ Fleet: joining the multicast group failed.");
+    return socketOpen;
+}
+
+/**
+ * @brief Drain up to RX_PER_RUN datagrams; the receive time is taken first.
+ */
+void FleetManager::receive() {
+    for (int i = 0; i < RX_PER_RUN; i++) {
+        const int len = udp.parsePacket();
+        if (len <= 0) return;
+        const int64_t rxUs = TimeSource::epochUs();
+
+        Packet p;
+        if (len != (int)sizeof(p)) continue;   // other traffic / version; next parsePacket() drops it
+        if (udp.read((uint8_t*)&p, sizeof(p)) != (int)sizeof(p)) continue;
+        if (p.magic != MAGIC || p.nodeId == selfId) continue;   // our own multicast loops back
+
+        if (p.type == (uint8_t)MsgType::BEACON)      onBeacon(p, rxUs);
+        else if (p.type == (uint8_t)MsgType::STATUS) onStatus(p, (uint32_t)udp.remoteIP());
+    }
+}
+
+/**
+ * @brief Track the best-ranked synced beacon sender; feed its clock to the filter.
+ */
+void FleetManager::onBeacon(const Packet& p, int64_t rxUs) {
+    if (!(p.flags & FLAG_SYNCED)) return;   // nothing to follow yet
+    const uint32_t nowMs = millis();
+
+    if (p.nodeId != leaderId) {
+        const bool stale = leaderId == 0 || (uint32_t)(nowMs - leaderSeenMs) >= LEADER_TIMEOUT_MS;
+        if (!stale && !ranksBefore(p.priority, p.nodeId, leaderPriority, leaderId)) return;
+        leaderId       = p.nodeId;
+        leaderPriority = p.priority;
+        filterCount    = 0;
+        logger->infof("🛰️ Fleet: leader is \"%.*s\" (priority %u)",
+                      (int)sizeof(p.name), p.name, (unsigned)p.priority);
+    }
+    leaderSeenMs = nowMs;
+
+    if (role != FleetRole::FOLLOWER) return;
+    Metrics::count(Metric::FLEET_BEACONS_RECEIVED);
+    lastRxSlot = rxUs / ((int64_t)BEACON_EVERY_S * 1000000LL);
+    trackOffset(p.epochUs - rxUs);
+}
+
+/**
+ * @brief Leader: store a follower's report in the node table.
+ *
+ * A new node takes a free or expired row, else the one silent the longest.
+ */
+void FleetManager::onStatus(const Packet& p, uint32_t ip) {
+    if (role != FleetRole::LEADER) return;
+    const uint32_t nowMs = millis();
+
+    portENTER_CRITICAL(&mux);
+    int slot = -1;
+    for (int i = 0; i < nodeCount; i++) {
+        if (nodes[i].st.nodeId == p.nodeId) { slot = i; break; }
+    }
+    if (slot < 0) {
+        if (nodeCount < FLEET_MAX_NODES - 1) {
+            slot = nodeCount++;
+        } else {
+            slot = 0;
+            for (int i = 1; i < nodeCount; i++) {
+                if ((uint32_t)(nowMs - nodes[i].seenMs) > (uint32_t)(nowMs - nodes[slot].seenMs)) slot = i;
+            }
+        }
+    }
+    FleetNodeStatus& st = nodes[slot].st;
+    st.nodeId       = p.nodeId;
+    memcpy(st.name, p.name, sizeof(st.name));
+    st.name[sizeof(st.name) - 1] = '\0';
+    st.ip           = ip;
+    st.role         = (FleetRole)p.role;
+    st.priority     = p.priority;
+    st.synced       = (p.flags & FLAG_SYNCED) != 0;
+    st.offsetUs     = p.offsetUs;
+    st.channelCount = p.channelCount > MAX_CHANNELS ? MAX_CHANNELS : p.channelCount;
+    memcpy(st.ch, p.ch, sizeof(st.ch));
+    nodes[slot].seenMs = nowMs;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Election (see class brief); forced modes only decide between
+ *        their role and standalone.
+ */
+void FleetManager::updateRole(uint32_t nowMs) {
+    const bool leaderHeard = leaderId != 0 && (uint32_t)(nowMs - leaderSeenMs) < LEADER_TIMEOUT_MS;
+    const uint8_t prio = (uint8_t)configManager->getConfig().fleetPriority;
+
+    FleetRole want;
+    if (mode == FleetMode::LEADER) {
+        want = FleetRole::LEADER;
+    } else if (mode == FleetMode::FOLLOWER) {
+        want = leaderHeard ? FleetRole::FOLLOWER : FleetRole::STANDALONE;
+    } else if (leaderHeard && ranksBefore(leaderPriority, leaderId, prio, selfId)) {
+        want = FleetRole::FOLLOWER;
+    } else if (eligible() && (uint32_t)(nowMs - startMs) >= LEADER_TIMEOUT_MS) {
+        want = FleetRole::LEADER;      // listened for a full timeout after boot first
+    } else {
+        want = leaderHeard ? FleetRole::FOLLOWER : FleetRole::STANDALONE;
+    }
+    setRole(want);
+}
+
+/**
+ * @brief Switch role; the follower lock follows the FOLLOWER role.
+ */
+void FleetManager::setRole(FleetRole r) {
+    if (r == role) return;
+    const FleetRole was = role;
+    role = r;
+    logger->infof("🛰️ Fleet: %s → %s", roleName(was), roleName(r));
+
+    filterCount = 0;
+    if (r == FleetRole::LEADER) {
+        lastBeaconSlot = -1;
+        portENTER_CRITICAL(&mux);
+        nodeCount = 0;
+        portEXIT_CRITICAL(&mux);
+    }
+    system->setFleetFollower(r == FleetRole::FOLLOWER);
+}
+
+/**
+ * @brief One beacon sample (leader − local, µs); step the clock per window.
+ *
+ * Gross errors (fresh boot from a drifted RTC, leader change) are applied at
+ * once; otherwise the clock moves by the window's largest sample when that
+ * exceeds STEP_MIN_US.
+ */
+void FleetManager::trackOffset(int64_t sampleUs) {
+    if (llabs((long long)sampleUs) >= COARSE_US) {
+        logger->infof("🛰️ Fleet: clock off by %.3f s — stepping to the leader.", sampleUs / 1e6);
+        lastOffsetUs = sampleUs > INT32_MAX ? INT32_MAX : sampleUs < INT32_MIN ? INT32_MIN : (int32_t)sampleUs;
+        system->applyFleetOffset(sampleUs);
+        filterCount = 0;
+        return;
+    }
+
+    if (filterCount == 0 || sampleUs > filterMaxUs) filterMaxUs = sampleUs;
+    if (++filterCount < FILTER_SAMPLES) return;
+    filterCount  = 0;
+    lastOffsetUs = (int32_t)filterMaxUs;
+    Metrics::setGauge(Gauge::FLEET_OFFSET_MS, filterMaxUs / 1000.0f);
+
+    if (llabs((long long)filterMaxUs) <= STEP_MIN_US) return;
+    logger->tracef("🛰️ Fleet: stepping %+.1f ms to the leader.", filterMaxUs / 1000.0f);
+    system->applyFleetOffset(filterMaxUs);
+}
+
+/**
+ * @brief Multicast one beacon or status report; the clock is read last.
+ */
+void FleetManager::send(MsgType type) {
+    FleetNodeStatus self;
+    fillSelf(self);
+
+    Packet p = {};
+    p.magic        = MAGIC;
+    p.type         = (uint8_t)type;
+    p.role         = (uint8_t)self.role;
+    p.priority     = self.priority;
+    p.flags        = self.synced ? FLAG_SYNCED : 0;
+    p.nodeId       = selfId;
+    p.offsetUs     = self.offsetUs;
+    memcpy(p.name, self.name, sizeof(p.name));
+    p.channelCount = self.channelCount;
+    memcpy(p.ch, self.ch, sizeof(p.ch));
+
+    if (!udp.beginMulticastPacket()) return;
+    p.epochUs = TimeSource::epochUs();
+    udp.write((const uint8_t*)&p, sizeof(p));
+    udp.endPacket();
+}
+
+/**
+ * @brief This node's own dashboard row (role, lock, dials).
+ */
+void FleetManager::fillSelf(FleetNodeStatus& st) const {
+    st.nodeId   = selfId;
+    strlcpy(st.name, selfName, sizeof(st.name));
+    st.ip       = (uint32_t)WiFi.localIP();
+    st.role     = role;
+    st.priority = (uint8_t)configManager->getConfig().fleetPriority;
+    st.synced   = role == FleetRole::LEADER ? system->timeSynced() : role == FleetRole::FOLLOWER;
+    st.offsetUs = role == FleetRole::FOLLOWER ? lastOffsetUs : 0;
+    st.ageMs    = 0;
+
+    CatchUpStatus cu;
+    int n = 0;
+    for (; n < MAX_CHANNELS && system->catchUpStatus(n, cu); n++) {
+        FleetChannelStatus& c = st.ch[n];
+        c.clockMinutes = (int16_t)cu.clockMinutes;
+        c.edgeOffsetUs = cu.edgeOffsetUs;
+        c.remaining    = (uint16_t)(cu.remaining > 0xFFFF ? 0xFFFF : cu.remaining);
+        c.flags        = (cu.active ? FLEET_CH_CATCHUP : 0) | (cu.holding ? FLEET_CH_HOLD : 0);
+    }
+    st.channelCount = (uint8_t)n;
+}
+
+bool FleetManager::eligible() const {
+    return configManager->getConfig().mode == ClockMode::AUTO && system->timeSynced();
+}
+
+/**
+ * @brief Role, leader and (leader only) self + live node rows.
+ *
+ * Scalar fields are read without the lock and may be one update apart.
+ */
+void FleetManager::snapshot(FleetSnapshot& out) const {
+    const uint32_t nowMs = millis();
+    out.mode        = mode;
+    out.role        = role;
+    out.selfId      = selfId;
+    out.leaderId    = role == FleetRole::LEADER ? selfId : leaderId;
+    out.leaderAgeMs = role == FleetRole::LEADER ? 0 : (uint32_t)(nowMs - leaderSeenMs);
+    out.offsetUs    = lastOffsetUs;
+    out.nodeCount   = 0;
+    if (mode == FleetMode::OFF) return;
+
+    fillSelf(out.nodes[out.nodeCount++]);
+    if (role != FleetRole::LEADER) return;
+
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < nodeCount && out.nodeCount < FLEET_MAX_NODES; i++) {
+        const uint32_t age = nowMs - nodes[i].seenMs;
+        if (age >= NODE_EXPIRE_MS) continue;
+        out.nodes[out.nodeCount] = nodes[i].st;
+        out.nodes[out.nodeCount].ageMs = age;
+        out.nodeCount++;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+const char* FleetManager::roleName(FleetRole r) {
+    return r == FleetRole::LEADER ? "leader" : r == FleetRole::FOLLOWER ? "follower" : "standalone";
+}
@@ -0,0 +1,207 @@
+/**
+ * @file    FleetManager.h
+ * @brief   Fleet mode: one elected leader shares its NTP time over UDP multicast.
+ *
+ * Usage:
+ *   FleetManager fleet(&config, &logger, systemManager);
+ *   fleet.begin();
+ *   ...
+ *   fleet.service();          // network task
+ *   FleetSnapshot s; fleet.snapshot(s);   // /api/fleet
+ *
+ * Roles: the leader syncs with NTP as usual and multicasts a time beacon
+ * every BEACON_EVERY_S seconds, half-way between minute edges. Followers pause
+ * their own NTP, step their system clock to the leader's (max-filtered over a
+ * window of beacons to drop Wi-Fi delay) and so tick on the leader's minute
+ * edge; they report their dials to the leader every STATUS_EVERY_MS.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <freertos/FreeRTOS.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+#include "SystemManager.h"
+
+/// Largest node table kept by the leader (self included).
+static constexpr int FLEET_MAX_NODES = 32;
+
+/**
+ * @enum FleetRole
+ * @brief What this node currently does in the fleet.
+ */
+enum class FleetRole : uint8_t {
+    STANDALONE,   ///< Fleet off, or no leader heard and not eligible to lead.
+    LEADER,       ///< Beacons its time; collects status reports.
+    FOLLOWER      ///< Clock locked to the leader's beacons.
+};
+
+static constexpr uint8_t FLEET_CH_CATCHUP = 0x01;   ///< FleetChannelStatus::flags
+static constexpr uint8_t FLEET_CH_HOLD    = 0x02;
+
+/**
+ * @struct FleetChannelStatus
+ * @brief One clock line as reported over the wire (packed, little-endian).
+ */
+struct __attribute__((packed)) FleetChannelStatus {
+    int16_t  clockMinutes;   ///< Dial position (0..1439), -1 unknown.
+    int32_t  edgeOffsetUs;   ///< Last minute pulse start after :00, -1 before the first tick.
+    uint16_t remaining;      ///< Catch-up pulses left.
+    uint8_t  flags;          ///< FLEET_CH_CATCHUP | FLEET_CH_HOLD.
+};
+
+/**
+ * @struct FleetNodeStatus
+ * @brief One row of the leader dashboard.
+ */
+struct FleetNodeStatus {
+    uint64_t  nodeId       = 0;     ///< eFuse MAC.
+    char      name[16]     = "";
+    uint32_t  ip           = 0;
+    FleetRole role         = FleetRole::STANDALONE;
+    uint8_t   priority     = 0;
+    bool      synced       = false; ///< Leader: NTP-synced. Follower: locked to the leader.
+    int32_t   offsetUs     = 0;     ///< Follower's last filtered offset to the leader.
+    uint32_t  ageMs        = 0;     ///< Since the last report.
+    uint8_t   channelCount = 0;
+    FleetChannelStatus ch[MAX_CHANNELS] = {};
+};
+
+/**
+ * @struct FleetSnapshot
+ * @brief Fleet state for /api/fleet; the node table is filled on the leader only.
+ */
+struct FleetSnapshot {
+    FleetMode mode        = FleetMode::OFF;
+    FleetRole role        = FleetRole::STANDALONE;
+    uint64_t  selfId      = 0;
+    uint64_t  leaderId    = 0;      ///< 0 = no leader heard.
+    uint32_t  leaderAgeMs = 0;      ///< Since its last beacon.
+    int32_t   offsetUs    = 0;      ///< Follower: last filtered offset to the leader.
+    int       nodeCount   = 0;
+    FleetNodeStatus nodes[FLEET_MAX_NODES];  ///< Self first, then reporting followers.
+};
+
+/**
+ * @class FleetManager
+ * @brief Leader election, time beacons and status reports over one multicast group.
+ *
+ * Election (fleet_mode "auto"): a node may lead once it has synced with NTP
+ * (AUTO mode). The best-ranked beaconing node — lowest fleet_priority, then
+ * lowest node id — wins; a worse leader steps down when it hears a better
+ * one, and a leader is presumed gone after LEADER_TIMEOUT_MS without beacons.
+ * "leader" and "follower" pin the role.
+ *
+ * Runs entirely on the network task; snapshot() may be called from any task.
+ */
+class FleetManager {
+public:
+    FleetManager(ConfigManager* config, Logger* logger, SystemManager* system);
+
+    /// Read the fleet_* settings; the socket opens once the station has an IP.
+    void begin();
+
+    /// Receive beacons/reports, run the election, send what is due (network task).
+    void service();
+
+    /// Longest the network task may sleep before service() has work (ms).
+    uint32_t idleWaitMs() const;
+
+    /// Current role and, on the leader, the node table (any task).
+    void snapshot(FleetSnapshot& out) const;
+
+    static const char* roleName(FleetRole r);
+
+private:
+    // Wire format: one packet type for beacons and status reports
+    static constexpr uint32_t MAGIC = 0x314C4650;     // "PFL1"
+    enum class MsgType : uint8_t { BEACON = 1, STATUS = 2 };
+    static constexpr uint8_t FLAG_SYNCED = 0x01;      ///< See FleetNodeStatus::synced.
+    struct __attribute__((packed)) Packet {
+        uint32_t magic;
+        uint8_t  type;           ///< MsgType.
+        uint8_t  role;           ///< Sender's FleetRole.
+        uint8_t  priority;
+        uint8_t  flags;
+        uint64_t nodeId;
+        int64_t  epochUs;        ///< Sender's system clock right before sending.
+        int32_t  offsetUs;       ///< STATUS: last filtered offset to the leader.
+        char     name[16];
+        uint8_t  channelCount;
+        FleetChannelStatus ch[MAX_CHANNELS];
+    };
+
+    // Timing
+    static constexpr int      BEACON_EVERY_S    = 10;       ///< Beacons at :05, :15 … :55.
+    static constexpr int64_t  BEACON_PHASE_US   = 5000000;  ///< Away from the minute edge.
+    static constexpr uint32_t LEADER_TIMEOUT_MS = 35000;    ///< Three beacons missed + slack.
+    static constexpr uint32_t STATUS_EVERY_MS   = 30000;
+    static constexpr uint32_t NODE_EXPIRE_MS    = 120000;   ///< Dashboard row dropped after.
+    static constexpr int      RX_PER_RUN        = 8;        ///< Bound the work per service().
+
+    // Follower receive window: a beacon is timestamped when service() drains
+    // the socket, so the network task polls closely around the beacon phase
+    // (modem sleep holds multicast until the next DTIM) and sleeps otherwise.
+    static constexpr uint32_t RX_POLL_MS   = 10;
+    static constexpr int64_t  RX_GUARD_US  = 50000;         ///< Window opens before the phase.
+    static constexpr int64_t  RX_WINDOW_US = 500000;        ///< … and closes after it.
+
+    // Follower clock lock
+    static constexpr int      FILTER_SAMPLES = 6;           ///< One minute of beacons.
+    static constexpr int64_t  STEP_MIN_US    = 2000;        ///< Smaller offsets are left alone.
+    static constexpr int64_t  COARSE_US      = 1000000;     ///< Applied at once, no filtering.
+
+    ConfigManager* configManager;
+    Logger*        logger;
+    SystemManager* system;
+
+    WiFiUDP   udp;
+    IPAddress group;
+    bool      socketOpen = false;
+    FleetMode mode       = FleetMode::OFF;
+    FleetRole role       = FleetRole::STANDALONE;
+    uint64_t  selfId     = 0;
+    char      selfName[16] = "";
+    uint32_t  startMs    = 0;
+
+    // Best-ranked beacon sender heard recently
+    uint64_t  leaderId       = 0;
+    uint8_t   leaderPriority = 0;
+    uint32_t  leaderSeenMs   = 0;
+
+    // Offset filter: max of (leader − local) over FILTER_SAMPLES beacons
+    int       filterCount  = 0;
+    int64_t   filterMaxUs  = 0;
+    int32_t   lastOffsetUs = 0;
+
+    int64_t   lastBeaconSlot = -1;
+    int64_t   lastRxSlot     = -1;    ///< Follower: beacon slot already received.
+    uint32_t  lastStatusMs   = 0;
+
+    // Leader's node table (followers' reports)
+    struct Node {
+        FleetNodeStatus st;
+        uint32_t        seenMs = 0;
+    };
+    Node      nodes[FLEET_MAX_NODES - 1];
+    int       nodeCount = 0;
+    mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    bool ensureSocket();
+    void receive();
+    void onBeacon(const Packet& p, int64_t rxUs);
+    void onStatus(const Packet& p, uint32_t ip);
+    void updateRole(uint32_t nowMs);
+    void setRole(FleetRole r);
+    void trackOffset(int64_t sampleUs);
+    void send(MsgType type);
+    void fillSelf(FleetNodeStatus& st) const;
+    bool eligible() const;             ///< May lead: AUTO mode and NTP-synced.
+
+    /// (priority, id) ordering of the election; true if a wins over b.
+    static bool ranksBefore(uint8_t pa, uint64_t a, uint8_t pb, uint64_t b) {
+        return pa != pb ? pa < pb : a < b;
+    }
+};
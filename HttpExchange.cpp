@@ -0,0 +1,147 @@
+/**
+ * @file    HttpExchange.cpp
+ * @brief   Backend adapters: AsyncWebServerRequest (WEB_ASYNC=1) or WebServer.
+ */
+
+#include "HttpExchange.h"
+
+#if WEB_ASYNC
+
+String AsyncHttpExchange::uri() { return req->url(); }
+
+bool AsyncHttpExchange::hasArg(const char* name) {
+    return req->hasParam(name) || req->hasParam(name, /*post=*/true);
+}
+
+String AsyncHttpExchange::arg(const char* name) {
+    if (req->hasParam(name))       return req->getParam(name)->value();
+    if (req->hasParam(name, true)) return req->getParam(name, true)->value();
+    return String();
+}
+
+String AsyncHttpExchange::body() {
+    return req->_tempObject ? String((const char*)req->_tempObject) : String();
+}
+
+String AsyncHttpExchange::header(const char* name) {
+    return req->hasHeader(name) ? req->getHeader(name)->value() : String();
+}
+
+void AsyncHttpExchange::sendHeader(const char* name, const String& value) {
+    if (headerCount >= MAX_HEADERS) return;
+    headerNames[headerCount]  = name;
+    headerValues[headerCount] = value;
+    headerCount++;
+}
+
+void AsyncHttpExchange::finish(AsyncWebServerResponse* response) {
+    for (size_t i = 0; i < headerCount; i++) response->addHeader(headerNames[i], headerValues[i]);
+    req->send(response);
+}
+
+void AsyncHttpExchange::send(int code, const char* type, const String& content) {
+    finish(req->beginResponse(code, type, content));
+}
+
+/**
+ * @brief Send a RAM buffer without copying; it must outlive the response (cache entries do).
+ */
+void AsyncHttpExchange::send(int code, const char* type, const uint8_t* data, size_t len) {
+    finish(req->beginResponse_P(code, type, data, len));
+}
+
+void AsyncHttpExchange::sendEmpty(int code) {
+    finish(req->beginResponse(code));
+}
+
+/**
+ * @brief Chunked response that reads the file as the socket drains.
+ *
+ * The File handle is captured by the filler, so it stays open until the
+ * response is destroyed (sent or client gone) and a slow client only holds
+ * its own connection.
+ */
+void AsyncHttpExchange::streamFile(File& file, const char* type) {
+    const bool gz = String(file.name()).endsWith(".gz");
+    File f = file;
+    AsyncWebServerResponse* r = req->beginChunkedResponse(type,
+        [f](uint8_t* buf, size_t maxLen, size_t /*index*/) mutable -> size_t {
+            return f.read(buf, maxLen);
+        });
+    if (gz) r->addHeader("Content-Encoding", "gzip");
+    finish(r);
+}
+
+/**
+ * @brief Fixed-length response read from the file's current position on demand.
+ */
+void AsyncHttpExchange::streamFileRange(File& file, const char* type, int code, size_t length) {
+    File f = file;
+    size_t left = length;
+    AsyncWebServerResponse* r = req->beginResponse(type, length,
+        [f, left](uint8_t* buf, size_t maxLen, size_t /*index*/) mutable -> size_t {
+            const size_t n = f.read(buf, maxLen < left ? maxLen : left);
+            left -= n;
+            return n;
+        });
+    r->setCode(code);
+    finish(r);
+}
+
+void AsyncHttpExchange::sendChunked(int code, const char* type, ChunkFiller filler) {
+    AsyncWebServerResponse* r = req->beginChunkedResponse(type,
+        [filler](uint8_t* buf, size_t maxLen, size_t /*index*/) -> size_t { return filler(buf, maxLen); });
+    r->setCode(code);
+    finish(r);
+}
+
+/**
+ * @brief Accumulate a request body into a NUL-terminated buffer in _tempObject
+ *        (freed by the request); bodies over @p maxLen are dropped.
+ */
+void AsyncHttpExchange::collectBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                                    size_t index, size_t total, size_t maxLen) {
+    if (total > maxLen) return;
+    if (index == 0) {
+        request->_tempObject = malloc(total + 1);
+        if (!request->_tempObject) return;
+        ((char*)request->_tempObject)[total] = '\0';
+    }
+    if (!request->_tempObject) return;
+    memcpy((uint8_t*)request->_tempObject + index, data, len);
+}
+
+#else
+
+/**
+ * @brief Send a byte range of @p file through WebServer's content API.
+ */
+void SyncHttpExchange::streamFileRange(File& file, const char* type, int code, size_t length) {
+    srv.setContentLength(length);
+    srv.send(code, type, "");
+
+    char buf[1024];
+    while (length > 0) {
+        const size_t n = file.read((uint8_t*)buf, length < sizeof(buf) ? length : sizeof(buf));
+        if (n == 0) break;
+        srv.sendContent(buf, n);
+        length -= n;
+    }
+    file.close();
+}
+
+/**
+ * @brief Chunked transfer: the filler runs to completion inside the handler.
+ */
+void SyncHttpExchange::sendChunked(int code, const char* type, ChunkFiller filler) {
+    srv.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    srv.send(code, type, "");
+
+    uint8_t buf[512];
+    for (size_t n; (n = filler(buf, sizeof(buf))) > 0;) {
+        srv.sendContent((const char*)buf, n);
+    }
+    srv.sendContent("");   // terminating chunk
+}
+
+#endif
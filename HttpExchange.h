@@ -0,0 +1,134 @@
+/**
+ * @file    HttpExchange.h
+ * @brief   One request/response pair, independent of the HTTP server backend.
+ *
+ * WebServerManager's route handlers talk to HttpExchange only, so the same
+ * handlers run on either backend:
+ *  - WEB_ASYNC=0 (default): Arduino WebServer, polled from the network task,
+ *    one client at a time.
+ *  - WEB_ASYNC=1: ESPAsyncWebServer on AsyncTCP, event-driven, concurrent
+ *    clients; file bodies are sent as chunked responses read on demand.
+ *
+ * Build with -DWEB_ASYNC=1 and the ESPAsyncWebServer + AsyncTCP libraries.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+
+#ifndef WEB_ASYNC
+#define WEB_ASYNC 0
+#endif
+
+#if WEB_ASYNC
+#include <ESPAsyncWebServer.h>
+#else
+#include <WebServer.h>
+#endif
+
+/**
+ * @class HttpExchange
+ * @brief Backend-neutral view of the current request and its response.
+ *
+ * Headers added with sendHeader() go out with the next send*() call; each
+ * exchange sends exactly one response.
+ */
+class HttpExchange {
+public:
+    /// Body generator for sendChunked(): fill up to maxLen bytes, return 0 when done.
+    using ChunkFiller = std::function<size_t(uint8_t* buf, size_t maxLen)>;
+
+    virtual ~HttpExchange() = default;
+
+    virtual String uri() = 0;
+    virtual bool   hasArg(const char* name) = 0;        ///< Query or form parameter.
+    virtual String arg(const char* name) = 0;
+    virtual String body() = 0;                          ///< Raw request body ("" if none).
+    virtual String header(const char* name) = 0;        ///< Request header ("" if absent).
+
+    virtual void sendHeader(const char* name, const String& value) = 0;
+    virtual void send(int code, const char* type, const String& content) = 0;
+    virtual void send(int code, const char* type, const uint8_t* data, size_t len) = 0;
+    virtual void sendEmpty(int code) = 0;
+    /// Stream @p file (kept open by the exchange until sent); "*.gz" names get Content-Encoding: gzip.
+    virtual void streamFile(File& file, const char* type) = 0;
+    /// Send @p length bytes from the current position of @p file with status @p code (200/206).
+    virtual void streamFileRange(File& file, const char* type, int code, size_t length) = 0;
+    /// Chunked response produced by @p filler (may run after the handler returned).
+    virtual void sendChunked(int code, const char* type, ChunkFiller filler) = 0;
+};
+
+#if WEB_ASYNC
+
+/**
+ * @class AsyncHttpExchange
+ * @brief HttpExchange over an AsyncWebServerRequest (runs in the AsyncTCP task).
+ */
+class AsyncHttpExchange : public HttpExchange {
+public:
+    explicit AsyncHttpExchange(AsyncWebServerRequest* request) : req(request) {}
+
+    String uri() override;
+    bool   hasArg(const char* name) override;
+    String arg(const char* name) override;
+    String body() override;
+    String header(const char* name) override;
+
+    void sendHeader(const char* name, const String& value) override;
+    void send(int code, const char* type, const String& content) override;
+    void send(int code, const char* type, const uint8_t* data, size_t len) override;
+    void sendEmpty(int code) override;
+    void streamFile(File& file, const char* type) override;
+    void streamFileRange(File& file, const char* type, int code, size_t length) override;
+    void sendChunked(int code, const char* type, ChunkFiller filler) override;
+
+    /// onBody collector: keeps up to @p maxLen bytes in request->_tempObject.
+    static void collectBody(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                            size_t index, size_t total, size_t maxLen);
+
+private:
+    static constexpr size_t MAX_HEADERS = 6;
+    AsyncWebServerRequest* req;
+    String headerNames[MAX_HEADERS];
+    String headerValues[MAX_HEADERS];
+    size_t headerCount = 0;
+
+    void finish(AsyncWebServerResponse* response);      ///< Add queued headers and send.
+};
+
+#else
+
+/**
+ * @class SyncHttpExchange
+ * @brief HttpExchange over the synchronous Arduino WebServer.
+ */
+class SyncHttpExchange : public HttpExchange {
+public:
+    explicit SyncHttpExchange(WebServer& server) : srv(server) {}
+
+    String uri() override                          { return srv.uri(); }
+    bool   hasArg(const char* name) override       { return srv.hasArg(name); }
+    String arg(const char* name) override          { return srv.arg(name); }
+    String body() override                         { return srv.hasArg("plain") ? srv.arg("plain") : String(); }
+    String header(const char* name) override       { return srv.header(name); }
+
+    void sendHeader(const char* name, const String& value) override { srv.sendHeader(name, value); }
+    void send(int code, const char* type, const String& content) override { srv.send(code, type, content); }
+    void send(int code, const char* type, const uint8_t* data, size_t len) override {
+        srv.send_P(code, type, (const char*)data, len);
+    }
+    void sendEmpty(int code) override              { srv.send(code); }
+    void streamFile(File& file, const char* type) override {
+        srv.streamFile(file, type);   // adds Content-Encoding: gzip itself for *.gz
+        file.close();
+    }
+    void streamFileRange(File& file, const char* type, int code, size_t length) override;
+    void sendChunked(int code, const char* type, ChunkFiller filler) override;
+
+private:
+    WebServer& srv;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file    LogIndex.cpp
+ * @brief   In-RAM daily log index (see LogIndex.h).
+ */
+
+#include "LogIndex.h"
+#include <SD.h>
+
+/**
+ * @brief Walk @p dir once and index every "YYYY-MM-DD.txt"/".evl" with its size.
+ */
+void LogIndex::scan(const char* dir) {
+    portENTER_CRITICAL(&lock);
+    n = 0;
+    portEXIT_CRITICAL(&lock);
+
+    File d = SD.open(dir);
+    if (!d || !d.isDirectory()) return;
+
+    for (File f = d.openNextFile(); f; f = d.openNextFile()) {
+        if (!f.isDirectory()) {
+            const char* name = f.name();
+            const char* slash = strrchr(name, '/');
+            update(slash ? slash + 1 : name, (uint32_t)f.size());
+        }
+        f.close();
+    }
+    d.close();
+}
+
+void LogIndex::update(const char* name, uint32_t size) {
+    uint32_t date;
+    const bool events = !parseName(name, date);
+    if (events && !parseDay(name, ".evl", date)) return;
+
+    portENTER_CRITICAL(&lock);
+    size_t i = lowerBound(date);
+    if (i < n && entries[i].date == date) {
+        (events ? entries[i].evlSize : entries[i].size) = size;
+    } else {
+        if (n == MAX_ENTRIES) {
+            if (i == 0) { portEXIT_CRITICAL(&lock); return; }   // older than everything kept
+            memmove(&entries[0], &entries[1], (n - 1) * sizeof(LogIndexEntry));
+            n--;
+            i--;
+        }
+        memmove(&entries[i + 1], &entries[i], (n - i) * sizeof(LogIndexEntry));
+        entries[i].date    = date;
+        entries[i].size    = events ? 0 : size;
+        entries[i].evlSize = events ? size : 0;
+        n++;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void LogIndex::remove(uint32_t date) {
+    portENTER_CRITICAL(&lock);
+    const size_t i = lowerBound(date);
+    if (i < n && entries[i].date == date) {
+        memmove(&entries[i], &entries[i + 1], (n - i - 1) * sizeof(LogIndexEntry));
+        n--;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+size_t LogIndex::count() const {
+    portENTER_CRITICAL(&lock);
+    const size_t c = n;
+    portEXIT_CRITICAL(&lock);
+    return c;
+}
+
+bool LogIndex::at(size_t i, LogIndexEntry& out, bool newestFirst) const {
+    bool ok = false;
+    portENTER_CRITICAL(&lock);
+    if (i < n) {
+        out = entries[newestFirst ? n - 1 - i : i];
+        ok  = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    return ok;
+}
+
+size_t LogIndex::lowerBound(uint32_t date) const {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        if (entries[mid].date < date) lo = mid + 1;
+        else                          hi = mid;
+    }
+    return lo;
+}
+
+bool LogIndex::parseName(const char* name, uint32_t& date) {
+    return parseDay(name, ".txt", date);
+}
+
+bool LogIndex::parseDay(const char* name, const char* ext, uint32_t& date) {
+    if (strlen(name) != NAME_LEN - 1 || strcasecmp(name + 10, ext) != 0) return false;
+    for (int i = 0; i < 10; i++) {
+        if (i == 4 || i == 7) { if (name[i] != '-') return false; }
+        else if (!isdigit((unsigned char)name[i])) return false;
+    }
+    const uint32_t y = (uint32_t)atoi(name);
+    const uint32_t m = (uint32_t)atoi(name + 5);
+    const uint32_t d = (uint32_t)atoi(name + 8);
+    if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+    date = y * 10000 + m * 100 + d;
+    return true;
+}
+
+void LogIndex::formatName(uint32_t date, char out[NAME_LEN]) {
+    snprintf(out, NAME_LEN, "%04lu-%02lu-%02lu.txt",
+             (unsigned long)(date / 10000 % 10000), (unsigned long)(date / 100 % 100), (unsigned long)(date % 100));
+}
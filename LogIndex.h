@@ -0,0 +1,69 @@
+/**
+ * @file    LogIndex.h
+ * @brief   Sorted in-RAM index of the daily log files ("YYYY-MM-DD.txt" and
+ *          their binary event logs, "YYYY-MM-DD.evl").
+ *
+ * Built once from the log directory at boot, then kept current by Logger
+ * and EventLog (new file on rotation, size after each write). Readers (web handlers on
+ * any task) get consistent entries under a short spinlock and never touch
+ * the SD directory, so listing and "newest log" lookups cost the same with
+ * ten files or a few years of them.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @struct LogIndexEntry
+ * @brief One day: date as YYYYMMDD and the current sizes of its files in bytes.
+ */
+struct LogIndexEntry {
+    uint32_t date    = 0;
+    uint32_t size    = 0;   ///< Text log (0: none yet).
+    uint32_t evlSize = 0;   ///< Binary event log (0: none).
+
+    /// False for a day that so far only has an event log.
+    bool hasText() const { return size != 0 || evlSize == 0; }
+};
+
+/**
+ * @class LogIndex
+ * @brief Date-ordered (oldest first) array of LogIndexEntry, bounded.
+ *
+ * When full, the oldest entry is forgotten to make room (the file stays on SD).
+ */
+class LogIndex {
+public:
+    static constexpr size_t MAX_ENTRIES = 1024;   ///< ~2.8 years of days (12 KB).
+    static constexpr size_t NAME_LEN    = 15;     ///< "YYYY-MM-DD.txt" + NUL.
+
+    /// Rebuild from the files in @p dir (one directory walk).
+    void scan(const char* dir);
+
+    /// Insert @p name's day or update its size; names that are not "YYYY-MM-DD.txt"/".evl" are ignored.
+    void update(const char* name, uint32_t size);
+
+    /// Forget one date (file deleted/archived).
+    void remove(uint32_t date);
+
+    size_t count() const;
+
+    /// i-th entry, newest first when @p newestFirst; false past the end.
+    bool at(size_t i, LogIndexEntry& out, bool newestFirst = true) const;
+
+    bool newest(LogIndexEntry& out) const { return at(0, out, true); }
+
+    /// "YYYY-MM-DD.txt" (basename, case-insensitive extension) → YYYYMMDD.
+    static bool parseName(const char* name, uint32_t& date);
+    static void formatName(uint32_t date, char out[NAME_LEN]);
+
+private:
+    LogIndexEntry entries[MAX_ENTRIES];
+    size_t        n = 0;
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    size_t lowerBound(uint32_t date) const;      ///< First index with entries[i].date >= date (lock held).
+    static bool parseDay(const char* name, const char* ext, uint32_t& date);
+};
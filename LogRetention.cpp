@@ -0,0 +1,299 @@
+/**
+ * @file    LogRetention.cpp
+ * @brief   Incremental log retention job (see LogRetention.h).
+ *
+ * Notes
+ * -----
+ * - Works from Logger's LogIndex: the daily files, text and *.evl, and
+ *   their sizes are known without walking /logs; only the (small) archive
+ *   folder is listed.
+ * - A day is deleted only after its archive append completed; a short
+ *   write (card full) ends the pass and leaves the file in place.
+ * - Archives are plain text: a "===== YYYY-MM-DD =====" line, then the day.
+ */
+
+#include "LogRetention.h"
+#include "TimeSource.h"
+
+LogRetention::LogRetention(ConfigManager* config, Logger* logger, const char* logDir)
+    : configManager(config), logger(logger), dir(logDir) {}
+
+void LogRetention::service() {
+    const uint32_t now = millis();
+
+    if (phase == Phase::IDLE) {
+        const uint32_t wait = firstPass ? FIRST_CHECK_MS : CHECK_EVERY_MS;
+        if ((uint32_t)(now - lastPassMs) < wait) return;
+        lastPassMs = now;
+        if (!startPass()) return;
+        firstPass = false;
+    }
+
+    if ((uint32_t)(now - lastStepMs) < STEP_MS) return;
+    lastStepMs = now;
+
+    switch (phase) {
+        case Phase::AGE:  stepAge();  break;
+        case Phase::COPY: stepCopy(); break;
+        case Phase::CAP:  stepCap();  break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Compute today's date and the cutoff; false if the clock is not set yet.
+ */
+bool LogRetention::startPass() {
+    const auto& cfg = configManager->getConfig();
+    if (cfg.logRetentionDays == 0 && cfg.logMaxTotalKb == 0) return false;
+    if (!TimeSource::isValid()) return false;
+
+    const DateTime today = TimeSource::localNow();
+    todayDate  = dateKey(today);
+    cutoffDate = cfg.logRetentionDays > 0
+               ? dateKey(today - TimeSpan((int32_t)cfg.logRetentionDays * 86400L))
+               : 0;
+    scanArchives();
+    phase = Phase::AGE;
+    return true;
+}
+
+/**
+ * @brief Age out the oldest daily file if it is past the retention window.
+ */
+void LogRetention::stepAge() {
+    LogIndexEntry e;
+    if (cutoffDate == 0 || !logger->index().at(0, e, /*newestFirst=*/false) ||
+        e.date >= cutoffDate || e.date >= todayDate) {
+        phase = Phase::CAP;
+        return;
+    }
+
+    if (!configManager->getConfig().logArchive) {
+        removeDaily(e.date);
+        return;   // next step looks at the next-oldest
+    }
+
+    char path[40];
+    dailyPath(e.date, path, sizeof(path));
+    src = SD.open(path, FILE_READ);
+    if (!src) {                    // no text log (stale entry or event log only)
+        removeDaily(e.date);
+        return;
+    }
+
+    char adir[32];
+    snprintf(adir, sizeof(adir), "%s/archive", dir);
+    if (!SD.exists(adir)) SD.mkdir(adir);
+
+    char apath[48];
+    snprintf(apath, sizeof(apath), "%s/%04lu-%02lu.txt", adir,
+             (unsigned long)(e.date / 10000 % 10000), (unsigned long)(e.date / 100 % 100));
+    dst = SD.open(apath, FILE_APPEND);
+    if (!dst) {
+        logger->warnf("⚠️ Log retention: cannot open %s", apath);
+        endJob(false);
+        phase = Phase::IDLE;
+        return;
+    }
+
+    char hdr[40];
+    const int n = snprintf(hdr, sizeof(hdr), "===== %04lu-%02lu-%02lu =====\n",
+                           (unsigned long)(e.date / 10000 % 10000), (unsigned long)(e.date / 100 % 100),
+                           (unsigned long)(e.date % 100));
+    const uint32_t size = (uint32_t)dst.size();
+
+    // An interrupted copy of this day: skip what already reached the archive
+    uint32_t jd = 0, base = 0;
+    size_t   done = 0;
+    if (readJob(jd, base) && jd == e.date && base <= size) {
+        done = size - base;
+        logger->infof("🗄️ Log retention: resuming %04lu-%02lu-%02lu at %lu bytes.",
+                      (unsigned long)(e.date / 10000 % 10000), (unsigned long)(e.date / 100 % 100),
+                      (unsigned long)(e.date % 100), (unsigned long)done);
+    } else if (!writeJob(e.date, size)) {
+        logger->warn("⚠️ Log retention: cannot record the archive job — pass aborted.");
+        endJob(false);
+        phase = Phase::IDLE;
+        return;
+    }
+
+    if (done < (size_t)n) {
+        const size_t rest = (size_t)n - done;
+        if (dst.write((const uint8_t*)hdr + done, rest) != rest) {
+            logger->warn("⚠️ Log retention: archive write failed (card full?) — pass aborted.");
+            endJob(false);
+            phase = Phase::IDLE;
+            return;
+        }
+        archiveBytes += rest;
+    } else if (!src.seek(done - (size_t)n)) {
+        src.seek(src.size());   // the whole day is in; only the source is left to remove
+    }
+    jobDate = e.date;
+    phase   = Phase::COPY;
+}
+
+/**
+ * @brief Append one STEP_BYTES block of the day being archived.
+ */
+void LogRetention::stepCopy() {
+    uint8_t buf[STEP_BYTES];
+    const size_t got = src.read(buf, sizeof(buf));
+    if (got == 0) {
+        endJob(true);
+        phase = Phase::AGE;
+        return;
+    }
+    if (dst.write(buf, got) != got) {
+        logger->warn("⚠️ Log retention: archive write failed (card full?) — pass aborted.");
+        endJob(false);
+        phase = Phase::IDLE;
+        return;
+    }
+    archiveBytes += got;
+}
+
+/**
+ * @brief Close the copy job; on success drop the source day.
+ */
+void LogRetention::endJob(bool removeSource) {
+    if (dst) { dst.flush(); dst.close(); }
+    if (src) src.close();
+    if (removeSource && jobDate != 0) {
+        char name[LogIndex::NAME_LEN];
+        LogIndex::formatName(jobDate, name);
+        if (removeDaily(jobDate)) {
+            clearJob();   // only now: a cut before this resumes (and finds the day complete)
+            logger->infof("🗄️ Log retention: %s archived.", name);
+        }
+    }
+    jobDate = 0;
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Archive job record (/logs/archive/.job: "YYYYMMDD base")
+// ──────────────────────────────────────────────────────────────────────────────
+
+void LogRetention::jobPath(char* out, size_t size) const {
+    snprintf(out, size, "%s/archive/.job", dir);
+}
+
+bool LogRetention::readJob(uint32_t& date, uint32_t& base) const {
+    char path[40];
+    jobPath(path, sizeof(path));
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    char line[32] = "";
+    const size_t n = f.read((uint8_t*)line, sizeof(line) - 1);
+    f.close();
+    line[n] = '\0';
+    unsigned long d = 0, b = 0;
+    if (sscanf(line, "%lu %lu", &d, &b) != 2) return false;
+    date = (uint32_t)d;
+    base = (uint32_t)b;
+    return true;
+}
+
+bool LogRetention::writeJob(uint32_t date, uint32_t base) const {
+    char path[40];
+    jobPath(path, sizeof(path));
+    File f = SD.open(path, FILE_WRITE);
+    if (!f) return false;
+    char line[32];
+    const int n = snprintf(line, sizeof(line), "%lu %lu\n", (unsigned long)date, (unsigned long)base);
+    const bool ok = f.write((const uint8_t*)line, (size_t)n) == (size_t)n;
+    f.close();
+    return ok;
+}
+
+void LogRetention::clearJob() const {
+    char path[40];
+    jobPath(path, sizeof(path));
+    SD.remove(path);
+}
+
+/**
+ * @brief Delete one archive or daily file per step until under log_max_total_kb.
+ */
+void LogRetention::stepCap() {
+    const uint64_t cap = (uint64_t)configManager->getConfig().logMaxTotalKb * 1024ULL;
+    if (cap == 0) { phase = Phase::IDLE; return; }
+
+    const LogIndex& ix = logger->index();
+    uint64_t total = archiveBytes;
+    LogIndexEntry e;
+    for (size_t i = 0; ix.at(i, e, false); i++) total += e.size + e.evlSize;
+    if (total <= cap) { phase = Phase::IDLE; return; }
+
+    if (oldestArchive[0] != '\0') {
+        if (SD.remove(oldestArchive)) {
+            logger->infof("🗑️ Log retention: removed %s (over %d KB).",
+                          oldestArchive, configManager->getConfig().logMaxTotalKb);
+        } else {
+            logger->warnf("⚠️ Log retention: cannot remove %s", oldestArchive);
+            phase = Phase::IDLE;
+            return;
+        }
+        scanArchives();
+        return;
+    }
+
+    if (ix.at(0, e, false) && e.date < todayDate && removeDaily(e.date)) {
+        char name[LogIndex::NAME_LEN];
+        LogIndex::formatName(e.date, name);
+        logger->infof("🗑️ Log retention: removed %s (over %d KB).",
+                      name, configManager->getConfig().logMaxTotalKb);
+        return;
+    }
+    phase = Phase::IDLE;   // only today's file left
+}
+
+/**
+ * @brief Delete one day's text log and its binary event log (*.evl goes with its day).
+ */
+bool LogRetention::removeDaily(uint32_t date) {
+    char path[40];
+    dailyPath(date, path, sizeof(path));
+    bool ok = SD.remove(path) || !SD.exists(path);
+    strcpy(path + strlen(path) - 4, ".evl");
+    ok = (SD.remove(path) || !SD.exists(path)) && ok;
+    if (ok) logger->index().remove(date);
+    return ok;
+}
+
+/**
+ * @brief Sum the archive folder and remember its oldest file (names sort by month).
+ */
+void LogRetention::scanArchives() {
+    archiveBytes     = 0;
+    oldestArchive[0] = '\0';
+
+    char adir[32];
+    snprintf(adir, sizeof(adir), "%s/archive", dir);
+    File d = SD.open(adir);
+    if (!d || !d.isDirectory()) return;
+
+    char oldestName[16] = "";
+    for (File f = d.openNextFile(); f; f = d.openNextFile()) {
+        if (!f.isDirectory()) {
+            const char* name  = f.name();
+            const char* slash = strrchr(name, '/');
+            const char* base  = slash ? slash + 1 : name;
+            if (base[0] == '.') { f.close(); continue; }   // .job, not an archive
+            archiveBytes += f.size();
+            if (strlen(base) < sizeof(oldestName) && (oldestName[0] == '\0' || strcmp(base, oldestName) < 0)) {
+                strlcpy(oldestName, base, sizeof(oldestName));
+            }
+        }
+        f.close();
+    }
+    d.close();
+    if (oldestName[0] != '\0') snprintf(oldestArchive, sizeof(oldestArchive), "%s/%s", adir, oldestName);
+}
+
+void LogRetention::dailyPath(uint32_t date, char* out, size_t size) const {
+    char name[LogIndex::NAME_LEN];
+    LogIndex::formatName(date, name);
+    snprintf(out, size, "%s/%s", dir, name);
+}
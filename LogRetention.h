@@ -0,0 +1,91 @@
+/**
+ * @file    LogRetention.h
+ * @brief   Background retention for /logs: fold old days into monthly archives, cap total size.
+ *
+ * Policy (config.json):
+ *  - log_retention_days: daily files older than this leave /logs; with
+ *    log_archive they are appended to /logs/archive/YYYY-MM.txt first.
+ *  - log_max_total_kb: if daily files + archives exceed it, whole archives
+ *    are removed oldest first, then the oldest daily files (never today's).
+ *  - A day's binary event log (YYYY-MM-DD.evl) is deleted with its text log
+ *    and counts against the cap like everything else in /logs.
+ *
+ * Archiving a day is resumable: /logs/archive/.job records the day and the
+ * archive's size before its header. A pass cut short (short write, power
+ * loss) leaves the job file behind, and the next pass continues the copy
+ * from what already reached the archive instead of appending the day again
+ * (SD files cannot be truncated).
+ *
+ * The job is a small state machine driven by service() on the network
+ * task: one step (≤ STEP_BYTES copied, or one delete) per STEP_MS, and a
+ * new pass every CHECK_EVERY_MS. The clock task never
+ * waits for it, and the log directory stays a few dozen entries long.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <RTClib.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+
+class LogRetention {
+public:
+    LogRetention(ConfigManager* config, Logger* logger, const char* logDir = "/logs");
+
+    /// Run at most one step; call from the network task loop.
+    void service();
+
+    /// Longest the network task may sleep before the next step (ms).
+    uint32_t idleWaitMs() const { return phase == Phase::IDLE ? UINT32_MAX : STEP_MS; }
+
+private:
+    static constexpr uint32_t CHECK_EVERY_MS = 60UL * 60UL * 1000UL;
+    static constexpr uint32_t FIRST_CHECK_MS = 2UL * 60UL * 1000UL;  ///< After boot settles.
+    static constexpr uint32_t STEP_MS        = 20;
+    static constexpr size_t   STEP_BYTES     = 2048;
+
+    enum class Phase : uint8_t {
+        IDLE,       ///< Waiting for the next pass.
+        AGE,        ///< Pick the oldest daily file past the retention window.
+        COPY,       ///< Appending it to its monthly archive, STEP_BYTES at a time.
+        CAP         ///< Enforce log_max_total_kb.
+    };
+
+    ConfigManager* configManager;
+    Logger*        logger;
+    const char*    dir;
+
+    Phase     phase      = Phase::IDLE;
+    uint32_t  lastPassMs = 0;
+    uint32_t  lastStepMs = 0;
+    bool      firstPass  = true;
+
+    // Current pass
+    uint32_t  cutoffDate = 0;        ///< YYYYMMDD; older daily files are aged out.
+    uint32_t  todayDate  = 0;
+    uint64_t  archiveBytes = 0;      ///< Sum of /logs/archive/*.txt at pass start (+ appended).
+    char      oldestArchive[40] = "";
+
+    // COPY job
+    uint32_t  jobDate = 0;
+    File      src;
+    File      dst;
+
+    /// Pending archive job (/logs/archive/.job): open @p date's copy at @p base.
+    bool readJob(uint32_t& date, uint32_t& base) const;
+    bool writeJob(uint32_t date, uint32_t base) const;
+    void clearJob() const;
+    void jobPath(char* out, size_t size) const;
+
+    bool startPass();
+    void stepAge();
+    void stepCopy();
+    void stepCap();
+    void endJob(bool removeSource);
+    bool removeDaily(uint32_t date);
+    void scanArchives();             ///< archiveBytes + oldestArchive.
+    void dailyPath(uint32_t date, char* out, size_t size) const;
+    static uint32_t dateKey(const DateTime& dt) { return dt.year() * 10000UL + dt.month() * 100UL + dt.day(); }
+};
@@ -7,28 +7,35 @@
  * - Two modes:
  *   1) Daily mode:   <basePath>/YYYY-MM-DD.txt (when basePath does NOT end with ".txt")
  *   2) Single file:  <basePath>                (when basePath ends with ".txt")
- * - Timestamps are taken from the global RTCManager instance (local time).
+ * - Timestamps come from TimeSource (system clock, cached per second), so a
+ *   log line costs no I2C transaction to the DS1307.
  * - Serial output can be enabled/disabled independently of file logging.
+ * - Deferred mode buffers entries in a RAM ring and hands SD writes to the
+ *   I/O task in batches, so the clock task never blocks on the card and the
+ *   card sees one append per batch instead of one open/close per line.
  *
  * Notes
  * -----
  * - SD must already be initialized elsewhere (e.g., in setup()).
  * - This module does not change any system state besides writing log files.
- * - If RTC is not yet available, placeholder dates/timestamps are used.
+ * - Until the system clock is set (SNTP or RTC), placeholder dates/timestamps are used.
  */
 
 #include "Logger.h"
-#include "RTCManager.h"
+#include "TimeSource.h"
+#include "Metrics.h"
+#include "NetWake.h"
+#include <esp_system.h>
 
-// Uses the global rtcManager provided elsewhere in the project.
-extern RTCManager rtcManager;
+// Instance flushed by the esp_restart() shutdown hook (set by startDeferred()).
+static Logger* shutdownLogger = nullptr;
 
 /**
  * @brief Helper: returns true if the string ends with ".txt" (case-sensitive).
  */
-static bool endsWithTxt(const String& s) {
-    int n = s.length();
-    return (n >= 4) && s.substring(n - 4) == ".txt";
+static bool endsWithTxt(const char* s) {
+    size_t n = strlen(s);
+    return (n >= 4) && strcmp(s + n - 4, ".txt") == 0;
 }
 
 /**
@@ -45,19 +52,20 @@ bool Logger::begin(const char* logPath, bool enableSerial) {
     serialEnabled = enableSerial;
 
     // SD should already be initialized in setup(); Logger does not (re)initialize SD.
-    basePath = String(logPath);
+    strlcpy(basePath, logPath, sizeof(basePath));
     dailyMode = !endsWithTxt(basePath); // ".txt" => single-file; otherwise daily logs.
 
     if (dailyMode) {
         ensureDirIfDaily();
+        logIndex.scan(basePath);
     }
 
     // Defer date determination until the first log call.
-    currentDate = "";
+    currentDate[0] = '\0';
 
     if (serialEnabled) {
         Serial.printf("[Logger] init (%s), path=%s\n",
-                      dailyMode ? "daily" : "single", basePath.c_str());
+                      dailyMode ? "daily" : "single", basePath);
     }
     return true;
 }
@@ -76,70 +84,67 @@ void Logger::ensureDirIfDaily() {
  * @brief Update the active date for daily rotation if the date has changed.
  *
  * - If this is the first use, capture today's date (or placeholder).
- * - If RTC returns a valid date ("!= 0000-00-00") and it differs from the current one, rotate.
+ * - If the clock yields a valid date ("!= 0000-00-00") and it differs from the current one, rotate.
  */
 void Logger::rotateIfNeeded() {
     if (!dailyMode) return;
 
-    String d = todayDateString();
-    if (currentDate.isEmpty()) {
+    char d[11];
+    todayDateString(d);
+    rotateTo(d);
+}
+
+/**
+ * @brief Make @p date the active date (a placeholder only on first use).
+ */
+void Logger::rotateTo(const char date[11]) {
+    if (currentDate[0] == '\0') {
         // First use — set even if it's a placeholder.
-        currentDate = d;
+        memcpy(currentDate, date, sizeof(currentDate));
         return;
     }
-    if (d != "0000-00-00" && d != currentDate) {
-        currentDate = d;
+    if (strcmp(date, "0000-00-00") != 0 && strcmp(date, currentDate) != 0) {
+        memcpy(currentDate, date, sizeof(currentDate));
     }
 }
 
 /**
- * @brief Get today's date as "YYYY-MM-DD".
- * @return "0000-00-00" if RTC is not yet available.
+ * @brief Write today's date as "YYYY-MM-DD" into out[11].
+ *        "0000-00-00" if the system clock is not set yet.
  */
-String Logger::todayDateString() {
-    // If RTC is not ready yet, return a placeholder date.
-    if (!rtcManager.isRtcAvailable()) {
-        return String("0000-00-00");
-    }
-    auto now = rtcManager.now(); // Local time (RTC synced from NTP)
-    char buf[11];
-    snprintf(buf, sizeof(buf), "%04d-%02d-%02d", now.year(), now.month(), now.day());
-    return String(buf);
+void Logger::todayDateString(char out[11]) {
+    TimeSource::date(out);
 }
 
 /**
  * @brief Compute the active log file path based on the selected mode.
- * @return Full path to the target log file.
+ * @param out  Destination buffer.
+ * @param size Size of @p out (PATH_MAX_LEN is enough).
  */
-String Logger::activeLogPath() {
+void Logger::activeLogPath(char* out, size_t size) {
     if (dailyMode) {
-        String d = currentDate.isEmpty() ? todayDateString() : currentDate;
-        return basePath + "/" + d + ".txt";
+        char d[11];
+        if (currentDate[0] == '\0') todayDateString(d);
+        else                         memcpy(d, currentDate, sizeof(d));
+        snprintf(out, size, "%s/%s.txt", basePath, d);
+        return;
     }
     // Single-file mode
-    return basePath;
+    strlcpy(out, basePath, size);
 }
 
 /**
- * @brief Build a timestamp string "YYYY-MM-DD HH:MM:SS".
- * @return Placeholder "0000-00-00 00:00:00" if RTC is not available.
+ * @brief Write a timestamp "YYYY-MM-DD HH:MM:SS" into out[20].
+ *        Placeholder "0000-00-00 00:00:00" if the system clock is not set yet.
  */
-String Logger::getTimestamp() {
-    if (!rtcManager.isRtcAvailable()) {
-        return String("0000-00-00 00:00:00");
-    }
-    auto now = rtcManager.now(); // Local time
-    char buffer[20];
-    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d",
-             now.year(), now.month(), now.day(),
-             now.hour(), now.minute(), now.second());
-    return String(buffer);
+void Logger::getTimestamp(char out[20]) {
+    TimeSource::timestamp(out);
 }
 
 /**
  * @brief Convert log level enum to a short string token.
  */
-String Logger::levelToString(LogLevel level) {
+const char* Logger::levelToString(LogLevel level) {
     switch (level) {
         case LogLevel::INFO:    return "INFO";
         case LogLevel::WARNING: return "WARN";
@@ -153,27 +158,246 @@ String Logger::levelToString(LogLevel level) {
  * @param level   Log severity.
  * @param message Log message (one line).
  *
+ * Kept for String call sites; forwards to write().
+ */
+void Logger::log(LogLevel level, const String& message) {
+    write(level, message.c_str());
+}
+
+/**
+ * @brief printf-style entry point; formats into a stack buffer (no heap).
+ * @param level Log severity.
+ * @param fmt   printf format; the result is truncated to fit one entry.
+ */
+void Logger::logf(LogLevel level, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vwrite(level, fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * @brief va_list variant shared by logf()/infof()/warnf()/errorf().
+ */
+void Logger::vwrite(LogLevel level, const char* fmt, va_list ap) {
+    char msg[LINE_MAX];
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    write(level, msg);
+}
+
+/**
+ * @brief Common sink: build "[ts] [LEVEL] message" on the stack and emit it.
+ *
  * I/O:
  * - Serial: Printed if serialEnabled == true.
+ * - Live feed: published as a "log" event when an EventManager is attached.
  * - SD: Appends to active log file. If open fails and serial is enabled, prints a warning to Serial.
+ *   In deferred mode the entry goes to the RAM ring instead (dropped and counted if full);
+ *   an ERROR entry makes the next service() flush immediately.
  */
-void Logger::log(LogLevel level, const String& message) {
-    rotateIfNeeded();
+void Logger::write(LogLevel level, const char* message) {
+    char ts[20];
+    getTimestamp(ts);
 
-    String entry = "[" + getTimestamp() + "] [" + levelToString(level) + "] " + message;
+    char entry[LINE_MAX];
+    int len = snprintf(entry, sizeof(entry), "[%s] [%s] %s", ts, levelToString(level), message);
+    if (len < 0) return;
+    const size_t n = min<size_t>((size_t)len, sizeof(entry) - 1);
 
     if (serialEnabled) {
         Serial.println(entry);
     }
+    if (events) events->publish(EventType::LOG, entry);
+
+    if (!deferred) {
+        rotateIfNeeded();
+        appendToSd(entry);
+        return;
+    }
+
+    // Append "entry\n" to the ring as a whole line, or drop it.
+    bool stored = false;
+    portENTER_CRITICAL(&ringLock);
+    if (n + 1 <= RING_SIZE - 1 - ringUsed()) {
+        size_t h     = ringHead;
+        size_t first = min<size_t>(n, RING_SIZE - h);
+        memcpy(&ring[h], entry, first);
+        memcpy(&ring[0], entry + first, n - first);
+        h = (h + n) % RING_SIZE;
+        ring[h]  = '\n';
+        ringHead = (h + 1) % RING_SIZE;
+        stored   = true;
+    }
+    portEXIT_CRITICAL(&ringLock);
+
+    if (!stored) dropped++;
+    if (level == LogLevel::ERROR) urgent = true;
+    if (urgent || !stored || ringUsed() >= FLUSH_THRESHOLD) NetWake::notify();
+}
+
+/**
+ * @brief Append one entry to the active log file (kept open, flushed per line).
+ */
+void Logger::appendToSd(const char* entry) {
+    if (!ensureLogFile()) return;
+    const uint32_t t0 = micros();
+    logFile.println(entry);
+    logFile.flush();
+    Metrics::observe(Latency::SD_LOG_US, micros() - t0);
+    indexActiveFile();
+}
+
+/**
+ * @brief Make sure logFile is open on the active path (reopen after rotation).
+ * @return false if the file cannot be opened (warning printed to Serial).
+ */
+bool Logger::ensureLogFile() {
+    char path[PATH_MAX_LEN];
+    activeLogPath(path, sizeof(path));
+    if (logFile && strcmp(path, logFilePath) == 0) return true;
 
-    String path = activeLogPath();
-    File f = SD.open(path, FILE_APPEND);
-    if (f) {
-        f.println(entry);
-        f.close();
-    } else if (serialEnabled) {
-        Serial.println("⚠️ Logger: cannot open " + path);
+    if (logFile) logFile.close();
+    logFile = SD.open(path, FILE_APPEND);
+    if (logFile) {
+        strlcpy(logFilePath, path, sizeof(logFilePath));
+        indexActiveFile();   // a new day's file shows up in the index right away
+    } else {
+        logFilePath[0] = '\0';
+        if (serialEnabled) Serial.printf("⚠️ Logger: cannot open %s\n", path);
     }
+    return (bool)logFile;
+}
+
+/**
+ * @brief Update the index entry of the open daily file (no-op in single-file mode).
+ */
+void Logger::indexActiveFile() {
+    if (!dailyMode || !logFile) return;
+    const char* slash = strrchr(logFilePath, '/');
+    logIndex.update(slash ? slash + 1 : logFilePath, (uint32_t)logFile.size());
+}
+
+/**
+ * @brief Bytes currently held in the ring (caller holds ringLock or is the flusher).
+ */
+size_t Logger::ringUsed() const {
+    return (ringHead + RING_SIZE - ringTail) % RING_SIZE;
+}
+
+/**
+ * @brief "YYYY-MM-DD" of the entry starting at ring[pos] ("[YYYY-MM-DD HH:MM:SS] ...").
+ */
+void Logger::ringLineDate(size_t pos, char out[11]) const {
+    for (size_t i = 0; i < 10; i++) out[i] = ring[(pos + 1 + i) % RING_SIZE];
+    out[10] = '\0';
+}
+
+void Logger::writeRing(size_t from, size_t to) {
+    if (to >= from) {
+        logFile.write((const uint8_t*)&ring[from], to - from);
+    } else {
+        logFile.write((const uint8_t*)&ring[from], RING_SIZE - from);
+        logFile.write((const uint8_t*)&ring[0],    to);
+    }
+}
+
+/**
+ * @brief Enable deferred mode (ring buffer + batched flush).
+ *
+ * Call once the I/O task that runs service() exists. Also registers a
+ * shutdown hook so buffered lines survive esp_restart().
+ */
+void Logger::startDeferred() {
+    if (deferred) return;
+    lastFlushMs    = millis();
+    shutdownLogger = this;
+    esp_register_shutdown_handler(&Logger::onShutdown);
+    deferred = true;
+}
+
+/**
+ * @brief Flush when the ring is half full, the interval elapsed, or after an ERROR.
+ */
+void Logger::service() {
+    if (!deferred) return;
+
+    const size_t used = ringUsed();
+    if (used == 0 && dropped == droppedReported) return;
+
+    if (urgent || used >= FLUSH_THRESHOLD ||
+        (uint32_t)(millis() - lastFlushMs) >= FLUSH_INTERVAL_MS) {
+        flush();
+    }
+}
+
+/**
+ * @brief Write all buffered lines in one batch per daily file.
+ *
+ * Like EventLog::flush(), lines go to the file of the date they are stamped
+ * with, so a batch that spans midnight is split there instead of landing in
+ * the new day (lines from before the clock was set stay in the active file).
+ *
+ * Runs on the I/O task (or the shutdown hook), which is also the only place
+ * rotation happens in deferred mode, so currentDate is never touched
+ * concurrently. Producers only write past ringHead, so [tail, head) is
+ * stable while it is written out without the lock.
+ */
+void Logger::flush() {
+    if (!deferred) return;
+
+    lastFlushMs = millis();
+    urgent      = false;
+
+    const size_t head = ringHead;
+    const size_t tail = ringTail;
+    if (head == tail && dropped == droppedReported) return;
+
+    size_t t     = tail;
+    bool   first = true;
+    do {
+        // Longest run of whole lines that belong to the same daily file
+        char date[11];
+        if (t != head) {
+            ringLineDate(t, date);
+            rotateTo(date);
+        } else {
+            rotateIfNeeded();   // only the dropped-lines notice to write
+        }
+        size_t end = t;
+        while (end != head) {
+            char d[11];
+            ringLineDate(end, d);
+            if (dailyMode && strcmp(d, currentDate) != 0 && strcmp(d, "0000-00-00") != 0) break;
+            while (ring[end] != '\n') end = (end + 1) % RING_SIZE;
+            end = (end + 1) % RING_SIZE;
+        }
+
+        if (ensureLogFile()) {
+            const uint32_t t0   = micros();
+            const uint32_t lost = dropped;
+            if (first && lost != droppedReported) {
+                logFile.printf("[Logger] %lu line(s) dropped (buffer full)\n",
+                               (unsigned long)(lost - droppedReported));
+                droppedReported = lost;
+            }
+            writeRing(t, end);
+            logFile.flush();
+            Metrics::observe(Latency::SD_LOG_US, micros() - t0);
+            indexActiveFile();
+        }
+        first = false;
+        t     = end;
+    } while (t != head);
+
+    // On open failure the run is discarded so fresh lines keep flowing.
+    ringTail = head;
+}
+
+/**
+ * @brief esp_restart() hook: push buffered lines to SD before reboot.
+ */
+void Logger::onShutdown() {
+    if (shutdownLogger) shutdownLogger->flush();
 }
 
 /**
@@ -182,3 +406,19 @@ void Logger::log(LogLevel level, const String& message) {
 void Logger::info(const String& message)  { log(LogLevel::INFO,    message); }
 void Logger::warn(const String& message)  { log(LogLevel::WARNING, message); }
 void Logger::error(const String& message) { log(LogLevel::ERROR,   message); }
+
+void Logger::infof(const char* fmt, ...)  { va_list ap; va_start(ap, fmt); vwrite(LogLevel::INFO,    fmt, ap); va_end(ap); }
+void Logger::warnf(const char* fmt, ...)  { va_list ap; va_start(ap, fmt); vwrite(LogLevel::WARNING, fmt, ap); va_end(ap); }
+void Logger::errorf(const char* fmt, ...) { va_list ap; va_start(ap, fmt); vwrite(LogLevel::ERROR,   fmt, ap); va_end(ap); }
+
+void Logger::tracef(const char* fmt, ...) {
+    if (!serialEnabled) return;
+    char msg[LINE_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    char ts[20];
+    getTimestamp(ts);
+    Serial.printf("[%s] [TRACE] %s\n", ts, msg);
+}
@@ -9,6 +9,7 @@
  *   logger.info("System started.");
  *   logger.warn("Low voltage.");
  *   logger.error("Write failed.");
+ *   logger.infof("Catch-up remaining: %d", n);   // no heap allocation
  *
  * Modes
  * -----
@@ -17,16 +18,43 @@
  * - Single-file mode: basePath ends with ".txt" (e.g., "/log.txt")
  *   -> appends to that single file
  *
+ * Deferred mode
+ * -------------
+ * - After startDeferred(), log() only formats the line, mirrors it to Serial
+ *   and appends it to a fixed-size RAM ring buffer; service() (called from
+ *   the I/O task) flushes the ring to SD in one batch when it is half full,
+ *   every FLUSH_INTERVAL_MS, or right after an ERROR. log() is then safe
+ *   from any task and never waits for the card.
+ * - The log file stays open between batches (reopened only on rotation);
+ *   flush() forces a write-out and is also run before esp_restart().
+ * - Lines that do not fit into the ring are dropped and counted; the count
+ *   is written to the file with the next batch.
+ *
+ * Log index
+ * ---------
+ * - In daily mode begin() indexes the existing files once; afterwards the
+ *   index (index()) is updated on rotation and after each write, so the web
+ *   server can list logs without walking the directory.
+ *
+ * Live feed
+ * ---------
+ * - With setEventSink(), every entry is also published as a "log" event
+ *   (only while a client is subscribed to /api/events).
+ *
  * Requirements
  * ------------
  * - SD must be initialized before calling Logger::begin().
- * - A global RTCManager must be available to provide timestamps.
+ * - Timestamps come from TimeSource (system clock); no RTC access per line.
  */
 
 #pragma once
 
 #include <Arduino.h>
 #include <SD.h>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include "EventManager.h"
+#include "LogIndex.h"
 
 /**
  * @enum LogLevel
@@ -66,18 +94,94 @@ public:
     /// @brief Shorthand for ERROR level.
     void error(const String& message);
 
+    /// @brief Literal/C-string overloads (no temporary String).
+    void log(LogLevel level, const char* message) { write(level, message); }
+    void info(const char* message)  { write(LogLevel::INFO,    message); }
+    void warn(const char* message)  { write(LogLevel::WARNING, message); }
+    void error(const char* message) { write(LogLevel::ERROR,   message); }
+
+    /**
+     * @brief printf-style logging into a fixed stack buffer (no heap use).
+     * @param level Log severity.
+     * @param fmt   printf format; output longer than one entry is truncated.
+     */
+    void logf(LogLevel level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    /// @brief printf-style shorthand for INFO level.
+    void infof(const char* fmt, ...)  __attribute__((format(printf, 2, 3)));
+    /// @brief printf-style shorthand for WARNING level.
+    void warnf(const char* fmt, ...)  __attribute__((format(printf, 2, 3)));
+    /// @brief printf-style shorthand for ERROR level.
+    void errorf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    /// @brief Serial-only debug line (same format, not written to SD or the live feed).
+    ///        For events that are recorded in the binary EventLog instead.
+    void tracef(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    /// @brief Switch to deferred mode: log() buffers, service() writes to SD.
+    void startDeferred();
+
+    /// @brief Flush the ring when a threshold/interval/ERROR asks for it (I/O task).
+    void service();
+
+    /// @brief Write everything buffered to SD now (also used before reboot).
+    void flush();
+
+    /// @brief Sorted list of daily log files with their sizes (daily mode).
+    LogIndex& index() { return logIndex; }
+
+    /// @brief Mirror every entry to the /api/events feed (nullptr = off).
+    void setEventSink(EventManager* sink) { events = sink; }
+
+    /// @brief Lines lost because the ring buffer was full (deferred mode).
+    uint32_t droppedCount() const { return dropped; }
+
 private:
+    static constexpr size_t   LINE_MAX          = 224;  ///< Max bytes per formatted entry (incl. NUL).
+    static constexpr size_t   PATH_MAX_LEN      = 48;   ///< Max log base/file path length.
+    static constexpr size_t   RING_SIZE         = 4096; ///< RAM ring capacity (bytes).
+    static constexpr size_t   FLUSH_THRESHOLD   = 2048; ///< Flush once this many bytes are buffered.
+    static constexpr uint32_t FLUSH_INTERVAL_MS = 5000; ///< Flush at least this often when non-empty.
+
     // Mode & state
     bool   serialEnabled = true;   ///< If true, also prints each entry to Serial.
     bool   dailyMode     = true;   ///< true = daily rotation; false = single-file mode.
-    String basePath;               ///< "/logs" (dir) or "/log.txt" (single-file).
-    String currentDate;            ///< "YYYY-MM-DD" tracked for daily rotation.
+    char   basePath[PATH_MAX_LEN] = "";  ///< "/logs" (dir) or "/log.txt" (single-file).
+    char   currentDate[11]        = "";  ///< "YYYY-MM-DD" tracked for daily rotation.
+
+    // Deferred mode: single-producer-lock / single-consumer byte ring
+    char              ring[RING_SIZE];     ///< Buffered, newline-terminated entries.
+    volatile size_t   ringHead  = 0;       ///< Next write index (producers, under ringLock).
+    volatile size_t   ringTail  = 0;       ///< Next read index (flusher only).
+    portMUX_TYPE      ringLock  = portMUX_INITIALIZER_UNLOCKED;
+    bool              deferred  = false;   ///< true once startDeferred() was called.
+    volatile bool     urgent    = false;   ///< ERROR logged → flush on next service().
+    volatile uint32_t dropped   = 0;       ///< Entries lost to a full ring (total).
+    uint32_t          droppedReported = 0; ///< Part of `dropped` already noted in the file.
+    uint32_t          lastFlushMs = 0;
+
+    EventManager*     events = nullptr;    ///< Optional live feed (setEventSink()).
+    LogIndex          logIndex;            ///< Daily files (see index()).
+
+    // Open log file, kept across batches
+    File   logFile;
+    char   logFilePath[PATH_MAX_LEN] = ""; ///< Path logFile was opened with ("" = closed).
 
     // Helpers
     void   ensureDirIfDaily();     ///< Create base directory if dailyMode is enabled.
     void   rotateIfNeeded();       ///< Update currentDate when the day changes.
-    String todayDateString();      ///< From RTCManager (local date), or "0000-00-00".
-    String activeLogPath();        ///< Resolve target file path for the write.
-    String getTimestamp();         ///< "YYYY-MM-DD HH:MM:SS", or placeholder if RTC unknown.
-    String levelToString(LogLevel level);
+    void   rotateTo(const char date[11]);        ///< Same, for a line stamped with @p date.
+    void   todayDateString(char out[11]);        ///< From TimeSource (local date), or "0000-00-00".
+    void   activeLogPath(char* out, size_t size);///< Resolve target file path for the write.
+    void   getTimestamp(char out[20]);           ///< "YYYY-MM-DD HH:MM:SS", or placeholder if clock unset.
+    static const char* levelToString(LogLevel level);
+    void   write(LogLevel level, const char* message);            ///< Format + emit (no heap).
+    void   vwrite(LogLevel level, const char* fmt, va_list ap);
+    void   appendToSd(const char* entry);    ///< Synchronous single-line append.
+    bool   ensureLogFile();        ///< (Re)open the active file if the path changed.
+    void   indexActiveFile();      ///< Record the open file's size in logIndex.
+    size_t ringUsed() const;       ///< Bytes currently buffered.
+    void   ringLineDate(size_t pos, char out[11]) const;  ///< Date stamp of the line at @p pos.
+    void   writeRing(size_t from, size_t to);             ///< ring[from, to) to logFile (may wrap).
+    static void onShutdown();      ///< esp_restart() hook → flush().
 };
@@ -0,0 +1,166 @@
+/**
+ * @file    Metrics.cpp
+ * @brief   Counter/histogram storage and naming for /api/metrics.
+ */
+
+#include "Metrics.h"
+#include <esp_timer.h>
+
+uint32_t     Metrics::counters[(int)Metric::COUNT] = {};
+LatencyStats Metrics::latency[(int)Latency::COUNT];
+float        Metrics::gauges[(int)Gauge::COUNT] = {};
+portMUX_TYPE Metrics::mux = portMUX_INITIALIZER_UNLOCKED;
+
+namespace {
+
+struct LatencyInfo {
+    const char* name;
+    const char* help;
+    uint32_t    base;    ///< Upper bound of bucket 0 (≤ 2^16 so base << 15 fits).
+};
+
+const LatencyInfo LATENCY_INFO[] = {
+    { "minute_edge_lateness_us", "Start of the minute pulse after :00",          64 },
+    { "clock_loop_us",           "Clock engine loop() iteration time",            8 },
+    { "sd_log_write_us",         "Logger SD batch write and flush",             128 },
+    { "sd_state_write_us",       "State journal record write and flush",        128 },
+    { "ntp_sync_ms",             "NTP request to time received",                  8 },
+    { "http_handler_us",         "HTTP route handler run time",                 256 },
+};
+static_assert(sizeof(LATENCY_INFO) / sizeof(LATENCY_INFO[0]) == (size_t)Latency::COUNT,
+              "LATENCY_INFO must list every Latency");
+
+const char* const METRIC_NAMES[] = {
+    "pulses_total", "pulses_skipped_gap_total", "pulses_skipped_busy_total",
+    "ntp_sync_ok_total", "ntp_sync_failed_total",
+    "http_requests_total", "http_rejected_total",
+    "state_nvram_commits_total",
+    "fleet_beacons_sent_total", "fleet_beacons_received_total",
+    "pulses_confirmed_total", "pulses_missed_total",
+};
+static_assert(sizeof(METRIC_NAMES) / sizeof(METRIC_NAMES[0]) == (size_t)Metric::COUNT,
+              "METRIC_NAMES must list every Metric");
+
+const char* const GAUGE_NAMES[] = { "rtc_drift_ppm", "rtc_offset_seconds", "fleet_offset_ms" };
+static_assert(sizeof(GAUGE_NAMES) / sizeof(GAUGE_NAMES[0]) == (size_t)Gauge::COUNT,
+              "GAUGE_NAMES must list every Gauge");
+
+} // namespace
+
+void Metrics::count(Metric m, uint32_t n) {
+    portENTER_CRITICAL(&mux);
+    counters[(int)m] += n;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Add one sample to a histogram (bucket search is at most 16 compares).
+ */
+void Metrics::observe(Latency l, uint32_t value) {
+    const uint32_t b = base(l);
+    size_t i = 0;
+    while (i < LatencyStats::BUCKETS && value > (b << i)) i++;
+
+    portENTER_CRITICAL(&mux);
+    LatencyStats& s = latency[(int)l];
+    s.buckets[i]++;
+    s.count++;
+    s.sum += value;
+    if (value > s.max) s.max = value;
+    portEXIT_CRITICAL(&mux);
+}
+
+void Metrics::setGauge(Gauge g, float value) {
+    portENTER_CRITICAL(&mux);
+    gauges[(int)g] = value;
+    portEXIT_CRITICAL(&mux);
+}
+
+void Metrics::snapshot(MetricsSnapshot& out) {
+    portENTER_CRITICAL(&mux);
+    memcpy(out.counters, counters, sizeof(counters));
+    memcpy(out.latency,  latency,  sizeof(latency));
+    memcpy(out.gauges,   gauges,   sizeof(gauges));
+    portEXIT_CRITICAL(&mux);
+
+    out.uptimeS     = (uint32_t)(esp_timer_get_time() / 1000000LL);
+    out.heapFree    = ESP.getFreeHeap();
+    out.heapMinFree = ESP.getMinFreeHeap();
+}
+
+uint32_t Metrics::percentile(const LatencyStats& s, Latency l, float q) {
+    if (s.count == 0) return 0;
+    const uint32_t rank = (uint32_t)ceilf(q * (float)s.count);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < LatencyStats::BUCKETS; i++) {
+        seen += s.buckets[i];
+        if (seen >= rank) return min(bucketBound(l, i), s.max);
+    }
+    return s.max;
+}
+
+/*
+ * Item layout: counters, gauges, heap/uptime, then per histogram HELP/TYPE,
+ * its cumulative buckets, the +Inf, _sum and _count lines (one item each), and
+ * a separate *_max gauge. The longest item is a HELP/TYPE pair (~130 bytes).
+ */
+int Metrics::formatPrometheus(const MetricsSnapshot& s, size_t item, char* out, size_t size) {
+    constexpr size_t NC = (size_t)Metric::COUNT;
+    constexpr size_t NG = (size_t)Gauge::COUNT;
+    constexpr size_t NX = 3;                               // heap free/min, uptime
+    constexpr size_t HIST_ITEMS = LatencyStats::BUCKETS + 5;
+
+    if (item < NC) {
+        const char* n = name((Metric)item);
+        return snprintf(out, size, "# TYPE pragotron_%s counter\npragotron_%s %lu\n",
+                        n, n, (unsigned long)s.counters[item]);
+    }
+    item -= NC;
+    if (item < NG) {
+        const char* n = name((Gauge)item);
+        return snprintf(out, size, "# TYPE pragotron_%s gauge\npragotron_%s %.3f\n",
+                        n, n, s.gauges[item]);
+    }
+    item -= NG;
+    if (item < NX) {
+        static const char* const X_NAMES[NX] = { "heap_free_bytes", "heap_min_free_bytes", "uptime_seconds" };
+        const uint32_t v = item == 0 ? s.heapFree : item == 1 ? s.heapMinFree : s.uptimeS;
+        return snprintf(out, size, "# TYPE pragotron_%s gauge\npragotron_%s %lu\n",
+                        X_NAMES[item], X_NAMES[item], (unsigned long)v);
+    }
+    item -= NX;
+    if (item >= (size_t)Latency::COUNT * HIST_ITEMS) return -1;
+
+    const Latency       l  = (Latency)(item / HIST_ITEMS);
+    const size_t        k  = item % HIST_ITEMS;
+    const LatencyStats& st = s.latency[(int)l];
+    const char*         n  = name(l);
+
+    if (k == 0) {
+        return snprintf(out, size, "# HELP pragotron_%s %s\n# TYPE pragotron_%s histogram\n",
+                        n, help(l), n);
+    }
+    if (k <= LatencyStats::BUCKETS) {
+        uint32_t cum = 0;
+        for (size_t i = 0; i < k; i++) cum += st.buckets[i];
+        return snprintf(out, size, "pragotron_%s_bucket{le=\"%lu\"} %lu\n",
+                        n, (unsigned long)bucketBound(l, k - 1), (unsigned long)cum);
+    }
+    if (k == LatencyStats::BUCKETS + 1) {
+        return snprintf(out, size, "pragotron_%s_bucket{le=\"+Inf\"} %lu\n", n, (unsigned long)st.count);
+    }
+    if (k == LatencyStats::BUCKETS + 2) {
+        return snprintf(out, size, "pragotron_%s_sum %llu\n", n, (unsigned long long)st.sum);
+    }
+    if (k == LatencyStats::BUCKETS + 3) {
+        return snprintf(out, size, "pragotron_%s_count %lu\n", n, (unsigned long)st.count);
+    }
+    return snprintf(out, size, "# TYPE pragotron_%s_max gauge\npragotron_%s_max %lu\n",
+                    n, n, (unsigned long)st.max);
+}
+
+uint32_t    Metrics::base(Latency l)  { return LATENCY_INFO[(int)l].base; }
+const char* Metrics::name(Metric m)   { return METRIC_NAMES[(int)m]; }
+const char* Metrics::name(Latency l)  { return LATENCY_INFO[(int)l].name; }
+const char* Metrics::name(Gauge g)    { return GAUGE_NAMES[(int)g]; }
+const char* Metrics::help(Latency l)  { return LATENCY_INFO[(int)l].help; }
@@ -0,0 +1,133 @@
+/**
+ * @file    Metrics.h
+ * @brief   Cheap performance counters and latency histograms for /api/metrics.
+ *
+ * Usage:
+ *   Metrics::count(Metric::PULSES);
+ *   Metrics::observe(Latency::SD_LOG_US, micros() - t0);
+ *   Metrics::setGauge(Gauge::RTC_DRIFT_PPM, ppm);
+ *
+ *   MetricsSnapshot s; Metrics::snapshot(s);   // consistent copy for rendering
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @enum Metric
+ * @brief Monotonic event counters (since boot).
+ */
+enum class Metric : uint8_t {
+    PULSES,               ///< Pulses started by PulseManager::triggerPulse().
+    PULSES_SKIPPED_GAP,   ///< Refused by the min-gap guard.
+    PULSES_SKIPPED_BUSY,  ///< Refused because the previous pulse was still in flight.
+    NTP_OK,
+    NTP_FAILED,
+    HTTP_REQUESTS,
+    HTTP_REJECTED,        ///< 503 from the async backend's connection limit.
+    STATE_NVRAM_COMMITS,  ///< Clock positions committed to DS1307 NVRAM.
+    FLEET_BEACONS_SENT,   ///< Leader time beacons multicast.
+    FLEET_BEACONS_RECEIVED, ///< Beacons accepted from the current leader.
+    PULSES_CONFIRMED,     ///< Steps verified by coil-current/position feedback.
+    PULSES_MISSED,        ///< Steps the feedback reported as not taken (retried).
+    COUNT
+};
+
+/**
+ * @enum Latency
+ * @brief Duration/lateness distributions (log2 buckets, see Metrics).
+ */
+enum class Latency : uint8_t {
+    MINUTE_EDGE_US,       ///< Start of a regular minute pulse after :00.
+    CLOCK_LOOP_US,        ///< One SystemManager::loop() iteration.
+    SD_LOG_US,            ///< Logger batch write + flush.
+    SD_STATE_US,          ///< StateManager journal record write + flush.
+    NTP_SYNC_MS,          ///< startNtpSync() → time received.
+    HTTP_US,              ///< Route handler run time (sync: includes streaming).
+    COUNT
+};
+
+/**
+ * @enum Gauge
+ * @brief Last-value readings.
+ */
+enum class Gauge : uint8_t {
+    RTC_DRIFT_PPM,        ///< RTC rate estimate after the last NTP sync.
+    RTC_OFFSET_S,         ///< |NTP − RTC| at the last sync (before correction).
+    FLEET_OFFSET_MS,      ///< Follower: last filtered offset to the leader (before the step).
+    COUNT
+};
+
+/**
+ * @struct LatencyStats
+ * @brief One histogram: bucket i counts values ≤ base << i; the last one the rest.
+ */
+struct LatencyStats {
+    static constexpr size_t BUCKETS = 16;
+    uint32_t buckets[BUCKETS + 1] = {};
+    uint32_t count = 0;
+    uint32_t max   = 0;
+    uint64_t sum   = 0;
+};
+
+/**
+ * @struct MetricsSnapshot
+ * @brief Copy of all metrics taken under the lock (plus heap/uptime at that moment).
+ */
+struct MetricsSnapshot {
+    uint32_t     counters[(int)Metric::COUNT] = {};
+    LatencyStats latency[(int)Latency::COUNT];
+    float        gauges[(int)Gauge::COUNT] = {};
+    uint32_t     uptimeS     = 0;
+    uint32_t     heapFree    = 0;
+    uint32_t     heapMinFree = 0;
+};
+
+/**
+ * @class Metrics
+ * @brief Process-wide counters; recording is a few increments under a spinlock.
+ *
+ * Histograms use 16 power-of-two buckets above a per-metric base (e.g. 64 µs
+ * for the minute edge → 64 µs … 2 s), so percentiles are upper bounds within
+ * a factor of two — enough to tell a stall from normal jitter. All methods
+ * are static and safe from any task.
+ */
+class Metrics {
+public:
+    static void count(Metric m, uint32_t n = 1);
+    static void observe(Latency l, uint32_t value);
+    static void setGauge(Gauge g, float value);
+
+    static void snapshot(MetricsSnapshot& out);
+
+    /// Upper bound of the bucket holding quantile @p q (0..1), capped at max; 0 if empty.
+    static uint32_t percentile(const LatencyStats& s, Latency l, float q);
+    static uint32_t bucketBound(Latency l, size_t i) { return base(l) << i; }
+
+    /**
+     * @brief Render item @p item of the Prometheus text exposition into @p out.
+     * @return snprintf-style length (≥ size means truncated), or −1 past the last item.
+     *
+     * Items are whole metric families or single histogram lines, each under
+     * PROM_ITEM_MAX bytes at any counter value, so a caller can stream a
+     * snapshot piece by piece.
+     */
+    static int formatPrometheus(const MetricsSnapshot& s, size_t item, char* out, size_t size);
+    static constexpr size_t PROM_ITEM_MAX = 160;
+
+    // Names (Prometheus style, without the "pragotron_" prefix)
+    static const char* name(Metric m);
+    static const char* name(Latency l);
+    static const char* name(Gauge g);
+    static const char* help(Latency l);
+
+private:
+    static uint32_t base(Latency l);
+
+    static uint32_t     counters[(int)Metric::COUNT];
+    static LatencyStats latency[(int)Latency::COUNT];
+    static float        gauges[(int)Gauge::COUNT];
+    static portMUX_TYPE mux;
+};
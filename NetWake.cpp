@@ -0,0 +1,8 @@
+/**
+ * @file    NetWake.cpp
+ * @brief   Storage for the network task handle (see NetWake.h).
+ */
+
+#include "NetWake.h"
+
+TaskHandle_t NetWake::netTask = nullptr;
@@ -0,0 +1,38 @@
+/**
+ * @file    NetWake.h
+ * @brief   Wakes the network / I-O task early when work is queued for it.
+ *
+ * Usage:
+ *   NetWake::attach(xTaskGetCurrentTaskHandle());   // network task, once
+ *   NetWake::notify();                               // producer, any task
+ *
+ * The network task sleeps until its next deadline — hundreds of ms in
+ * low-power mode, so light sleep gets long idle windows. Producers whose work
+ * should not wait that long (a state save, an ERROR log flush, a live event,
+ * a full ring) call notify(); everything else rides on the next timeout.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @class NetWake
+ * @brief Task notification to the network task; all methods are static.
+ */
+class NetWake {
+public:
+    /// Register the task that waits in ulTaskNotifyTake().
+    static void attach(TaskHandle_t task) { netTask = task; }
+
+    /// Wake the network task now (no-op before attach); any task, not from ISRs.
+    static void notify() {
+        TaskHandle_t t = netTask;
+        if (t) xTaskNotifyGive(t);
+    }
+
+private:
+    static TaskHandle_t netTask;
+};
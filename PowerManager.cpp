@@ -0,0 +1,110 @@
+/**
+ * @file    PowerManager.cpp
+ * @brief   Power mode setup (esp_pm light sleep, Wi-Fi modem sleep) and duty estimate.
+ *
+ * Notes
+ * -----
+ * - Automatic light sleep is entered by the FreeRTOS idle task when no task
+ *   is ready for a few ticks; esp_timer alarms (esp_timer pulse backend) and
+ *   task timeouts wake the chip, GPIO outputs hold their level meanwhile.
+ * - WIFI_PS_MIN_MODEM keeps the association and wakes for every DTIM beacon,
+ *   which is what keeps the synchronous web server reachable.
+ */
+
+#include "PowerManager.h"
+#include <WiFi.h>
+#include <esp_timer.h>
+#include <esp_idf_version.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+PowerManager::PowerManager(ConfigManager* config, Logger* logger)
+    : configManager(config), logger(logger) {}
+
+/**
+ * @brief Apply power_mode from config; call once Wi-Fi is started.
+ */
+void PowerManager::begin() {
+    startUs  = (uint64_t)esp_timer_get_time();
+    lowPower = (configManager->getConfig().powerMode == PowerMode::LOW_POWER);
+    if (!lowPower) return;
+
+    WiFi.setSleep(WIFI_PS_MIN_MODEM);
+    lightSleep = configureLightSleep();
+    if (lightSleep) {
+        logger->info("🔋 Low-power mode: light sleep + Wi-Fi modem sleep");
+    } else {
+        logger->warn("🔋 Low-power mode: light sleep unavailable (CONFIG_PM_ENABLE) — modem sleep only");
+    }
+}
+
+/**
+ * @brief Enable dynamic frequency scaling with automatic light sleep.
+ * @return false if the core was built without power management.
+ */
+bool PowerManager::configureLightSleep() {
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm = {};
+#else
+    esp_pm_config_esp32_t pm = {};
+#endif
+    pm.max_freq_mhz       = (int)getCpuFrequencyMhz();
+    pm.min_freq_mhz       = 40;   // XTAL; Wi-Fi keeps its own lock while active
+    pm.light_sleep_enable = true;
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        logger->errorf("❌ esp_pm_configure failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Count one wake-up of @p task and the time it then spent running.
+ */
+void PowerManager::taskRan(PowerTask task, uint32_t ranUs) {
+    portENTER_CRITICAL(&mux);
+    wakes[(int)task]++;
+    busyUs += ranUs;
+    portEXIT_CRITICAL(&mux);
+}
+
+/**
+ * @brief Wake counts, awake share and estimated average current since boot.
+ *
+ * Busy time of both tasks is summed, so with the two cores active at once
+ * the awake share is slightly over-estimated (conservative current).
+ */
+PowerStatus PowerManager::status() const {
+    PowerStatus st;
+    st.lowPower   = lowPower;
+    st.lightSleep = lightSleep;
+
+    uint64_t busy;
+    uint32_t total = 0;
+    portENTER_CRITICAL(&mux);
+    busy = busyUs;
+    for (int i = 0; i < (int)PowerTask::COUNT; i++) {
+        st.wakes[i] = wakes[i];
+        total += wakes[i];
+    }
+    portEXIT_CRITICAL(&mux);
+
+    const uint64_t elapsedUs = (uint64_t)esp_timer_get_time() - startUs;
+    if (elapsedUs == 0) return st;
+
+    float awake = (float)busy / (float)elapsedUs;
+    if (awake > 1.0f) awake = 1.0f;
+    st.awakePct    = awake * 100.0f;
+    st.wakesPerMin = (float)total * 60e6f / (float)elapsedUs;
+
+    const auto& cfg = configManager->getConfig();
+    const float restMa = lightSleep ? (float)cfg.powerSleepMa : (float)cfg.powerIdleMa;
+    st.avgMa = awake * (float)cfg.powerActiveMa + (1.0f - awake) * restMa;
+    return st;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file    PowerManager.h
+ * @brief   Low-power mode (ESP32 light sleep + Wi-Fi modem sleep) and duty accounting.
+ *
+ * In "low" power mode the CPU enters automatic light sleep whenever every
+ * task is blocked; the event-driven clock task (SystemManager::idleWaitMs())
+ * and a network task that sleeps up to NET_IDLE_LOW_MS unless work is queued
+ * (NetWake) or due (fleet beacons, log retention steps) make those gaps long. Wi-Fi stays associated in
+ * modem sleep, so the web server keeps answering (with DTIM-sized latency).
+ *
+ * Light sleep needs CONFIG_PM_ENABLE and tickless idle in the core's
+ * sdkconfig; without them "low" still applies modem sleep and the slower
+ * poll, and the status reports light_sleep=false.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+
+/**
+ * @enum PowerTask
+ * @brief Tasks whose wake-ups and busy time are accounted.
+ */
+enum class PowerTask : uint8_t {
+    CLOCK,
+    NET,
+    COUNT
+};
+
+/**
+ * @struct PowerStatus
+ * @brief Snapshot for /api/status.
+ */
+struct PowerStatus {
+    bool     lowPower     = false;
+    bool     lightSleep   = false;   ///< esp_pm accepted light_sleep_enable.
+    uint32_t wakes[(int)PowerTask::COUNT] = {};
+    float    wakesPerMin  = 0.0f;    ///< All tasks, averaged since boot.
+    float    awakePct     = 0.0f;    ///< Share of time a task was running.
+    float    avgMa        = 0.0f;    ///< Estimated average current (config current model).
+};
+
+/**
+ * @class PowerManager
+ * @brief Applies the configured power mode and estimates average current.
+ *
+ * Tasks report each wake-up and how long they then ran (taskRan()); the
+ * estimate weights power_active_ma by the awake share and power_sleep_ma
+ * (light sleep) or power_idle_ma by the rest. It is a model, not a measurement.
+ */
+class PowerManager {
+public:
+    PowerManager(ConfigManager* config, Logger* logger);
+
+    /// Apply power_mode: esp_pm light sleep (if available) and Wi-Fi modem sleep.
+    void begin();
+
+    /// Account one wake-up of @p task that ran for @p busyUs; safe from any task.
+    void taskRan(PowerTask task, uint32_t busyUs);
+
+    /// Longest network task sleep (ms): the baseline 20 ms poll, NET_IDLE_LOW_MS
+    /// in low-power mode. Queued work wakes it earlier (NetWake).
+    uint32_t netPollMs() const { return lowPower ? NET_IDLE_LOW_MS : NET_IDLE_MS; }
+
+    bool lowPowerMode() const { return lowPower; }
+
+    PowerStatus status() const;
+
+private:
+    static constexpr uint32_t NET_IDLE_MS     = 20;
+    static constexpr uint32_t NET_IDLE_LOW_MS = 250;   ///< HTTP latency vs. light-sleep windows.
+
+    ConfigManager* configManager;
+    Logger*        logger;
+
+    bool     lowPower   = false;
+    bool     lightSleep = false;
+    uint64_t startUs    = 0;
+    uint64_t busyUs     = 0;
+    uint32_t wakes[(int)PowerTask::COUNT] = {};
+    mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    bool configureLightSleep();
+};
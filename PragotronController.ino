@@ -6,12 +6,23 @@
  * System, Web) and orchestrates the device lifecycle:
  *   1) Initialize SD card (for config/log/state)
  *   2) Load configuration from /config.json
- *   3) Bring up Wi-Fi (so NTP can work)
+ *   3) Start Wi-Fi association (not awaited; NTP and the web UI follow once
+ *      the station gets an IP)
  *   4) Start Logger (timestamps will be corrected once SystemManager sets time)
- *   5) Initialize State manager (HH:MM persisted in /state.txt)
+ *   5) Initialize State manager (HH:MM committed to DS1307 NVRAM, journaled in
+ *      /state.jnl every 15 min, legacy /state.txt)
  *   6) Initialize Pulse outputs that drive the clock coils
- *   7) Initialize SystemManager (catch-up, minute ticks, NTP/TZ, etc.)
- *   8) If online, start the embedded Web UI and register callbacks
+ *   7) Initialize SystemManager (catch-up, minute ticks, NTP/TZ, etc.) — the
+ *      clock runs from the RTC and persisted state right away; NTP corrections
+ *      arrive later through the re-sync path
+ *   8) Start the embedded Web UI and register callbacks, and fleet mode
+ *      (UDP multicast time sharing between controllers, if configured)
+ *   9) Start the two runtime tasks:
+ *        - clock task (core 1, high priority): minute detection, catch-up,
+ *          pulse driving — SystemManager::loop()
+ *        - net task (core 0): web serving, NTP re-sync, fleet beacons,
+ *          log/state SD writes, log retention
+ *      They only communicate through FreeRTOS queues.
  *
  * Notes:
  * - Keep pin assignments in sync with your hardware.
@@ -23,7 +34,8 @@
  * - ESP32 Arduino core
  * - SD (SPI) support for the selected board
  * - Project-local managers: ConfigManager, Logger, RTCManager, StateManager,
- *   PulseManager, SystemManager, WebServerManager
+ *   PulseManager, SystemManager, WebServerManager, PowerManager, EventManager,
+ *   LogRetention, FleetManager
  */
 
 #include <WiFi.h>
@@ -35,6 +47,13 @@
 #include "PulseManager.h"
 #include "SystemManager.h"
 #include "WebServerManager.h"
+#include "PowerManager.h"
+#include "EventManager.h"
+#include "LogRetention.h"
+#include "EventLog.h"
+#include "Metrics.h"
+#include "FleetManager.h"
+#include "NetWake.h"
 
 // ──────────────────────────────────────────────────────────────────────────────
 // GPIO configuration
@@ -46,26 +65,114 @@
 // SD card chip-select pin (set to match your board/shield).
 #define SD_CS   5
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Task layout
+// The clock engine owns core 1 at a priority above the Arduino loop task; all
+// network and SD work lives on core 0 next to the Wi-Fi/lwIP stack.
+#define CLOCK_TASK_CORE    1
+#define CLOCK_TASK_PRIO    5
+#define CLOCK_TASK_STACK   8192
+#define NET_TASK_CORE      0
+#define NET_TASK_PRIO      2
+#define NET_TASK_STACK     12288
+
 // ──────────────────────────────────────────────────────────────────────────────
 // Global instances (lifetime = whole program)
 ConfigManager     configManager;
 Logger            logger;
+EventManager      eventManager;                  // live feed for /api/events
+LogRetention      logRetention(&configManager, &logger);
+EventLog          eventLog;                      // binary pulse/catch-up records (/logs/*.evl)
 RTCManager        rtcManager;
-StateManager      stateManager;
-PulseManager      pulseManager(PIN_IN1, PIN_IN2);
+PowerManager      powerManager(&configManager, &logger);
+StateManager      stateManagers[MAX_CHANNELS];   // [0] = main line (/state.*)
+PulseManager*     pulseManagers[MAX_CHANNELS] = {}; // created per config.channels
+int               channelCount     = 1;
 
 // Allocated dynamically to control construction order and pass references.
 SystemManager*    systemManager    = nullptr;
 WebServerManager* webServerManager = nullptr;
+FleetManager*     fleetManager     = nullptr;   // only with fleet_mode != "off"
 
 /**
  * @brief Web callback adapter: called when user sets time manually (HH:MM).
+ * @param channel Clock line index (0 = main).
  * @param minutes Minutes since 00:00 (0..1439) to set the clock to.
+ * @return Catch-up plan from the clock engine.
  *
  * Thin thunk to avoid exposing SystemManager directly to the web module.
+ * The sync backend (network task) waits briefly for the engine's plan; the
+ * async one runs on the AsyncTCP task, which must not block, so it answers
+ * "queued" and the plan follows on /api/events.
  */
-static void OnClockSetThunk(int minutes) {
-  if (systemManager) systemManager->OnManualClockSet(minutes);
+static CatchUpPlan OnClockSetThunk(int channel, int minutes) {
+  if (systemManager) return systemManager->OnManualClockSet(channel, minutes, WEB_ASYNC ? 0 : 200);
+  return CatchUpPlan();
+}
+
+/**
+ * @brief Web status adapter: live catch-up progress of one channel.
+ */
+static bool CatchUpStatusThunk(int channel, CatchUpStatus& out) {
+  if (systemManager) return systemManager->catchUpStatus(channel, out);
+  return false;
+}
+
+/**
+ * @brief Wi-Fi event adapter (Wi-Fi event task): report the link and let the
+ *        pending NTP sync go out immediately.
+ */
+static void OnWiFiGotIp(WiFiEvent_t /*event*/) {
+  Serial.println("📶 Pripojený k WiFi: " + WiFi.SSID());
+  Serial.println("🌐 IP adresa: " + WiFi.localIP().toString());
+  if (systemManager) systemManager->onNetworkUp();
+  NetWake::notify();
+}
+
+/**
+ * @brief Clock engine task: minute ticks, catch-up and pulse edges.
+ *
+ * Never blocks on SD or network. Sleeps until the engine's next deadline
+ * (minute edge, catch-up step, 1 ms while a loop-timed pulse is in flight);
+ * manual-set commands and NTP results wake it early via task notification.
+ */
+static void ClockTask(void* /*arg*/) {
+  systemManager->attachEngineTask(xTaskGetCurrentTaskHandle());
+  for (;;) {
+    const uint32_t t0 = micros();
+    systemManager->loop();
+    const uint32_t busyUs = micros() - t0;
+    powerManager.taskRan(PowerTask::CLOCK, busyUs);
+    Metrics::observe(Latency::CLOCK_LOOP_US, busyUs);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(systemManager->idleWaitMs()));
+  }
+}
+
+/**
+ * @brief Network / I-O task: HTTP, NTP re-sync, fleet, deferred SD writes and log retention.
+ *
+ * Sleeps up to PowerManager::netPollMs() (20 ms, 250 ms in low-power mode so
+ * light sleep gets long gaps), less when a fleet beacon or retention step is
+ * due. Queued state saves, live events and full log rings wake it early via
+ * task notification (NetWake).
+ */
+static void NetTask(void* /*arg*/) {
+  NetWake::attach(xTaskGetCurrentTaskHandle());
+  for (;;) {
+    const uint32_t t0 = micros();
+    if (webServerManager) webServerManager->handleClient();
+    systemManager->serviceNetwork();
+    if (fleetManager) fleetManager->service();
+    logger.service();
+    eventLog.service();
+    logRetention.service();
+    for (int i = 0; i < channelCount; i++) stateManagers[i].service();
+    powerManager.taskRan(PowerTask::NET, micros() - t0);
+
+    uint32_t waitMs = min(powerManager.netPollMs(), logRetention.idleWaitMs());
+    if (fleetManager) waitMs = min(waitMs, fleetManager->idleWaitMs());
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+  }
 }
 
 /**
@@ -74,10 +181,11 @@ static void OnClockSetThunk(int minutes) {
  * Order matters:
  *  - SD first (so config/log/state can mount),
  *  - then Config (to know Wi-Fi/NTP/etc.),
- *  - then Wi-Fi (required for NTP),
+ *  - then Wi-Fi association (required for NTP; runs in the background),
  *  - then Logger (SystemManager will soon correct time via NTP),
- *  - then State/Pulse/System,
- *  - finally Web (if Wi-Fi connected).
+ *  - then State/Pulse/System (starts from the RTC — nothing here waits for the network),
+ *  - then Web (serves as soon as the station has an IP),
+ *  - finally the clock and net tasks (SD writes become deferred from here on).
  */
 void setup() {
   Serial.begin(115200);
@@ -93,58 +201,77 @@ void setup() {
   // 2) Configuration
   configManager.begin("/config.json");
 
-  // 3) Wi-Fi (needed for NTP time sync)
+  // 3) Wi-Fi (needed for NTP time sync) — association continues in the background
+  WiFi.onEvent(OnWiFiGotIp, ARDUINO_EVENT_WIFI_STA_GOT_IP);
   WiFi.begin(
-    configManager.getConfig().wifiSsid.c_str(),
-    configManager.getConfig().wifiPassword.c_str()
+    configManager.getConfig().wifiSsid,
+    configManager.getConfig().wifiPassword
   );
-  int tries = 0;
-  while (WiFi.status() != WL_CONNECTED && tries++ < 20) {
-    delay(500);
-    Serial.print(".");
-  }
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\n📶 Pripojený k WiFi: " + WiFi.SSID());
-    Serial.println("🌐 IP adresa: " + WiFi.localIP().toString());
-  } else {
-    Serial.println("\n⚠️ WiFi nepripojené, NTP teraz neprebehne.");
-  }
 
   // 4) Logger (timestamps will be corrected once SystemManager sets time)
   logger.begin("/logs", configManager.getConfig().debugSerial);
   logger.info("🚀 PragotronController štartuje...");
+  eventManager.begin();
+  logger.setEventSink(&eventManager);
 
-  // 5) State Manager
-  stateManager.begin("/state.txt");
-
-  // 6) Pulse Manager
-  pulseManager.begin();
+  // 5) State + Pulse Managers, one per clock line (channel 0 keeps the legacy files/pins)
+  const auto& cfg = configManager.getConfig();
+  channelCount = cfg.channelCount;
+  for (int i = 0; i < channelCount; i++) {
+    const ChannelConfig& chc = cfg.channels[i];
+    if (i == 0) {
+      stateManagers[i].begin("/state.txt", "/state.jnl");
+    } else {
+      char txt[16], jnl[16];
+      snprintf(txt, sizeof(txt), "/state%d.txt", i);
+      snprintf(jnl, sizeof(jnl), "/state%d.jnl", i);
+      stateManagers[i].begin(txt, jnl);
+    }
+    stateManagers[i].setNvram(&rtcManager, (uint8_t)i);   // brown-out-safe copy; SD every 15 min
+    pulseManagers[i] = new PulseManager(chc.pinIn1 >= 0 ? chc.pinIn1 : PIN_IN1,
+                                        chc.pinIn2 >= 0 ? chc.pinIn2 : PIN_IN2);
+    pulseManagers[i]->begin();
+  }
 
-  // 7) System Manager (handles TZ/RTC, NTP, catch-up, minute ticks, etc.)
+  // 6) System Manager (handles TZ/RTC, NTP, catch-up, minute ticks, etc.)
   systemManager = new SystemManager(
-    &configManager, &logger, &rtcManager, &pulseManager, &stateManager
+    &configManager, &logger, &rtcManager, pulseManagers, stateManagers, channelCount
   );
+  systemManager->setEventManager(&eventManager);
+  if (cfg.eventLog && eventLog.begin("/logs", &logger.index())) systemManager->setEventLog(&eventLog);
   systemManager->begin();
 
-  // 8) Web Server (optional, only if Wi-Fi is up)
-  if (WiFi.status() == WL_CONNECTED) {
-    webServerManager = new WebServerManager(&stateManager, &configManager, &rtcManager);
-    webServerManager->begin();
-    webServerManager->setOnClockSet(OnClockSetThunk);
+  // 7) Web Server (listens on all interfaces; reachable once Wi-Fi has an IP)
+  webServerManager = new WebServerManager(&stateManagers[0], &configManager, &rtcManager);
+  webServerManager->setEventManager(&eventManager);   // before begin(): registers /api/events
+  webServerManager->setLogIndex(&logger.index());
+  if (cfg.eventLog) webServerManager->setEventLog(&eventLog);
+  webServerManager->begin();
+  webServerManager->setOnClockSet(OnClockSetThunk);
+  webServerManager->setCatchUpStatusProvider(CatchUpStatusThunk);
+  webServerManager->setPowerManager(&powerManager);
+
+  // Fleet mode (socket joins the multicast group once Wi-Fi has an IP)
+  if (cfg.fleetMode != FleetMode::OFF) {
+    fleetManager = new FleetManager(&configManager, &logger, systemManager);
+    fleetManager->begin();
+    webServerManager->setFleetManager(fleetManager);
   }
+
+  // Power mode (after WiFi.begin() so modem sleep applies to the association)
+  powerManager.begin();
+
+  // 8) Runtime tasks
+  logger.startDeferred();
+  xTaskCreatePinnedToCore(ClockTask, "clock", CLOCK_TASK_STACK, nullptr,
+                          CLOCK_TASK_PRIO, nullptr, CLOCK_TASK_CORE);
+  xTaskCreatePinnedToCore(NetTask, "net", NET_TASK_STACK, nullptr,
+                          NET_TASK_PRIO, nullptr, NET_TASK_CORE);
 }
 
 /**
- * @brief Arduino loop: delegate to SystemManager and WebServer.
- *
- * Keep the tick short to preserve catch-up timing accuracy.
+ * @brief Arduino loop: unused — all work runs in ClockTask / NetTask.
  */
 void loop() {
-  systemManager->loop();
-
-  // Handle incoming HTTP requests when Web UI is enabled.
-  if (webServerManager) webServerManager->handleClient();
-
-  // Short delay to allow other tasks to run and to keep timing responsive.
-  delay(20);
+  vTaskDelay(portMAX_DELAY);
 }
@@ -6,10 +6,24 @@
  * --------
  * - Alternates direction on each trigger (A then B then A ...).
  * - Enforces a minimal gap between pulses to avoid double-triggering.
- * - Provides configurable pulse duration and post-pulse dead-time.
+ * - Provides configurable pulse width and post-pulse dead-time (µs).
+ * - Never blocks: triggerPulse() starts the drive phase; the phase edges
+ *   DRIVE_A/B → COAST → READY are produced either by service() polling
+ *   micros() (LOOP backend) or by one-shot esp_timer alarms (ESP_TIMER).
+ *
+ * Notes
+ * -----
+ * - esp_timer callbacks run in the high-priority esp_timer task, so edge
+ *   jitter is in the tens of µs regardless of loop() cadence or SD/Wi-Fi load.
+ * - State shared with the timer callback is only written by one side per
+ *   phase: the caller owns IDLE/READY, the callback owns DRIVE/COAST.
+ * - Optional feedback: the coil current is sampled at the drive → coast edge
+ *   (before the bridge opens), a position sensor at the start of the drive
+ *   and at the coast → ready edge. The verdict is published with READY.
  */
 
 #include "PulseManager.h"
+#include "Metrics.h"
 
 PulseManager::PulseManager(int in1Pin, int in2Pin)
     : pinIn1(in1Pin), pinIn2(in2Pin) {}
@@ -27,6 +41,34 @@ void PulseManager::begin() {
     digitalWrite(pinIn2, LOW);
     lastWasA   = false;   // after startup, the first pulse will be A
     lastTrigMs = 0;
+    pulseState = PulseState::IDLE;
+}
+
+/**
+ * @brief Select the timing backend.
+ * @param b LOOP or ESP_TIMER.
+ * @return true if the backend is active; false if the esp_timer could not be
+ *         created (LOOP stays selected).
+ *
+ * Must not be called while a pulse is in flight.
+ */
+bool PulseManager::setBackend(PulseBackend b) {
+    if (busy()) return false;
+
+    if (b == PulseBackend::ESP_TIMER && !edgeTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback        = &PulseManager::onEdgeTimer;
+        args.arg             = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name            = "pulse_edge";
+        if (esp_timer_create(&args, &edgeTimer) != ESP_OK) {
+            edgeTimer    = nullptr;
+            pulseBackend = PulseBackend::LOOP;
+            return false;
+        }
+    }
+    pulseBackend = b;
+    return true;
 }
 
 /**
@@ -35,8 +77,17 @@ void PulseManager::begin() {
  * @param pauseAfterMs     Dead-time (coast) after each pulse.
  */
 void PulseManager::setImpulseTiming(int pulseDurationMs, int pauseAfterMs) {
-    durationMs = pulseDurationMs;
-    pauseMs    = pauseAfterMs;
+    setImpulseTimingUs((uint32_t)pulseDurationMs * 1000UL, (uint32_t)pauseAfterMs * 1000UL);
+}
+
+/**
+ * @brief Configure pulse waveform timing with microsecond resolution.
+ * @param widthUs     Active time the bridge drives one polarity.
+ * @param deadTimeUs  Dead-time (coast) after each pulse.
+ */
+void PulseManager::setImpulseTimingUs(uint32_t widthUs, uint32_t deadTimeUs) {
+    durationUs = widthUs;
+    pauseUs    = deadTimeUs;
 }
 
 /**
@@ -48,51 +99,152 @@ void PulseManager::setMinGapMs(uint32_t ms) {
 }
 
 /**
- * @brief Emit one pulse if allowed by anti-duplicate guard.
+ * @brief Start one pulse if the bridge is free and the anti-duplicate guard allows it.
  * @param allowBurst If true, bypass the min-gap guard.
- * @return true if a pulse was emitted; false if skipped by guard.
+ * @return true if a pulse was started; false if busy or skipped by guard.
  *
- * The required gap is max(minGapMs, durationMs + pauseMs + 50ms safety).
+ * The required gap is max(minGapMs, width + dead-time + 50ms safety),
+ * measured from the completion of the previous pulse.
  * On each accepted trigger, the direction alternates A/B.
  */
 bool PulseManager::triggerPulse(bool allowBurst) {
+    service();                 // fold any finished phase before deciding
+    if (busy()) {
+        Metrics::count(Metric::PULSES_SKIPPED_BUSY);
+        return false;
+    }
+
     const uint32_t now = millis();
 
     // If called too soon after the last pulse (and not in burst mode), skip.
-    const uint32_t requiredGap = max<uint32_t>(minGapMs, (uint32_t)(durationMs + pauseMs + 50));
+    const uint32_t cycleMs     = (durationUs + pauseUs) / 1000UL;
+    const uint32_t requiredGap = max<uint32_t>(minGapMs, cycleMs + 50);
     if (!allowBurst && (now - lastTrigMs) < requiredGap) {
         // Serial.printf("[PULSE] skipped duplicate (%lums < %lums)\n", now - lastTrigMs, requiredGap);
+        Metrics::count(Metric::PULSES_SKIPPED_GAP);
         return false;
     }
 
+    feedback = PulseFeedback::NONE;
+    if (sense == PulseSense::SENSOR) senseLevel = digitalRead(sensePin);
     if (lastWasA) pulseB(); else pulseA();
-    lastWasA   = !lastWasA;
-    lastTrigMs = millis();     // timestamp after the pulse completes
+    lastWasA = !lastWasA;
+    Metrics::count(Metric::PULSES);
 
-    // Dead-time is handled inside pulseA/pulseB (stopBridge + delay(pauseMs)).
+    // Drive end, dead-time and completion timestamp follow asynchronously.
     return true;
 }
 
 /**
- * @brief Drive polarity A: IN1=HIGH, IN2=LOW for durationMs, then coast.
+ * @brief Advance the pulse state machine (non-blocking).
+ *
+ * LOOP backend: DRIVE_A/B ends after the width (bridge → coast), COAST ends
+ * after the dead-time (completion timestamp taken).
+ * Both backends: READY falls back to IDLE once the min-gap window has elapsed.
+ */
+void PulseManager::service() {
+    if (pulseBackend == PulseBackend::LOOP) {
+        const uint32_t nowUs = micros();
+        switch (pulseState) {
+            case PulseState::DRIVE_A:
+            case PulseState::DRIVE_B:
+                if ((uint32_t)(nowUs - phaseStartUs) >= durationUs) endDrive();
+                break;
+            case PulseState::COAST:
+                if ((uint32_t)(nowUs - phaseStartUs) >= pauseUs) endCoast();
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (pulseState == PulseState::READY && (uint32_t)(millis() - lastTrigMs) >= minGapMs) {
+        pulseState = PulseState::IDLE;
+    }
+}
+
+/**
+ * @brief True while the bridge is driving or coasting.
+ */
+bool PulseManager::busy() const {
+    const PulseState s = pulseState;
+    return s == PulseState::DRIVE_A
+        || s == PulseState::DRIVE_B
+        || s == PulseState::COAST;
+}
+
+/**
+ * @brief Start polarity A: IN1=HIGH, IN2=LOW; the drive ends after the width.
  */
 void PulseManager::pulseA() {
     digitalWrite(pinIn1, HIGH);
     digitalWrite(pinIn2, LOW);
-    delay(durationMs);
-    stopBridge();              // coast
-    delay(pauseMs);            // dead-time
+    startPhase(PulseState::DRIVE_A);
 }
 
 /**
- * @brief Drive polarity B: IN1=LOW, IN2=HIGH for durationMs, then coast.
+ * @brief Start polarity B: IN1=LOW, IN2=HIGH; the drive ends after the width.
  */
 void PulseManager::pulseB() {
     digitalWrite(pinIn1, LOW);
     digitalWrite(pinIn2, HIGH);
-    delay(durationMs);
+    startPhase(PulseState::DRIVE_B);
+}
+
+/**
+ * @brief Enter a drive phase and arm the edge that will end it.
+ */
+void PulseManager::startPhase(PulseState drive) {
+    pulseState   = drive;
+    phaseStartUs = micros();
+    if (pulseBackend == PulseBackend::ESP_TIMER) {
+        esp_timer_start_once(edgeTimer, durationUs);
+    }
+}
+
+/**
+ * @brief Drive → coast transition.
+ */
+void PulseManager::endDrive() {
+    if (sense == PulseSense::CURRENT) feedbackSample = analogRead(sensePin);  // still driven
     stopBridge();              // coast
-    delay(pauseMs);            // dead-time
+    pulseState   = PulseState::COAST;
+    phaseStartUs = micros();
+    if (pulseBackend == PulseBackend::ESP_TIMER) {
+        esp_timer_start_once(edgeTimer, pauseUs);
+    }
+}
+
+/**
+ * @brief Coast → ready transition (pulse complete).
+ */
+void PulseManager::endCoast() {
+    lastTrigMs = millis();     // timestamp after the pulse completes
+    if (sense == PulseSense::CURRENT) {
+        feedback = feedbackSample >= senseThreshold ? PulseFeedback::OK : PulseFeedback::MISSED;
+    } else if (sense == PulseSense::SENSOR) {
+        feedbackSample = digitalRead(sensePin);
+        feedback = feedbackSample != senseLevel ? PulseFeedback::OK : PulseFeedback::MISSED;
+    }
+    pulseState = PulseState::READY;
+}
+
+/**
+ * @brief esp_timer alarm: advance DRIVE → COAST → READY.
+ */
+void PulseManager::onEdgeTimer(void* arg) {
+    PulseManager* self = static_cast<PulseManager*>(arg);
+    switch (self->pulseState) {
+        case PulseState::DRIVE_A:
+        case PulseState::DRIVE_B:
+            self->endDrive();
+            break;
+        case PulseState::COAST:
+            self->endCoast();
+            break;
+        default:
+            break;
+    }
 }
 
 /**
@@ -103,6 +255,33 @@ inline void PulseManager::stopBridge() {
     digitalWrite(pinIn2, LOW);
 }
 
-// Optional diagnostics / manual forcing
-void PulseManager::forceA() { pulseA(); }
-void PulseManager::forceB() { pulseB(); }
+/**
+ * @brief Restore which polarity moved the dial last.
+ *
+ * A polarized movement ignores a pulse of the same polarity as the previous
+ * one, so the alternation must continue across power cuts rather than
+ * restarting with A.
+ */
+void PulseManager::setLastPolarity(bool wasA) {
+    if (!busy()) lastWasA = wasA;
+}
+
+/**
+ * @brief Select the feedback input that verifies each step.
+ *
+ * CURRENT needs an ADC-capable pin; SENSOR enables the internal pull-up
+ * (GPIO34..39 have none and need an external one).
+ */
+void PulseManager::setFeedback(PulseSense s, int pin, int threshold) {
+    if (busy()) return;
+    sense          = (pin >= 0) ? s : PulseSense::NONE;
+    sensePin       = pin;
+    senseThreshold = threshold;
+    feedback       = PulseFeedback::NONE;
+    if (sense == PulseSense::SENSOR)  pinMode(sensePin, INPUT_PULLUP);
+    if (sense == PulseSense::CURRENT) pinMode(sensePin, INPUT);
+}
+
+// Optional diagnostics / manual forcing (ignored while a pulse is in flight)
+void PulseManager::forceA() { if (!busy()) pulseA(); }
+void PulseManager::forceB() { if (!busy()) pulseB(); }
@@ -5,17 +5,86 @@
 
 #pragma once
 #include <Arduino.h>
+#include <esp_timer.h>
+
+/**
+ * @enum PulseState
+ * @brief Phases of the cooperative pulse engine.
+ *
+ * IDLE → DRIVE_A/DRIVE_B → COAST → READY → IDLE
+ *  - DRIVE_A/B: bridge drives one polarity for the pulse width.
+ *  - COAST:     both legs LOW for the dead-time.
+ *  - READY:     waveform finished; bridge free, min-gap window still running.
+ */
+enum class PulseState : uint8_t {
+    IDLE,
+    DRIVE_A,
+    DRIVE_B,
+    COAST,
+    READY
+};
+
+/**
+ * @enum PulseBackend
+ * @brief Who times the drive/dead-time edges.
+ *
+ *  - LOOP:      service() compares micros() on every loop() iteration.
+ *  - ESP_TIMER: one-shot esp_timer alarms end each phase (µs resolution,
+ *               independent of loop() cadence).
+ */
+enum class PulseBackend : uint8_t {
+    LOOP,
+    ESP_TIMER
+};
+
+/**
+ * @enum PulseSense
+ * @brief Optional input that tells whether a pulse moved the dial.
+ *
+ *  - NONE:    open loop; every pulse is assumed to have stepped.
+ *  - CURRENT: coil-current sense (shunt/driver output) on an ADC pin, sampled
+ *             right before the drive ends; below the threshold → no step.
+ *  - SENSOR:  dial position sensor on a GPIO that toggles once per step
+ *             (cam switch, reed, opto on the star wheel); read before the
+ *             drive and after the dead-time, unchanged level → no step.
+ */
+enum class PulseSense : uint8_t {
+    NONE,
+    CURRENT,
+    SENSOR
+};
+
+/**
+ * @enum PulseFeedback
+ * @brief Verdict on the last completed pulse.
+ */
+enum class PulseFeedback : uint8_t {
+    NONE,     ///< No feedback configured, or the pulse is still in flight.
+    OK,       ///< Step confirmed.
+    MISSED    ///< The dial did not move; the caller retries with the same polarity.
+};
 
 /**
  * @class PulseManager
  * @brief Drives two GPIO pins as an H-bridge to generate alternating pulses.
  *
+ * The waveform is generated without blocking: triggerPulse() only starts the
+ * drive phase and returns immediately. With the LOOP backend, service() must
+ * be called frequently (every loop) to end the drive and dead-time phases;
+ * with the ESP_TIMER backend the edges come from esp_timer and service()
+ * only retires the min-gap window.
+ *
  * Usage:
  *   PulseManager pm(IN1, IN2);
  *   pm.begin();
- *   pm.setImpulseTiming(200, 200);
+ *   pm.setBackend(PulseBackend::ESP_TIMER);
+ *   pm.setImpulseTimingUs(200000, 150000);
  *   pm.setMinGapMs(600);
+ *   pm.setFeedback(PulseSense::SENSOR, SENSE_PIN);   // optional
  *   pm.triggerPulse();           // emits A (first), next call emits B, etc.
+ *   ...
+ *   pm.service();                // in loop()
+ *   if (!pm.busy() && pm.lastFeedback() == PulseFeedback::MISSED) ...
  */
 class PulseManager {
 public:
@@ -29,19 +98,67 @@ public:
     /// Initialize pins (set as outputs, LOW) and reset internal state.
     void begin();
 
+    /// Select the timing backend (creates the esp_timer on first use).
+    bool setBackend(PulseBackend b);
+
+    /// Active timing backend.
+    PulseBackend backend() const { return pulseBackend; }
+
     /// Configure pulse duration and post-pulse dead-time (milliseconds).
     void setImpulseTiming(int pulseDurationMs, int pauseAfterMs);
 
+    /// Configure pulse width and post-pulse dead-time (microseconds).
+    void setImpulseTimingUs(uint32_t widthUs, uint32_t deadTimeUs);
+
     /// Set minimum gap between pulses to avoid double-triggering.
     void setMinGapMs(uint32_t ms);                 // minimum spacing between pulses
 
+    /// Resume the alternation after a restart: the next pulse is B if @p wasA.
+    /// Ignored while a pulse is in flight.
+    void setLastPolarity(bool wasA);
+
     /**
-     * @brief Trigger one pulse if guard permits.
+     * @brief Verify each pulse on an input pin (ignored while a pulse is in flight).
+     * @param sense     NONE, CURRENT (ADC) or SENSOR (digital, pulled up).
+     * @param pin       Input GPIO; ignored for NONE.
+     * @param threshold CURRENT: minimum ADC reading that counts as a driven coil.
+     */
+    void setFeedback(PulseSense sense, int pin, int threshold = 0);
+
+    /// Configured feedback input.
+    PulseSense feedbackSense() const { return sense; }
+
+    /// Verdict on the last pulse once it has completed (NONE while busy()).
+    PulseFeedback lastFeedback() const { return busy() ? PulseFeedback::NONE : feedback; }
+
+    /// Last raw reading (CURRENT: ADC counts late in the drive; SENSOR: level after the pulse).
+    int lastFeedbackSample() const { return feedbackSample; }
+
+    /**
+     * @brief Start one pulse if the bridge is free and the guard permits.
      * @param allowBurst If true, ignore the min-gap guard.
-     * @return true if a pulse was generated, false if skipped.
+     * @return true if a pulse was started, false if skipped (busy or guard).
      */
     bool triggerPulse(bool allowBurst = false);
 
+    /// Advance the waveform state machine; call from every loop() iteration.
+    void service();
+
+    /// True while a pulse is driving or in its dead-time (bridge not free).
+    bool busy() const;
+
+    /// True if the caller must poll service() quickly (LOOP backend mid-pulse).
+    bool needsFastService() const { return pulseBackend == PulseBackend::LOOP && busy(); }
+
+    /// Current engine phase (diagnostics).
+    PulseState state() const { return pulseState; }
+
+    /// True while the coil is energized (drive phase; dead-time excluded).
+    bool driving() const { return pulseState == PulseState::DRIVE_A || pulseState == PulseState::DRIVE_B; }
+
+    /// millis() timestamp at which the last pulse finished its dead-time.
+    uint32_t lastPulseEndMs() const { return lastTrigMs; }
+
     // Optional: direct polarity control for diagnostics.
     void forceA();
     void forceB();
@@ -51,17 +168,35 @@ private:
     int pinIn1;
     int pinIn2;
 
-    // ── Timing (ms) ─────────────────────────────────────────────────────────
-    int durationMs = 200;      ///< Active drive time per pulse.
-    int pauseMs    = 200;      ///< Dead-time/coast after each pulse.
+    // ── Timing (µs) ─────────────────────────────────────────────────────────
+    uint32_t durationUs = 200000;   ///< Active drive time per pulse.
+    uint32_t pauseUs    = 200000;   ///< Dead-time/coast after each pulse.
+
+    // ── State (written from esp_timer task with the ESP_TIMER backend) ───────
+    bool                lastWasA     = false;   ///< false means last was B → next will be A.
+    volatile uint32_t   lastTrigMs   = 0;       ///< Timestamp of last pulse completion.
+    uint32_t            minGapMs     = 600;     ///< Anti-duplicate guard (default).
+    volatile PulseState pulseState   = PulseState::IDLE;
+    uint32_t            phaseStartUs = 0;       ///< micros() when the current phase began (LOOP).
+
+    // ── Feedback (sampled in the phase that owns the state, see .cpp notes) ─
+    PulseSense             sense          = PulseSense::NONE;
+    int                    sensePin       = -1;
+    int                    senseThreshold = 0;
+    int                    senseLevel     = 0;                  ///< SENSOR: level before the drive.
+    volatile int           feedbackSample = 0;
+    volatile PulseFeedback feedback       = PulseFeedback::NONE;
 
-    // ── State ────────────────────────────────────────────────────────────────
-    bool     lastWasA    = false;   ///< false means last was B → next will be A.
-    uint32_t lastTrigMs  = 0;       ///< Timestamp of last pulse completion.
-    uint32_t minGapMs    = 600;     ///< Anti-duplicate guard (default).
+    // ── Backend ─────────────────────────────────────────────────────────────
+    PulseBackend       pulseBackend = PulseBackend::LOOP;
+    esp_timer_handle_t edgeTimer    = nullptr;
 
     // ── Internals ───────────────────────────────────────────────────────────
     void   pulseA();
     void   pulseB();
+    void   startPhase(PulseState drive);
+    void   endDrive();
+    void   endCoast();
     inline void stopBridge();
+    static void onEdgeTimer(void* arg);   ///< esp_timer callback (ESP_TIMER backend).
 };
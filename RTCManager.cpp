@@ -3,51 +3,54 @@
  * @brief   RTC + timezone/NTP orchestration for ESP32 with DS1307 (local time).
  *
  * Key rule:
- * - AUTO (s NTP): systémový čas nastavuje SNTP. NEPREPISUJ ho z RTC.
+ * - AUTO (s NTP): štart z RTC (applyRtcToSystemClock()), potom systémový čas
+ *   nastavuje SNTP na pozadí. Po štarte ho už NEPREPISUJ z RTC.
  * - MANUAL alebo offline fallback: systém nastav z RTC (applyRtcToSystemClock()).
  */
 
 #include "RTCManager.h"
+#include "TimeSource.h"
+#include "Metrics.h"
 #include <sys/time.h>
 #include <time.h>
+#include <esp_sntp.h>
+#include <Preferences.h>
+#include <math.h>
+
+volatile bool RTCManager::sntpNotified = false;
+
+/// Current UTC offset of local time in seconds (DST included).
+static long utcOffsetNow() {
+    time_t t = time(nullptr);
+    tm lt;
+    localtime_r(&t, &lt);
+    const DateTime local(lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
+                         lt.tm_hour, lt.tm_min, lt.tm_sec);
+    return (long)local.unixtime() - (long)t;
+}
+
+/**
+ * @brief SNTP time-sync notification (lwIP/SNTP task context): just flag it.
+ */
+void RTCManager::onSntpSync(struct timeval* /*tv*/) {
+    sntpNotified = true;
+}
 
 // ---------------- BEGIN: overloads ----------------
 
 /**
  * @brief Initialize RTC + NTP using an explicit POSIX TZ string.
+ *
+ * Never waits for the network: the system clock starts from the RTC and
+ * SNTP corrects it in the background (see startNtpSync()).
  */
 bool RTCManager::begin(const char* ntpServer, const char* posixTz) {
     rtcOk = rtc.begin();
     if (!rtcOk) { Serial.println("❌ RTC not found."); return false; }
+    loadDriftModel();
 
+    startFromRtc(posixTz);
     setupNtpWithPosix(ntpServer, posixTz);
-
-    if (!rtc.isrunning()) {
-        Serial.println("⚠️ RTC was not running, setting build time.");
-        rtc.adjust(DateTime(__DATE__, __TIME__)); // local fallback
-    }
-
-    Serial.printf("🌐 Requesting NTP time from '%s'...\n", ntpServer);
-    DateTime ntp = getNtpTime(7000);
-
-    if (ntp.year() >= 2020) {
-        char buf[32];
-        snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
-                 ntp.year(), ntp.month(), ntp.day(), ntp.hour(), ntp.minute(), ntp.second());
-        Serial.printf("✅ NTP replied with LOCAL time: %s\n", buf);
-
-        // Update RTC cache for offline starts
-        rtc.adjust(ntp);
-        Serial.println("🕒 RTC updated from NTP (local time stored).");
-
-        // ❌ Do NOT apply RTC -> system clock here (AUTO path). SNTP already set system time.
-        // applyRtcToSystemClock();
-    } else {
-        Serial.println("⚠️ NTP not available, keeping RTC time.");
-        // Offline fallback: set system time from RTC so logs/localtime() make sense
-        applyRtcToSystemClock();
-    }
-
     return true;
 }
 
@@ -60,43 +63,41 @@ bool RTCManager::begin(const char* ntpServer, int timeZoneOffsetHrs, bool useEUD
 
 /**
  * @brief Initialize with fixed offset (hrs + minutes) and EU DST toggle.
+ *
+ * Same fast start as the POSIX overload.
  */
 bool RTCManager::begin(const char* ntpServer, int timeZoneOffsetHrs, bool useEUDst, int offsetMinutes) {
     rtcOk = rtc.begin();
     if (!rtcOk) { Serial.println("❌ RTC not found."); return false; }
+    loadDriftModel();
 
+    startFromRtc(buildTZ(timeZoneOffsetHrs, offsetMinutes, useEUDst).c_str());
     setupNtp(ntpServer, timeZoneOffsetHrs, useEUDst, offsetMinutes);
+    return true;
+}
 
-    if (!rtc.isrunning()) {
-        Serial.println("⚠️ RTC was not running, setting build time.");
-        rtc.adjust(DateTime(__DATE__, __TIME__));
-    }
-
-    Serial.printf("🌐 Requesting NTP time from '%s'...\n", ntpServer);
-    DateTime ntp = getNtpTime(7000);
-
-    if (ntp.year() >= 2020) {
-        char buf[32];
-        snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
-                 ntp.year(), ntp.month(), ntp.day(), ntp.hour(), ntp.minute(), ntp.second());
-        Serial.printf("✅ NTP replied with LOCAL time: %s\n", buf);
+// ---------------- END: overloads ----------------
 
-        rtc.adjust(ntp);
-        Serial.println("🕒 RTC updated from NTP (local time stored).");
+/**
+ * @brief AUTO boot: set TZ and run the system clock from the RTC until SNTP answers.
+ *
+ * Called before SNTP is configured, so an early reply cannot be overwritten
+ * by the RTC. The first NTP result is measured against this RTC start by the
+ * caller's async session; a real correction then re-runs the catch-up.
+ */
+void RTCManager::startFromRtc(const char* posixTz) {
+    setenv("TZ", posixTz, 1);
+    tzset();
 
-        // ❌ Do NOT overwrite system time from RTC when NTP succeeded.
-        // applyRtcToSystemClock();
-    } else {
-        Serial.println("⚠️ NTP not available, keeping RTC time.");
-        // Offline fallback
-        applyRtcToSystemClock();
+    if (!rtc.isrunning()) {
+        Serial.println("⚠️ RTC was not running, setting build time.");
+        adjustRtc(DateTime(__DATE__, __TIME__)); // local fallback
     }
-
-    return true;
+    // ✅ Start from RTC; SNTP overwrites the system clock once it replies
+    applyRtcToSystemClock();
+    Serial.println("⏱️ Running on RTC time; NTP follows in the background.");
 }
 
-// ---------------- END: overloads ----------------
-
 /**
  * @brief Legacy convenience: offset in hours, EU DST assumed true for SK/Europe.
  */
@@ -114,6 +115,7 @@ bool RTCManager::begin(const char* ntpServer, int timeZoneOffsetHrs) {
 bool RTCManager::beginManual(const char* posixTz) { // MANUAL path keeps applyRtcToSystemClock()
     rtcOk = rtc.begin();
     if (!rtcOk) { Serial.println("❌ RTC not found."); return false; }
+    loadDriftModel();   // rate learned during earlier AUTO runs still applies
 
     setenv("TZ", posixTz, 1);
     tzset();
@@ -130,7 +132,7 @@ bool RTCManager::beginManual(const char* posixTz) { // MANUAL path keeps applyRt
 
     if (!rtc.isrunning()) {
         Serial.println("⚠️ (MANUAL) RTC was not running, setting build time.");
-        rtc.adjust(DateTime(__DATE__, __TIME__));
+        adjustRtc(DateTime(__DATE__, __TIME__));
     }
 
     // ✅ In MANUAL, system clock comes from RTC
@@ -151,6 +153,7 @@ bool RTCManager::beginManual(int timeZoneOffsetHrs, bool useEUDst, int offsetMin
  */
 bool RTCManager::setupNtpWithPosix(const char* ntpServer, const char* posixTz) {
     configTzTime(posixTz, ntpServer, "time.nist.gov", "pool.ntp.org");
+    sntp_set_time_sync_notification_cb(&RTCManager::onSntpSync);
 
     // Verify
     time_t nowEpoch = time(nullptr);
@@ -172,6 +175,7 @@ bool RTCManager::setupNtpWithPosix(const char* ntpServer, const char* posixTz) {
 bool RTCManager::setupNtp(const char* ntpServer, int offsetHrs, bool useEUDst, int offsetMinutes) {
     String tz = buildTZ(offsetHrs, offsetMinutes, useEUDst);
     configTzTime(tz.c_str(), ntpServer, "time.nist.gov", "pool.ntp.org");
+    sntp_set_time_sync_notification_cb(&RTCManager::onSntpSync);
 
     // Verify
     time_t nowEpoch = time(nullptr);
@@ -204,16 +208,41 @@ String RTCManager::buildTZ(int offsetHours, int offsetMinutes, bool useEUDst) {
     return String(buf);
 }
 
-/** @brief Current DS1307 datetime (local time). */
-DateTime RTCManager::now() { return rtc.now(); }
+/**
+ * @brief Current DS1307 datetime (local time), corrected by the drift model.
+ */
+DateTime RTCManager::now() {
+    DateTime raw = rtc.now();
+    const long corr = lroundf(predictOffsetSec(raw.unixtime()));
+    return corr ? raw - TimeSpan((int32_t)corr) : raw;
+}
+
+/** @brief Uncorrected DS1307 datetime (local time). */
+DateTime RTCManager::rawNow() { return rtc.now(); }
 
 /** @brief True if RTC hardware responded during initialization. */
 bool RTCManager::isRtcAvailable() const { return rtcOk; }
 
-/** @brief Write a local datetime to the RTC. */
+/** @brief Read @p len bytes of DS1307 NVRAM at @p addr (survives power cuts on the battery). */
+bool RTCManager::readNvram(uint8_t addr, uint8_t* buf, uint8_t len) {
+    if (!rtcOk || addr + len > NVRAM_SIZE) return false;
+    rtc.readnvram(buf, len, addr);
+    return true;
+}
+
+/** @brief Write @p len bytes of DS1307 NVRAM at @p addr (one I2C transaction, ~1 ms). */
+bool RTCManager::writeNvram(uint8_t addr, const uint8_t* buf, uint8_t len) {
+    if (!rtcOk || addr + len > NVRAM_SIZE) return false;
+    rtc.writenvram(addr, buf, len);
+    return true;
+}
+
+/** @brief Write a local datetime to the RTC (restarts the drift baseline). */
 bool RTCManager::adjustRtc(const DateTime& dt) {
     if (!rtcOk) return false;
     rtc.adjust(dt);
+    rebaseDrift(dt.unixtime(), 0.0f);
+    saveDriftModel();
     return true;
 }
 
@@ -256,14 +285,27 @@ DateTime RTCManager::getNtpTime(uint32_t timeoutMs) {
  */
 bool RTCManager::syncWithNtp(int maxAllowedDiffSec) {
     Serial.println("🔄 Syncing with NTP...");
+    const uint32_t t0 = millis();
     DateTime ntp = getNtpTime(5000);
     if (ntp.year() < 2020) {
         Serial.println("⚠️ NTP sync failed.");
+        Metrics::count(Metric::NTP_FAILED);
         return false;
     }
+    Metrics::count(Metric::NTP_OK);
+    Metrics::observe(Latency::NTP_SYNC_MS, millis() - t0);
 
-    DateTime rtcLocal = now();
-    long diff = labs((long)(ntp.unixtime() - rtcLocal.unixtime()));
+    return checkRtcDrift(ntp, maxAllowedDiffSec);
+}
+
+/**
+ * @brief Compare a fresh NTP local time with the RTC and refresh the RTC cache
+ *        if the drift exceeds the threshold (system time is left untouched).
+ */
+bool RTCManager::checkRtcDrift(const DateTime& ntp, int maxAllowedDiffSec) {
+    DateTime rtcLocal = rawNow();
+    const float residual = updateDriftModel(ntp, rtcLocal);
+    long diff = labs((long)(int32_t)(ntp.unixtime() - rtcLocal.unixtime()));
 
     char bufNtp[32], bufRtc[32];
     snprintf(bufNtp, sizeof(bufNtp), "%04d-%02d-%02d %02d:%02d:%02d",
@@ -275,10 +317,17 @@ bool RTCManager::syncWithNtp(int maxAllowedDiffSec) {
     Serial.printf("📡 NTP time: %s\n", bufNtp);
     Serial.printf("⌛ RTC time: %s\n", bufRtc);
     Serial.printf("🔍 Drift: %ld sec (max allowed %d sec)\n", diff, maxAllowedDiffSec);
+    if (drift.errPpm > 0.0f) {
+        Serial.printf("📈 RTC rate: %+.2f ppm (±%.2f), prediction error %.1f s\n",
+                      drift.ppm, drift.errPpm, isnan(residual) ? 0.0f : residual);
+    }
+    adaptNtpPoll(true, residual);
+    Metrics::setGauge(Gauge::RTC_OFFSET_S, (float)diff);
+    if (drift.errPpm > 0.0f) Metrics::setGauge(Gauge::RTC_DRIFT_PPM, drift.ppm);
 
     if (diff > maxAllowedDiffSec) {
         Serial.println("⚠️ Drift too big → updating RTC from NTP.");
-        rtc.adjust(ntp);          // update RTC cache
+        setRtcFromNtp(ntp);       // update RTC cache
         // ❌ do NOT call applyRtcToSystemClock() here
         return true;
     }
@@ -287,14 +336,101 @@ bool RTCManager::syncWithNtp(int maxAllowedDiffSec) {
     return true;
 }
 
+/**
+ * @brief Compare the system clock with the RTC as if it were a fresh NTP
+ *        reading (fleet followers get their time from the leader's beacons).
+ */
+bool RTCManager::refreshRtcFromSystemClock(int maxAllowedDiffSec) {
+    if (!rtcOk || !TimeSource::isValid()) return false;
+    return checkRtcDrift(TimeSource::localNow(), maxAllowedDiffSec);
+}
+
+/**
+ * @brief Start an asynchronous NTP sync; returns immediately.
+ * @param timeoutMs How long pollNtpSync() waits before reporting FAILED.
+ * @return false if SNTP is not running (e.g. MANUAL mode) — nothing started.
+ *
+ * Clears the notification flag and asks SNTP for an immediate request; the
+ * SNTP callback flags completion once the system clock has been set.
+ */
+bool RTCManager::startNtpSync(uint32_t timeoutMs) {
+    if (ntpState == NtpSyncStatus::PENDING) return true;
+    if (!sntp_enabled()) return false;
+
+    Serial.println("🔄 Syncing with NTP (async)...");
+    sntpNotified = false;
+    ntpStartMs   = millis();
+    ntpTimeoutMs = timeoutMs;
+    ntpState     = NtpSyncStatus::PENDING;
+    sntp_restart();
+    return true;
+}
+
+/**
+ * @brief Re-send the pending SNTP request (e.g. right after Wi-Fi got an IP).
+ *
+ * The session's timeout keeps running; without a pending session nothing happens.
+ */
+void RTCManager::kickNtpSync() {
+    if (ntpState != NtpSyncStatus::PENDING || !sntp_enabled()) return;
+    sntp_restart();
+}
+
+/**
+ * @brief Stop SNTP's background polling while another source keeps time
+ *        (fleet follower), and resume it afterwards.
+ *
+ * Only undoes its own stop: with SNTP never set up (MANUAL) nothing starts.
+ */
+void RTCManager::setNtpPaused(bool paused) {
+    if (paused) {
+        if (!sntp_enabled()) return;
+        sntp_stop();
+        ntpPaused = true;
+        Serial.println("⏸️ SNTP paused (fleet time).");
+    } else if (ntpPaused) {
+        ntpPaused = false;
+        sntp_init();
+        Serial.println("▶️ SNTP resumed.");
+    }
+}
+
+/**
+ * @brief Poll the async NTP sync started by startNtpSync().
+ * @param maxAllowedDiffSec RTC drift threshold applied when the sync completes.
+ * @return PENDING while waiting; DONE/FAILED exactly once, then IDLE.
+ */
+NtpSyncStatus RTCManager::pollNtpSync(int maxAllowedDiffSec) {
+    if (ntpState != NtpSyncStatus::PENDING) return NtpSyncStatus::IDLE;
+
+    if (sntpNotified) {
+        sntpNotified = false;
+        ntpState     = NtpSyncStatus::IDLE;
+        Metrics::count(Metric::NTP_OK);
+        Metrics::observe(Latency::NTP_SYNC_MS, millis() - ntpStartMs);
+
+        checkRtcDrift(TimeSource::localNow(), maxAllowedDiffSec);
+        return NtpSyncStatus::DONE;
+    }
+
+    if ((uint32_t)(millis() - ntpStartMs) >= ntpTimeoutMs) {
+        Serial.println("⚠️ NTP sync failed (timeout).");
+        ntpState = NtpSyncStatus::IDLE;
+        Metrics::count(Metric::NTP_FAILED);
+        adaptNtpPoll(false, NAN);
+        return NtpSyncStatus::FAILED;
+    }
+    return NtpSyncStatus::PENDING;
+}
+
 /**
  * @brief Apply DS1307 (local time) to the ESP32 system clock (`time()`).
- *        Used only in MANUAL or when NTP is unavailable.
+ *        Used at boot (before SNTP answers), in MANUAL, and when NTP is unavailable.
  */
 void RTCManager::applyRtcToSystemClock() {
     if (!rtcOk) return;
 
-    DateTime dt = rtc.now(); // LOCAL time
+    DateTime dt = now(); // LOCAL time, drift-corrected
     struct tm tmLocal = {};
     tmLocal.tm_year = dt.year() - 1900;
     tmLocal.tm_mon  = dt.month() - 1;
@@ -302,11 +438,191 @@ void RTCManager::applyRtcToSystemClock() {
     tmLocal.tm_hour = dt.hour();
     tmLocal.tm_min  = dt.minute();
     tmLocal.tm_sec  = dt.second();
+    tmLocal.tm_isdst = -1;             // DS1307 holds wall time: let the TZ rules decide DST
 
     time_t epoch = mktime(&tmLocal);   // uses current TZ/DST rules
     struct timeval tv = { .tv_sec = epoch, .tv_usec = 0 };
     settimeofday(&tv, nullptr);
+    lastUtcOffset = utcOffsetNow();
 
     Serial.printf("⏱️ System clock set from RTC (local): %04d-%02d-%02d %02d:%02d:%02d; epoch=%ld\n",
         dt.year(), dt.month(), dt.day(), dt.hour(), dt.minute(), dt.second(), (long)epoch);
 }
+
+/**
+ * @brief Periodic RTC -> system clock discipline (MANUAL / no NTP).
+ * @param maxAllowedDiffSec Step the system clock only if it is off by more than this.
+ * @return Signed offset system - RTC in seconds (0 if the RTC is unavailable).
+ *
+ * One I2C read per call; the caller decides the cadence. The DS1307 holds
+ * wall time, so when the TZ rules move local time (DST change) since the last
+ * call, the RTC is moved along instead of stepping the system clock back.
+ */
+long RTCManager::disciplineSystemClock(int maxAllowedDiffSec) {
+    if (!rtcOk) return 0;
+
+    DateTime rtcLocal = now();
+    DateTime sysLocal = TimeSource::localNow();
+    long diff = (long)(int32_t)(sysLocal.unixtime() - rtcLocal.unixtime());   // signed on LP64 hosts too
+
+    const long offset = utcOffsetNow();
+    const long shift  = offset - lastUtcOffset;
+    lastUtcOffset = offset;
+    if (shift != 0 && labs(diff - shift) <= maxAllowedDiffSec) {
+        Serial.printf("⏱️ Local time moved by %+ld s (DST/TZ) → moving RTC along.\n", shift);
+        adjustRtc(rtcLocal + TimeSpan((int32_t)shift));
+        return diff - shift;
+    }
+
+    if (labs(diff) > maxAllowedDiffSec) {
+        Serial.printf("⏱️ System clock off by %ld s vs RTC → re-applying RTC.\n", diff);
+        applyRtcToSystemClock();
+    }
+    return diff;
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Drift model & adaptive NTP poll
+// ──────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Restore the drift model from NVS (namespace "rtcdrift").
+ */
+void RTCManager::loadDriftModel() {
+    Preferences prefs;
+    if (!prefs.begin("rtcdrift", /*readOnly=*/true)) return;
+    RtcDriftModel m;
+    if (prefs.getBytesLength("model") == sizeof(m) &&
+        prefs.getBytes("model", &m, sizeof(m)) == sizeof(m)) {
+        drift = m;
+        if (drift.errPpm > 0.0f) {
+            Serial.printf("📈 RTC drift model loaded: %+.2f ppm (±%.2f)\n", drift.ppm, drift.errPpm);
+        }
+    }
+    prefs.end();
+}
+
+/**
+ * @brief Persist the drift model to NVS (once per NTP result or RTC write).
+ */
+void RTCManager::saveDriftModel() {
+    Preferences prefs;
+    if (!prefs.begin("rtcdrift", /*readOnly=*/false)) return;
+    prefs.putBytes("model", &drift, sizeof(drift));
+    prefs.end();
+}
+
+/**
+ * @brief Expected RTC − NTP offset (s) at local unixtime @p epoch.
+ */
+float RTCManager::predictOffsetSec(uint32_t epoch) const {
+    if (drift.refEpoch == 0) return 0.0f;
+    float off = drift.refOffsetSec;
+    if (drift.errPpm > 0.0f) off += drift.ppm * 1e-6f * (float)((int32_t)(epoch - drift.refEpoch));
+    return off;
+}
+
+/**
+ * @brief Feed one NTP/RTC comparison into the model.
+ * @param ntp    Fresh local time from NTP (ground truth).
+ * @param rtcRaw Uncorrected DS1307 reading taken at the same moment.
+ * @return Prediction error (measured − predicted offset, s); NAN if there was
+ *         no baseline to predict from or the RTC was stepped.
+ *
+ * The rate is the offset change over the whole current baseline, so every
+ * sync refines it and its uncertainty shrinks as ~DRIFT_QUANT_SEC / baseline.
+ */
+float RTCManager::updateDriftModel(const DateTime& ntp, const DateTime& rtcRaw) {
+    const uint32_t t      = ntp.unixtime();
+    const float    offset = (float)((int32_t)(rtcRaw.unixtime() - t));
+
+    if (drift.refEpoch == 0 || (int32_t)(t - drift.refEpoch) <= 0) {
+        rebaseDrift(t, offset);
+        saveDriftModel();
+        return NAN;
+    }
+
+    const float residual = offset - predictOffsetSec(t);
+    if (fabsf(residual) > DRIFT_STEP_SEC) {
+        // RTC set by hand, DST change written elsewhere, or a battery swap
+        Serial.printf("⚠️ RTC offset jumped by %.0f s — drift baseline restarted.\n", residual);
+        rebaseDrift(t, offset);
+        saveDriftModel();
+        return NAN;
+    }
+
+    const uint32_t elapsed = t - drift.refEpoch;
+    if (elapsed < DRIFT_MIN_BASELINE_SEC) return residual;
+
+    const float measPpm = (offset - drift.refOffsetSec) / (float)elapsed * 1e6f;
+    const float measErr = DRIFT_QUANT_SEC / (float)elapsed * 1e6f;
+
+    if (drift.priorErrPpm > 0.0f) {
+        const float wp = 1.0f / (drift.priorErrPpm * drift.priorErrPpm);
+        const float wm = 1.0f / (measErr * measErr);
+        drift.ppm    = (drift.priorPpm * wp + measPpm * wm) / (wp + wm);
+        drift.errPpm = 1.0f / sqrtf(wp + wm);
+    } else {
+        drift.ppm    = measPpm;
+        drift.errPpm = measErr;
+    }
+    saveDriftModel();
+    return residual;
+}
+
+/**
+ * @brief Start a new baseline at (@p epoch, @p offsetSec), keeping the current
+ *        estimate as the prior for the next one.
+ */
+void RTCManager::rebaseDrift(uint32_t epoch, float offsetSec) {
+    if (drift.errPpm > 0.0f) {
+        drift.priorPpm    = drift.ppm;
+        drift.priorErrPpm = fmaxf(drift.errPpm, DRIFT_AGING_PPM);
+    }
+    drift.refEpoch     = epoch;
+    drift.refOffsetSec = offsetSec;
+}
+
+/**
+ * @brief Write NTP time to the RTC and restart the baseline from zero offset.
+ */
+void RTCManager::setRtcFromNtp(const DateTime& ntp) {
+    rtc.adjust(ntp);
+    rebaseDrift(ntp.unixtime(), 0.0f);
+    saveDriftModel();
+}
+
+/**
+ * @brief Set the NTP poll bounds (minutes); the interval restarts at the minimum.
+ */
+void RTCManager::setNtpPollRange(int minMinutes, int maxMinutes) {
+    pollMinMinutes = minMinutes < 0 ? 0 : minMinutes;
+    pollMaxMinutes = maxMinutes < pollMinMinutes ? pollMinMinutes : maxMinutes;
+    pollMinutes    = pollMinMinutes;
+}
+
+/**
+ * @brief Adaptive poll (chrony-style): double the interval while the model
+ *        predicts the RTC within POLL_OK_RESIDUAL_SEC, drop to the minimum
+ *        on a miss, halve after a failed sync.
+ *
+ * SNTP's own background interval follows, so the radio is not woken more
+ * often than our schedule.
+ */
+void RTCManager::adaptNtpPoll(bool ok, float residualSec) {
+    if (pollMinMinutes <= 0) return;
+
+    const int before = pollMinutes;
+    if (!ok) {
+        pollMinutes = max(pollMinMinutes, pollMinutes / 2);
+    } else if (!isnan(residualSec) && drift.errPpm > 0.0f && fabsf(residualSec) <= POLL_OK_RESIDUAL_SEC) {
+        pollMinutes = min(pollMaxMinutes, pollMinutes * 2);
+    } else if (!isnan(residualSec) && fabsf(residualSec) > POLL_OK_RESIDUAL_SEC) {
+        pollMinutes = pollMinMinutes;
+    }
+
+    if (pollMinutes != before) {
+        Serial.printf("⏲️ NTP poll interval: %d → %d min\n", before, pollMinutes);
+        if (sntp_enabled()) sntp_set_sync_interval((uint32_t)pollMinutes * 60UL * 1000UL);
+    }
+}
@@ -4,8 +4,19 @@
  *
  * Design
  * ------
- * - AUTO: system time is set by SNTP; RTC is only a cache (do not overwrite system time from RTC).
- * - MANUAL/offline: apply RTC -> system clock to drive time().
+ * - AUTO: begin() starts the system clock from the RTC without waiting for
+ *   the network; from then on SNTP sets it and the RTC is only a cache (do not
+ *   overwrite system time from RTC).
+ * - MANUAL/offline: apply RTC -> system clock to drive time(), then re-discipline
+ *   it periodically (disciplineSystemClock()); everything else reads time via
+ *   TimeSource, so the DS1307 is not touched per log line or per tick.
+ * - Asynchronous re-sync: startNtpSync() kicks SNTP and returns at once;
+ *   pollNtpSync() reports PENDING until the SNTP time-sync notification
+ *   fires (DONE) or the timeout expires (FAILED). Nothing spins or delays.
+ * - Drift model: every NTP result is compared with the raw DS1307 reading;
+ *   the offset's growth over a long baseline gives the RTC rate in ppm
+ *   (kept in NVS). now() returns the RTC corrected by the model, and the NTP
+ *   poll interval doubles while predictions hold (halves when they miss).
  */
 
 #pragma once
@@ -14,9 +25,37 @@
 #include <RTClib.h>
 #include <time.h>
 
+/**
+ * @struct RtcDriftModel
+ * @brief Learned DS1307 error: offset(t) = refOffsetSec + ppm·1e-6·(t − refEpoch).
+ *
+ * Offsets are RTC − NTP in seconds (RTC fast → positive). The baseline
+ * restarts whenever the RTC is written; the estimate from earlier baselines
+ * is kept as a prior and merged by inverse-variance weighting.
+ */
+struct RtcDriftModel {
+    uint32_t refEpoch     = 0;      ///< Local unixtime of the baseline start (0 = none).
+    float    refOffsetSec = 0.0f;   ///< RTC − NTP at refEpoch.
+    float    ppm          = 0.0f;   ///< Current rate estimate.
+    float    errPpm       = 0.0f;   ///< Uncertainty of ppm; 0 = no estimate yet.
+    float    priorPpm     = 0.0f;   ///< Estimate carried over from earlier baselines.
+    float    priorErrPpm  = 0.0f;   ///< 0 = no prior.
+};
+
+/**
+ * @enum NtpSyncStatus
+ * @brief State of an asynchronous NTP sync started by startNtpSync().
+ */
+enum class NtpSyncStatus : uint8_t {
+    IDLE,       ///< No sync in progress.
+    PENDING,    ///< Waiting for the SNTP notification.
+    DONE,       ///< SNTP set the system clock; RTC drift checked.
+    FAILED      ///< Timed out (no reply / no network).
+};
+
 class RTCManager {
 public:
-    // Initialization (with NTP)
+    // Initialization (with NTP; returns at once, SNTP replies later)
     bool begin(const char* ntpServer, int timeZoneOffsetHrs, bool useEUDst);
     bool begin(const char* ntpServer, int timeZoneOffsetHrs);
     bool begin(const char* ntpServer, const char* posixTz);
@@ -27,22 +66,77 @@ public:
     bool beginManual(int timeZoneOffsetHrs, bool useEUDst, int offsetMin);
 
     // Operations
-    DateTime now();
+    DateTime now();                  ///< RTC time corrected by the drift model.
+    DateTime rawNow();               ///< Uncorrected DS1307 reading.
     bool     syncWithNtp(int maxAllowedDiffSec = 60);
+
+    // Asynchronous NTP (never blocks)
+    bool          startNtpSync(uint32_t timeoutMs = 5000);
+    NtpSyncStatus pollNtpSync(int maxAllowedDiffSec = 60);
+    bool          ntpSyncPending() const { return ntpState == NtpSyncStatus::PENDING; }
+    void          kickNtpSync();   ///< Network just came up: ask now, not at SNTP's next retry.
+    void          setNtpPaused(bool paused);   ///< Fleet follower: stop SNTP polling (restart on false).
     bool     adjustRtc(const DateTime& dt);
     bool     isRtcAvailable() const;
     void     applyRtcToSystemClock();
+    long     disciplineSystemClock(int maxAllowedDiffSec = 2);
+    /// Treat the system clock as the reference (fleet time): drift model + RTC cache refresh.
+    bool     refreshRtcFromSystemClock(int maxAllowedDiffSec = 60);
+
+    // DS1307 battery-backed RAM; false if the RTC is absent or the range is out of bounds
+    static constexpr uint8_t NVRAM_SIZE = 56;
+    bool     readNvram(uint8_t addr, uint8_t* buf, uint8_t len);
+    bool     writeNvram(uint8_t addr, const uint8_t* buf, uint8_t len);
+
+    // Drift model & adaptive NTP poll
+    const RtcDriftModel& driftModel() const { return drift; }
+    /// True once the rate is known well enough to hold time without NTP (≤ DRIFT_HOLDOVER_PPM).
+    bool     driftModelValid() const { return drift.errPpm > 0.0f && drift.errPpm <= DRIFT_HOLDOVER_PPM; }
+    /// Poll bounds in minutes; 0 disables periodic NTP. Resets the current interval to the minimum.
+    void     setNtpPollRange(int minMinutes, int maxMinutes);
+    int      ntpPollMinutes() const { return pollMinutes; }
 
 private:
     RTC_DS1307 rtc;
     bool       rtcOk = false;
 
+    // Async NTP session
+    NtpSyncStatus ntpState     = NtpSyncStatus::IDLE;
+    uint32_t      ntpStartMs   = 0;
+    uint32_t      ntpTimeoutMs = 5000;
+    static volatile bool sntpNotified;        ///< Set by the SNTP callback.
+    static void   onSntpSync(struct timeval* tv);
+    bool          ntpPaused = false;          ///< SNTP stopped by setNtpPaused().
+
+    // Drift model (see RtcDriftModel)
+    static constexpr uint32_t DRIFT_MIN_BASELINE_SEC = 3600;  ///< Shorter baselines only feed the residual.
+    static constexpr float    DRIFT_QUANT_SEC        = 1.5f;  ///< Two 1 s readings' worth of quantization.
+    static constexpr float    DRIFT_STEP_SEC         = 20.0f; ///< Residual above this = RTC was stepped.
+    static constexpr float    DRIFT_AGING_PPM        = 0.5f;  ///< Floor for a carried-over prior.
+    static constexpr float    DRIFT_HOLDOVER_PPM     = 20.0f;
+    static constexpr float    POLL_OK_RESIDUAL_SEC   = 1.5f;  ///< Prediction good enough to back off.
+    RtcDriftModel drift;
+    long          lastUtcOffset = 0;   ///< Local − UTC (s) at the last RTC → system clock step/check.
+    int           pollMinMinutes = 15;
+    int           pollMaxMinutes = 15;
+    int           pollMinutes    = 15;
+
+    void     loadDriftModel();
+    void     saveDriftModel();
+    float    predictOffsetSec(uint32_t epoch) const;
+    float    updateDriftModel(const DateTime& ntp, const DateTime& rtcRaw);
+    void     rebaseDrift(uint32_t epoch, float offsetSec);
+    void     adaptNtpPoll(bool ok, float residualSec);
+    void     setRtcFromNtp(const DateTime& ntp);
+
     // NTP/TZ setup helpers
+    void     startFromRtc(const char* posixTz);
     bool     setupNtp(const char* ntpServer, int offsetHrs, bool useEUDst);
     bool     setupNtp(const char* ntpServer, int offsetHrs, bool useEUDst, int offsetMinutes);
     bool     setupNtpWithPosix(const char* ntpServer, const char* posixTz);
 
     // Internals
     DateTime getNtpTime(uint32_t timeoutMs = 7000);
+    bool     checkRtcDrift(const DateTime& ntp, int maxAllowedDiffSec);
     static String buildTZ(int offsetHours, int offsetMinutes = 0, bool useEUDst = false);
 };
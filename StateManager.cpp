@@ -4,11 +4,29 @@
  *
  * Overview
  * --------
- * - Stores only the minute time-of-day as text ("HH:MM") in /state.txt.
- * - On first run (file missing), creates the file with the current system time
- *   (derived from RTC→system clock) and returns that value.
- * - Supports reading legacy formats "YYYY-MM-DD HH:MM" and "HH:MM"; the date
- *   part is ignored and only HH:MM is used.
+ * - Stores only the minute time-of-day, as 16-byte records in /state.jnl.
+ *   The file is preallocated with JOURNAL_SLOTS zeroed slots and kept open;
+ *   each save overwrites the next slot in place (no truncate, no cluster
+ *   allocation, writes spread over the slots instead of one sector).
+ * - At boot the valid record (magic + CRC32) with the highest sequence wins;
+ *   a torn write only invalidates its own slot, the previous record survives.
+ * - If the journal has no valid record, the legacy /state.txt is read
+ *   ("YYYY-MM-DD HH:MM" or "HH:MM"; the date part is ignored) and migrated.
+ * - On first run (both missing), /state.txt is created with the current
+ *   system time (derived from RTC→system clock) and that value is returned.
+ * - queueSave()/service() split a write between the clock task (posts the
+ *   value into a depth-1 mailbox) and the I/O task (does the SD write), so a
+ *   slow card never delays a minute impulse.
+ * - The latest position is also kept in RAM (cachedMinutes) so readers such
+ *   as /api/status never touch the card; persistence is write-behind only.
+ * - With setNvram(), service() commits every position to the DS1307's
+ *   battery-backed NVRAM first (~1 ms on I²C, no SD involved) and appends to
+ *   the journal only every SD_FLUSH_MS or on esp_restart(). A power cut or
+ *   brown-out then loses nothing: at boot the newer of the slot's two NVRAM
+ *   records wins and the journal is brought up to date. The ESP32's own RTC
+ *   slow memory is not used — it does not survive a power loss.
+ * - Unusable state (no record, unreadable/corrupt legacy file) starts from
+ *   the current local time (no catch-up) instead of 00:00.
  *
  * Requirements
  * ------------
@@ -17,56 +35,121 @@
  */
 
 #include "StateManager.h"
+#include "RTCManager.h"
+#include "Metrics.h"
+#include "NetWake.h"
 #include <SD.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+
+StateManager* StateManager::shutdownList = nullptr;
 
 /**
- * @brief Initialize state manager with a target file path.
- * @param filePath Path to the state file (default: "/state.txt").
+ * @brief Initialize state manager with target file paths.
+ * @param filePath    Legacy text state file (default: "/state.txt").
+ * @param journalPath Journal file (default: "/state.jnl").
  * @return true if the manager is ready to operate (SD must be mounted beforehand).
  *
  * Note: This does not call SD.begin(); it assumes the filesystem is ready.
  */
-bool StateManager::begin(const char* filePath) {
-    statePath = String(filePath);
+bool StateManager::begin(const char* filePath, const char* journalPath) {
+    statePath         = String(filePath);
+    this->journalPath = String(journalPath);
+    journalScanned    = false;
     // SD.begin() is called elsewhere (in the app's setup). We only capture the path.
+    if (!saveMailbox) saveMailbox = xQueueCreate(1, sizeof(int16_t));
+    lastSdMs = millis();
     valid = true;
     return true;
 }
 
+/**
+ * @brief Keep the position in DS1307 NVRAM and batch the SD journal writes.
+ * @param rtc  RTC owning the NVRAM (may still be uninitialized; checked per access).
+ * @param slot 12-byte NVRAM slot, normally the channel index (< NVRAM_SLOTS).
+ */
+void StateManager::setNvram(RTCManager* rtc, uint8_t slot) {
+    if (slot >= NVRAM_SLOTS) return;
+    nvram     = rtc;
+    nvramSlot = slot;
+
+    if (!shutdownList) esp_register_shutdown_handler(&StateManager::onShutdown);
+    for (StateManager* s = shutdownList; s; s = s->shutdownNext) {
+        if (s == this) return;
+    }
+    shutdownNext = shutdownList;
+    shutdownList = this;
+}
+
+void StateManager::onShutdown() {
+    for (StateManager* s = shutdownList; s; s = s->shutdownNext) s->flush();
+}
+
 /**
  * @brief Load the last known clock time from SD.
  * @return DateTime with sentinel date (2000-01-01) and restored HH:MM.
  *
  * Behavior:
- * - If the state file does not exist, it is created with the current local system time
+ * - A valid NVRAM record (setNvram()) wins: it is never older than the
+ *   journal, which is updated to match if it lags behind.
+ * - Otherwise the newest valid journal record is returned if there is one.
+ * - Otherwise the legacy state file is read (see loadLegacyStateFile()) and
+ *   its value written as the first journal record.
+ */
+DateTime StateManager::loadLastKnownClockTime() {
+    const int fast    = readNvram();
+    const int minutes = openJournal() ? scanJournal() : -1;
+
+    if (fast >= 0) {
+        if (fast != minutes) {
+            Serial.printf("ℹ️ State %02d:%02d restored from RTC NVRAM (journal: %d).\n",
+                          fast / 60, fast % 60, minutes);
+            if (appendJournal(fast)) lastSdMs = millis();
+        }
+        cachedMinutes = (int16_t)fast;
+        return DateTime(2000, 1, 1, fast / 60, fast % 60, 0);
+    }
+    if (minutes >= 0) {
+        cachedMinutes = (int16_t)minutes;
+        writeNvram(minutes);
+        return DateTime(2000, 1, 1, minutes / 60, minutes % 60, 0);
+    }
+
+    DateTime dt = loadLegacyStateFile();
+    cachedMinutes = (int16_t)(dt.hour() * 60 + dt.minute());
+    writeNvram(cachedMinutes);
+    if (appendJournal(dt.hour() * 60 + dt.minute())) {
+        Serial.printf("ℹ️ State migrated to %s (%02d:%02d).\n",
+                      journalPath.c_str(), dt.hour(), dt.minute());
+    }
+    return dt;
+}
+
+/**
+ * @brief Read the legacy "HH:MM" state file.
+ *
+ * - If the file does not exist, it is created with the current local system time
  *   and that time is returned.
  * - If the file exists, it is parsed (supports "YYYY-MM-DD HH:MM" or "HH:MM").
- * - Invalid content resets the file to "00:00" and returns 00:00.
+ * - An unreadable file or invalid content also starts from the current local
+ *   time (a 00:00 fallback would drive the dial hours off).
  */
-DateTime StateManager::loadLastKnownClockTime() {
+DateTime StateManager::loadLegacyStateFile() {
     if (!SD.exists(statePath)) {
         // File missing: create it with current local system time (derived from RTC if set).
-        time_t tnow = time(nullptr);
-        struct tm *tmnow = localtime(&tnow);
-        int h = tmnow ? tmnow->tm_hour : 0;
-        int m = tmnow ? tmnow->tm_min  : 0;
-
+        DateTime dt = systemClockTime();
         File nf = SD.open(statePath, FILE_WRITE);
-        if (nf) { 
-            char buf[6]; snprintf(buf, sizeof(buf), "%02d:%02d", h, m);
-            nf.println(buf);
-            nf.close();
-        }
-        Serial.printf("⚠️ %s not found. Creating with %02d:%02d.\n", statePath.c_str(), h, m);
-        return DateTime(2000, 1, 1, h, m, 0);
+        if (nf) { nf.println(formatDateTime(dt)); nf.close(); }
+        Serial.printf("⚠️ %s not found. Creating with %02d:%02d.\n", statePath.c_str(), dt.hour(), dt.minute());
+        return dt;
     }
 
     File f = SD.open(statePath, FILE_READ);
     if (!f) {
-        Serial.println("❌ Failed to open state.txt (read). Creating with 00:00.");
-        File nf = SD.open(statePath, FILE_WRITE);
-        if (nf) { nf.println("00:00"); nf.close(); }
-        return DateTime(2000, 1, 1, 0, 0, 0);
+        DateTime dt = systemClockTime();
+        Serial.printf("❌ Failed to open %s (read). Assuming %02d:%02d.\n",
+                      statePath.c_str(), dt.hour(), dt.minute());
+        return dt;
     }
 
     String line = f.readStringUntil('\n');
@@ -76,29 +159,235 @@ DateTime StateManager::loadLastKnownClockTime() {
 }
 
 /**
- * @brief Save only "HH:MM" to the state file (overwrites the file).
+ * @brief Save only HH:MM as the next journal record.
  * @param dt Local DateTime; only hour and minute are persisted.
- * @return true on success, false if the file could not be opened.
+ * @return true on success, false if the journal could not be opened/written.
  */
 bool StateManager::saveClockTime(const DateTime& dt) {
-    File f = SD.open(statePath, FILE_WRITE); // create/overwrite — single-line state file
-    if (!f) {
-        Serial.println("❌ Failed to write state.txt");
+    cachedMinutes = (int16_t)(dt.hour() * 60 + dt.minute());
+    writeNvram(cachedMinutes);
+    if (!appendJournal(dt.hour() * 60 + dt.minute())) {
+        Serial.println("❌ Failed to write state journal");
         return false;
     }
+    unflushed = -1;
+    lastSdMs  = millis();
+    return true;
+}
 
-    String content = formatDateTime(dt); // "HH:MM"
-    f.println(content);
-    f.close();
+/**
+ * @brief Journal the position that so far reached only NVRAM (no-op if none).
+ */
+void StateManager::flush() {
+    const int16_t minutes = unflushed;
+    if (minutes < 0) return;
+    if (!appendJournal(minutes)) {
+        Serial.println("❌ Failed to write state journal");
+        return;
+    }
+    unflushed = -1;
+    lastSdMs  = millis();
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// DS1307 NVRAM
+// ──────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief CRC32 of the record's first four bytes, truncated to 16 bits.
+ */
+uint16_t StateManager::nvramCrc(const NvramRecord& r) {
+    return (uint16_t)esp_rom_crc32_le(0, (const uint8_t*)&r, offsetof(NvramRecord, crc));
+}
+
+/**
+ * @brief Newest valid record of this slot.
+ * @return Minutes of day, or -1 (no NVRAM configured, RTC absent, both records invalid).
+ *
+ * A write torn by a power cut only spoils the record being written; the
+ * other one still holds the position before it.
+ */
+int StateManager::readNvram() {
+    if (!nvram) return -1;
+    NvramRecord r[2];
+    if (!nvram->readNvram(nvramSlot * sizeof(r), (uint8_t*)r, sizeof(r))) return -1;
+
+    const uint8_t magic = NVRAM_MAGIC ^ nvramSlot;
+    int best = -1;
+    for (int i = 0; i < 2; i++) {
+        if (r[i].magic != magic || r[i].crc != nvramCrc(r[i])) continue;
+        if (r[i].minutes < 0 || r[i].minutes >= 1440) continue;
+        if (best < 0 || (int8_t)(r[i].seq - r[best].seq) > 0) best = i;
+    }
+    if (best < 0) return -1;
+    nvramSeq = r[best].seq;
+    return r[best].minutes;
+}
+
+/**
+ * @brief Overwrite the older of the slot's two records with @p minutes.
+ */
+bool StateManager::writeNvram(int minutes) {
+    if (!nvram) return false;
+    NvramRecord r = {};
+    r.magic   = NVRAM_MAGIC ^ nvramSlot;
+    r.seq     = (uint8_t)(nvramSeq + 1);
+    r.minutes = (int16_t)minutes;
+    r.crc     = nvramCrc(r);
+
+    const uint8_t addr = (uint8_t)(nvramSlot * 2 * sizeof(r) + (r.seq & 1) * sizeof(r));
+    if (!nvram->writeNvram(addr, (const uint8_t*)&r, sizeof(r))) return false;
+    nvramSeq = r.seq;
+    Metrics::count(Metric::STATE_NVRAM_COMMITS);
+    return true;
+}
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Journal
+// ──────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief CRC32 over a record's fields up to (not including) the crc.
+ */
+uint32_t StateManager::recordCrc(const JournalRecord& r) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&r, offsetof(JournalRecord, crc));
+}
+
+/**
+ * @brief Open the journal for in-place writes, creating it first if missing.
+ * @return false if the file cannot be created or opened.
+ *
+ * A new journal is filled with JOURNAL_SLOTS zeroed slots (magic 0 → invalid),
+ * so later saves never grow the file.
+ */
+bool StateManager::openJournal() {
+    if (journal) return true;
+
+    if (!SD.exists(journalPath)) {
+        File nf = SD.open(journalPath, FILE_WRITE);
+        if (!nf) return false;
+        const JournalRecord blank = {};
+        for (size_t i = 0; i < JOURNAL_SLOTS; i++) {
+            nf.write((const uint8_t*)&blank, sizeof(blank));
+        }
+        nf.close();
+        journalScanned = false;
+    }
+
+    journal = SD.open(journalPath, "r+");
+    return (bool)journal;
+}
+
+/**
+ * @brief Find the newest valid record and position the write cursor after it.
+ * @return Its minutes-of-day, or -1 if no slot holds a valid record.
+ */
+int StateManager::scanJournal() {
+    uint32_t bestSeq  = 0;
+    size_t   bestSlot = 0;
+    int      bestMin  = -1;
+
+    for (size_t i = 0; i < JOURNAL_SLOTS; i++) {
+        JournalRecord r;
+        if (!journal.seek(i * sizeof(r))) break;
+        if (journal.read((uint8_t*)&r, sizeof(r)) != sizeof(r)) break;
+        if (r.magic != JOURNAL_MAGIC || r.crc != recordCrc(r)) continue;
+        if (r.minutes < 0 || r.minutes >= 1440) continue;
+        if (bestMin < 0 || r.seq > bestSeq) {
+            bestSeq  = r.seq;
+            bestSlot = i;
+            bestMin  = r.minutes;
+        }
+    }
+
+    if (bestMin >= 0) {
+        nextSeq  = bestSeq + 1;
+        nextSlot = (bestSlot + 1) % JOURNAL_SLOTS;
+    } else {
+        nextSeq  = 1;
+        nextSlot = 0;
+    }
+    journalScanned = true;
+    return bestMin;
+}
+
+/**
+ * @brief Write one record into the next slot and flush it to the card.
+ */
+bool StateManager::appendJournal(int minutes) {
+    if (!openJournal()) return false;
+    if (!journalScanned) scanJournal();
+
+    JournalRecord r = {};
+    r.magic   = JOURNAL_MAGIC;
+    r.seq     = nextSeq;
+    r.minutes = (int16_t)minutes;
+    r.crc     = recordCrc(r);
+
+    const uint32_t t0 = micros();
+    if (!journal.seek(nextSlot * sizeof(r))) return false;
+    if (journal.write((const uint8_t*)&r, sizeof(r)) != sizeof(r)) return false;
+    journal.flush();
+    Metrics::observe(Latency::SD_STATE_US, micros() - t0);
+
+    nextSeq++;
+    nextSlot = (nextSlot + 1) % JOURNAL_SLOTS;
     return true;
 }
 
+/**
+ * @brief Post HH:MM for write-behind persistence; overwrites any unsaved value.
+ * @param dt Local DateTime; only hour and minute are persisted.
+ *
+ * Falls back to a synchronous save if the mailbox could not be created.
+ */
+void StateManager::queueSave(const DateTime& dt) {
+    if (!saveMailbox) {
+        saveClockTime(dt);
+        return;
+    }
+    const int16_t minutes = (int16_t)(dt.hour() * 60 + dt.minute());
+    cachedMinutes = minutes;
+    xQueueOverwrite(saveMailbox, &minutes);
+    NetWake::notify();   // commit to NVRAM now; the power-loss window stays short
+}
+
+/**
+ * @brief Current clock position from RAM.
+ *
+ * Only the very first call before any load/save reads the card.
+ */
+DateTime StateManager::currentClockTime() {
+    const int minutes = cachedMinutes;
+    if (minutes < 0) return loadLastKnownClockTime();
+    return DateTime(2000, 1, 1, minutes / 60, minutes % 60, 0);
+}
+
+/**
+ * @brief Persist the most recently queued HH:MM (no-op if nothing pending).
+ *
+ * With NVRAM the value is committed there at once and the journal write is
+ * deferred to SD_FLUSH_MS after the previous one; without it (or if the RTC
+ * is gone) every value goes to the journal as before.
+ */
+void StateManager::service() {
+    if (!saveMailbox) return;
+    int16_t minutes;
+    if (xQueueReceive(saveMailbox, &minutes, 0) == pdTRUE) {
+        if (writeNvram(minutes)) {
+            unflushed = minutes;
+        } else {
+            saveClockTime(DateTime(2000, 1, 1, minutes / 60, minutes % 60, 0));
+        }
+    }
+    if (unflushed >= 0 && (uint32_t)(millis() - lastSdMs) >= SD_FLUSH_MS) flush();
+}
+
 /**
  * @brief Parse a state line supporting both "YYYY-MM-DD HH:MM" and "HH:MM".
  * @param line Raw line from the state file.
  * @return DateTime with sentinel date 2000-01-01 and extracted HH:MM,
- *         or 00:00 if parsing fails (and file is reset to "00:00").
+ *         or the current local time if parsing fails (file rewritten with it).
  */
 DateTime StateManager::parseLine(const String& line) {
     int y=2000, M=1, d=1, h=-1, m=-1;
@@ -115,18 +404,31 @@ DateTime StateManager::parseLine(const String& line) {
             return DateTime(2000, 1, 1, h, m, 0);
     }
 
-    Serial.println("❌ Invalid format in state.txt, resetting to 00:00");
-    // Fix the file content to "00:00".
+    // A torn/corrupt file says nothing about the dial: assume it shows the
+    // current time rather than 00:00, which would start a catch-up of hours.
+    DateTime dt = systemClockTime();
+    Serial.printf("❌ Invalid format in %s, assuming %02d:%02d\n",
+                  statePath.c_str(), dt.hour(), dt.minute());
     File nf = SD.open(statePath, FILE_WRITE);
-    if (nf) { nf.println("00:00"); nf.close(); }
-    return DateTime(2000, 1, 1, 0, 0, 0);
+    if (nf) { nf.println(formatDateTime(dt)); nf.close(); }
+    return dt;
+}
+
+/**
+ * @brief Current local system time as 2000-01-01 HH:MM:00 (00:00 if unset).
+ */
+DateTime StateManager::systemClockTime() {
+    time_t tnow = time(nullptr);
+    struct tm tmnow;
+    if (!localtime_r(&tnow, &tmnow)) return DateTime(2000, 1, 1, 0, 0, 0);
+    return DateTime(2000, 1, 1, tmnow.tm_hour, tmnow.tm_min, 0);
 }
 
 /**
- * @brief Format a DateTime to "HH:MM".
+ * @brief Format a DateTime to "HH:MM" (legacy text format).
  */
 String StateManager::formatDateTime(const DateTime& dt) {
-    char buffer[6];
+    char buffer[8];
     snprintf(buffer, sizeof(buffer), "%02d:%02d", dt.hour(), dt.minute());
     return String(buffer);
 }
@@ -1,12 +1,27 @@
 /**
  * @file    StateManager.h
  * @brief   Minimal persistence of last known clock time (HH:MM) on SD.
+ *
+ * Storage: /state.jnl — JOURNAL_SLOTS preallocated fixed-size records
+ * (magic, sequence, minutes, CRC32) written round-robin in place; the record
+ * with the highest valid sequence wins at boot. The legacy /state.txt
+ * ("HH:MM") is read only when the journal holds no valid record.
+ *
+ * With setNvram(), every position is first committed to the DS1307's
+ * battery-backed NVRAM (two CRC-checked 6-byte records per channel, written
+ * alternately) and the SD journal only follows every SD_FLUSH_MS and on
+ * esp_restart(). At boot a valid NVRAM record wins over the journal.
  */
 
 #pragma once
 
 #include <Arduino.h>
 #include <RTClib.h>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+class RTCManager;
 
 /**
  * @class StateManager
@@ -14,31 +29,128 @@
  *
  * Usage:
  *   StateManager sm;
- *   sm.begin("/state.txt");
+ *   sm.begin("/state.txt", "/state.jnl");
  *   DateTime t = sm.loadLastKnownClockTime();   // returns 2000-01-01 HH:MM:00
  *   sm.saveClockTime(DateTime(2000,1,1,12,34,0));
+ *
+ *   // From the clock task (never touches SD):
+ *   sm.queueSave(DateTime(2000,1,1,12,35,0));
+ *   // From the I/O task:
+ *   sm.service();                               // writes the latest queued value
+ *
+ *   // Any task (RAM only, no SD access):
+ *   DateTime pos = sm.currentClockTime();
+ *
+ *   // Optional, before the first load: brown-out-safe copy in DS1307 NVRAM
+ *   sm.setNvram(&rtcManager, 0);                // slot = channel index
  */
 class StateManager {
 public:
-    /// Capture the state file path (SD must already be initialized).
-    bool begin(const char* filePath = "/state.txt");
+    /// Capture the legacy state path and the journal path (SD must already be initialized).
+    bool begin(const char* filePath = "/state.txt", const char* journalPath = "/state.jnl");
 
     /// Load last known time-of-day; date is always 2000-01-01.
     DateTime loadLastKnownClockTime();         // returns 2000-01-01 HH:MM:00
 
-    /// Save only "HH:MM" (overwrites the file).
+    /// Persist only HH:MM as the next journal record (one in-place slot write).
     bool saveClockTime(const DateTime& dt);    // persists just "HH:MM"
 
-    /// True if begin() was called and the path recorded.
+    /// Queue "HH:MM" for the I/O task (latest value wins); safe from any task.
+    void queueSave(const DateTime& dt);
+
+    /// In-RAM clock position (minutes of day), -1 before the first load/save.
+    int clockMinutes() const { return cachedMinutes; }
+
+    /// In-RAM clock position as 2000-01-01 HH:MM:00; loads from SD only if never set.
+    DateTime currentClockTime();
+
+    /// Persist the queued value, if any; call from the I/O task.
+    void service();
+
+    /// Commit positions to DS1307 NVRAM slot @p slot (0..NVRAM_SLOTS-1) and
+    /// write the SD journal only every SD_FLUSH_MS. Call before the first load.
+    void setNvram(RTCManager* rtc, uint8_t slot);
+
+    /// Write a position that so far reached only NVRAM to the SD journal.
+    void flush();
+
+    static constexpr uint8_t NVRAM_SLOTS = 4;   ///< 4 × 12 B of the DS1307's 56 B.
+
+    /// True if begin() was called and the paths recorded.
     bool isValid() const;
 
 private:
-    String statePath;
+    String statePath;                          ///< Legacy "HH:MM" text file (read-only fallback).
+    String journalPath;
     bool   valid = false;
 
+    // ── Journal ─────────────────────────────────────────────────────────────
+    static constexpr uint32_t JOURNAL_MAGIC = 0x54534750;   ///< "PGST" little-endian.
+    static constexpr size_t   JOURNAL_SLOTS = 64;           ///< 64 × 16 B = 1 KiB file.
+
+    /// On-card record; CRC32 covers every field before it.
+    struct JournalRecord {
+        uint32_t magic;
+        uint32_t seq;
+        int16_t  minutes;                      ///< Minutes of day (0..1439).
+        uint16_t reserved;
+        uint32_t crc;
+    };
+    static_assert(sizeof(JournalRecord) == 16, "journal record must stay 16 bytes");
+
+    File     journal;                          ///< Kept open ("r+") between writes.
+    uint32_t nextSeq  = 1;
+    size_t   nextSlot = 0;
+    bool     journalScanned = false;
+
+    bool     openJournal();                    ///< Create (preallocated) / open the journal.
+    int      scanJournal();                    ///< Newest valid minutes, or -1; updates nextSeq/nextSlot.
+    bool     appendJournal(int minutes);
+    static uint32_t recordCrc(const JournalRecord& r);
+
+    /// Legacy path: read /state.txt (created with current time if missing).
+    DateTime loadLegacyStateFile();
+
+    // ── DS1307 NVRAM (write-ahead copy) ─────────────────────────────────────
+    static constexpr uint8_t  NVRAM_MAGIC = 0xA7;           ///< XOR slot index.
+    static constexpr uint32_t SD_FLUSH_MS = 15UL * 60UL * 1000UL;
+
+    /// One NVRAM record; the truncated CRC32 covers the first four bytes.
+    struct NvramRecord {
+        uint8_t  magic;
+        uint8_t  seq;                          ///< Newer = ahead in 8-bit serial order.
+        int16_t  minutes;
+        uint16_t crc;
+    };
+    static_assert(sizeof(NvramRecord) == 6, "NVRAM record must stay 6 bytes");
+
+    RTCManager* nvram     = nullptr;
+    uint8_t     nvramSlot = 0;
+    uint8_t     nvramSeq  = 0;
+    int16_t     unflushed = -1;                ///< In NVRAM, not yet in the journal.
+    uint32_t    lastSdMs  = 0;
+
+    int      readNvram();                      ///< Newest valid minutes, or -1; updates nvramSeq.
+    bool     writeNvram(int minutes);
+    static uint16_t nvramCrc(const NvramRecord& r);
+
+    // esp_restart() hook: flush every instance (one shutdown handler for all)
+    static StateManager* shutdownList;
+    StateManager*        shutdownNext = nullptr;
+    static void          onShutdown();
+
+    /// Depth-1 mailbox (xQueueOverwrite) carrying minutes-of-day to persist.
+    QueueHandle_t saveMailbox = nullptr;
+
+    /// Authoritative clock position; updated on load/queue/save, read by status.
+    volatile int16_t cachedMinutes = -1;
+
     /// Parse "HH:MM" or "YYYY-MM-DD HH:MM"; returns 2000-01-01 HH:MM:00.
     DateTime parseLine(const String& line);
 
+    /// Current local time as 2000-01-01 HH:MM:00 (start point when no state is usable).
+    static DateTime systemClockTime();
+
     /// Format "HH:MM" for persistence.
     String  formatDateTime(const DateTime& dt);
 };
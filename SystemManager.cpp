@@ -6,45 +6,56 @@
  * Responsibilities
  * ----------------
  * - Initialize timezone/RTC based on configuration (AUTO with NTP vs MANUAL).
- * - Perform an initial NTP sync (AUTO) and detect real DST/TZ jumps (~1h).
+ * - Start an initial async NTP sync (AUTO) and detect real DST/TZ jumps (~1h)
+ *   once its result arrives; until then the engine runs from the RTC.
  * - Compare persisted clock state (HH:MM) with current local time to decide catch-up.
  * - Generate minute impulses (A/B alternating) via PulseManager.
  * - Run non-blocking catch-up when the stored time lags behind current time.
  * - Periodically re-sync with NTP (AUTO) and handle any drift/DST changes.
+ * - Split across two tasks: loop() is the clock engine, serviceNetwork() does
+ *   the blocking NTP work; they talk through FreeRTOS queues.
  *
  * Notes
  * -----
- * - In AUTO, system time (time_t) is the source of truth; RTC is just a fallback cache.
+ * - In AUTO, system time (time_t) is the source of truth; RTC is just a fallback
+ *   cache and the starting point at boot.
+ * - In MANUAL, the system clock is set from the RTC and re-disciplined every
+ *   RTC_DISCIPLINE_EVERY_MS; minute detection reads TimeSource only.
  * - DS1307 stores **local time**; POSIX TZ rules drive localtime().
  * - All timings/limits come from ConfigManager (see /config.json).
  */
 
 #include "SystemManager.h"
+#include "TimeSource.h"
+#include "Metrics.h"
 #include <time.h>
+#include <sys/time.h> // settimeofday
 #include <stdlib.h> // llabs
 
-// Helper: build a DateTime from the current system LOCAL time
-static inline DateTime SystemLocalNow() {
-    time_t t = time(nullptr);
-    tm lt;
-    localtime_r(&t, &lt);
-    return DateTime(lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
-                    lt.tm_hour, lt.tm_min, lt.tm_sec);
-}
-
 SystemManager::SystemManager(
     ConfigManager* config,
     Logger* logger,
     RTCManager* rtc,
-    PulseManager* pulse,
-    StateManager* state
+    PulseManager* const* pulses,
+    StateManager* states,
+    int channelCount
 ) :
     configManager(config),
     logger(logger),
-    rtcManager(rtc),
-    pulseManager(pulse),
-    stateManager(state)
-{}
+    rtcManager(rtc)
+{
+    const auto& cfg = config->getConfig();
+    if (channelCount < 1) channelCount = 1;
+    if (channelCount > MAX_CHANNELS) channelCount = MAX_CHANNELS;
+    this->channelCount = channelCount;
+    for (int i = 0; i < this->channelCount; i++) {
+        Channel& ch = channels[i];
+        ch.pulse = pulses[i];
+        ch.state = &states[i];
+        ch.cfg   = &cfg.channels[i];
+        if (this->channelCount > 1) snprintf(ch.tag, sizeof(ch.tag), "[%s] ", ch.cfg->name);
+    }
+}
 
 /**
  * @brief Bootstrap the system (see file header for the flow).
@@ -52,38 +63,40 @@ SystemManager::SystemManager(
 void SystemManager::begin() {
     logger->info("🔄 SystemManager starting...");
 
+    if (!ntpQueue) ntpQueue = xQueueCreate(4, sizeof(NtpEvent));
+    if (!cmdQueue) cmdQueue = xQueueCreate(4, sizeof(ClockCommand));
+    if (!planQueue) planQueue = xQueueCreate(1, sizeof(PlanReply));
+
     const auto& cfg = configManager->getConfig();
-    const bool isAuto = (cfg.mode == "auto");
+    const bool isAuto = (cfg.mode == ClockMode::AUTO);
 
     bool rtcInitOk = false;
 
     // --- Initialize RTC/TZ according to mode and tz_mode ---
     if (isAuto) {
-        if (cfg.tz_mode == "posix" && cfg.posix_tz.length() > 0) {
-            logger->info(String("🗺️ [AUTO] TZ=posix: ") + cfg.posix_tz.c_str());
-            rtcInitOk = rtcManager->begin(cfg.ntpServer.c_str(), cfg.posix_tz.c_str());
-        } else if (cfg.tz_mode == "eu" || cfg.useEuDst) {
+        if (cfg.tzMode == TzMode::POSIX) {
+            logger->infof("🗺️ [AUTO] TZ=posix: %s", cfg.posixTz);
+            rtcInitOk = rtcManager->begin(cfg.ntpServer, cfg.posixTz);
+        } else if (cfg.tzMode == TzMode::EU) {
             logger->info("🗺️ [AUTO] TZ=eu (CET/CEST)");
-            rtcInitOk = rtcManager->begin(cfg.ntpServer.c_str(), /*offsetHrs=*/1, /*useEUDst=*/true);
+            rtcInitOk = rtcManager->begin(cfg.ntpServer, /*offsetHrs=*/1, /*useEUDst=*/true);
         } else {
-            logger->info(String("🗺️ [AUTO] TZ=fixed: ")
-                         + String(cfg.timeZoneOffsetHrs) + ":" + String(cfg.timeZoneOffsetMin));
-            rtcInitOk = rtcManager->begin(cfg.ntpServer.c_str(),
+            logger->infof("🗺️ [AUTO] TZ=fixed: %d:%d", cfg.timeZoneOffsetHrs, cfg.timeZoneOffsetMin);
+            rtcInitOk = rtcManager->begin(cfg.ntpServer,
                                           cfg.timeZoneOffsetHrs,
                                           /*useEUDst=*/false,
                                           cfg.timeZoneOffsetMin);
         }
     } else {
         // MANUAL: no NTP
-        if (cfg.tz_mode == "posix" && cfg.posix_tz.length() > 0) {
-            logger->info(String("🗺️ [MANUAL] TZ=posix: ") + cfg.posix_tz.c_str());
-            rtcInitOk = rtcManager->beginManual(cfg.posix_tz.c_str());
-        } else if (cfg.tz_mode == "eu" || cfg.useEuDst) {
+        if (cfg.tzMode == TzMode::POSIX) {
+            logger->infof("🗺️ [MANUAL] TZ=posix: %s", cfg.posixTz);
+            rtcInitOk = rtcManager->beginManual(cfg.posixTz);
+        } else if (cfg.tzMode == TzMode::EU) {
             logger->info("🗺️ [MANUAL] TZ=eu (CET/CEST)");
             rtcInitOk = rtcManager->beginManual(/*offsetHrs=*/1, /*useEUDst=*/true, /*offsetMin=*/0);
         } else {
-            logger->info(String("🗺️ [MANUAL] TZ=fixed: ")
-                         + String(cfg.timeZoneOffsetHrs) + ":" + String(cfg.timeZoneOffsetMin));
+            logger->infof("🗺️ [MANUAL] TZ=fixed: %d:%d", cfg.timeZoneOffsetHrs, cfg.timeZoneOffsetMin);
             rtcInitOk = rtcManager->beginManual(cfg.timeZoneOffsetHrs, /*useEUDst=*/false, cfg.timeZoneOffsetMin);
         }
     }
@@ -91,122 +104,440 @@ void SystemManager::begin() {
     if (!rtcInitOk) {
         logger->error("❌ RTC/NTP init failed!");
     }
+    rtcManager->setNtpPollRange(cfg.ntpResyncEveryMinutes, cfg.ntpResyncMaxMinutes);
 
-    // --- Immediate NTP sync (AUTO) + detect real DST flip on the SYSTEM clock ---
-    time_t sysBefore = time(nullptr);
-    tm ltBefore; localtime_r(&sysBefore, &ltBefore);
-    char zBefore[8]; strftime(zBefore, sizeof(zBefore), "%z", &ltBefore);
+    // --- Initial NTP sync (AUTO): started here, consumed by loop() when ready ---
+    // The engine runs from the RTC meanwhile (Wi-Fi may still be associating).
+    // The outcome (incl. before/after DST-flip detection) arrives as a boot
+    // NtpEvent; a real correction then re-runs the catch-up gate.
+    if (isAuto) startNtpSession(/*boot=*/true);
 
-    uint32_t sysDelta = 0;
-    if (isAuto) {
-        rtcManager->syncWithNtp(cfg.resyncRtcIfDiffSeconds);
-        delay(200);
-    }
+    // --- Per channel: load state, compare to *current local time*, set up the bridge ---
+    for (int i = 0; i < channelCount; i++) setupChannel(channels[i]);
+
+    // --- Decide catch-up after init/DST alignment ---
+    doCatchUpIfNeeded();
+
+    // --- Periodic NTP re-sync timer (AUTO) ---
+    lastNtpSyncMs       = millis();
+    lastRtcDisciplineMs = lastNtpSyncMs;
+
+    logger->info("✅ System ready.");
+}
+
+/**
+ * @brief Load a channel's persisted position and configure its pulse engine.
+ */
+void SystemManager::setupChannel(Channel& ch) {
+    const auto& cfg = configManager->getConfig();
+
+    DateTime stateDt = ch.state->loadLastKnownClockTime();
+    DateTime nowDt = TimeSource::localNow();   // MANUAL: system clock was just set from RTC
 
-    time_t sysAfter = time(nullptr);
-    tm ltAfter; localtime_r(&sysAfter, &ltAfter);
-    char zAfter[8];  strftime(zAfter,  sizeof(zAfter),  "%z", &ltAfter);
+    ch.lastImpulseMinutes = minutesOfDay(stateDt);
 
-    bool realDstFlip = (ltBefore.tm_isdst != ltAfter.tm_isdst);
-    sysDelta = (uint32_t) llabs((long long)(sysAfter - sysBefore));
+    int bootDiff = diffForwardMinutes(ch.lastImpulseMinutes, minutesOfDay(nowDt));
+    logger->infof("%sBOOT: state=%02d:%02d | NOW=%02d:%02d | diff=%d min", ch.tag,
+                  stateDt.hour(), stateDt.minute(), nowDt.hour(), nowDt.minute(), bootDiff);
 
-    // Always log TZ flags and NTP outcome
-    logger->info(String("🧭 TZ before/after: ") + zBefore + " → " + zAfter +
-                 String(", isdst: ") + String(ltBefore.tm_isdst) + " → " + String(ltAfter.tm_isdst));
-    if (sysDelta >= (uint32_t)cfg.resyncRtcIfDiffSeconds) {
-        logger->info(String("🌐 NTP: boot-time correction by ") + sysDelta + " s");
+    // --- Pulse backend, timing & anti-duplicate gap ---
+    if (cfg.pulseBackend == PulseTiming::ESP_TIMER) {
+        if (ch.pulse->setBackend(PulseBackend::ESP_TIMER)) {
+            logger->infof("%s⚡ Pulse backend: esp_timer (hardware-timed edges)", ch.tag);
+        } else {
+            logger->errorf("%s❌ esp_timer unavailable — pulse backend falls back to loop.", ch.tag);
+        }
     } else {
-        logger->info("🌐 NTP: no boot-time correction");
+        ch.pulse->setBackend(PulseBackend::LOOP);
     }
+    ch.pulse->setImpulseTimingUs((uint32_t)ch.cfg->pulseWidthUs, (uint32_t)ch.cfg->pulseDeadTimeUs);
+    uint32_t minGap = pulseCycleMs(ch) + 50;
+    if (minGap < 600) minGap = 600;
+    ch.pulse->setMinGapMs(minGap);
+
+    // A lands on odd minutes: each step flips polarity and 1440 is even, so
+    // the parity of the dial position tells which polarity moved it last.
+    ch.pulse->setLastPolarity(ch.lastImpulseMinutes % 2 != 0);
 
-    // --- Load state.txt and compare to *current local time* ---
-    DateTime stateDt = stateManager->loadLastKnownClockTime();
-    DateTime nowDt = isAuto ? SystemLocalNow()
-                            : (rtcInitOk ? rtcManager->now() : SystemLocalNow());
+    // --- Step feedback; the cruise period starts from the profile every boot ---
+    ch.learnedMinMs = (uint32_t)ch.cfg->catchup.minIntervalMs;
+    ch.adaptHold    = ADAPT_HOLD_STEPS;
+    if (ch.cfg->feedback != FeedbackMode::OFF) {
+        ch.pulse->setFeedback(ch.cfg->feedback == FeedbackMode::CURRENT ? PulseSense::CURRENT : PulseSense::SENSOR,
+                              ch.cfg->feedbackPin, ch.cfg->feedbackThreshold);
+        logger->infof("%s🔎 Step feedback: %s on GPIO%d", ch.tag,
+                      ConfigManager::feedbackModeName(ch.cfg->feedback), ch.cfg->feedbackPin);
+    }
+}
 
-    lastImpulseMinutes = minutesOfDay(stateDt);
+/**
+ * @brief Clock engine step: queued commands/NTP results, minute tick, catch-up.
+ *
+ * Runs on the clock task; everything here is non-blocking. Feedback verdicts
+ * of completed pulses are folded in first, then minute ticks (they are due
+ * now), then one catch-up step per channel, starting at a rotating channel so
+ * a tight power budget is shared fairly.
+ */
+void SystemManager::loop() {
+    for (int i = 0; i < channelCount; i++) channels[i].pulse->service(); // advance in-flight waveforms
+    for (int i = 0; i < channelCount; i++) verifyPulse(channels[i]);
+    processCommands();
+    processNtpEvents();
+    serviceMinuteEdge();
+    for (int k = 0; k < channelCount; k++) tickCatchUp(channels[(rrNext + k) % channelCount]);
+    rrNext = (rrNext + 1) % channelCount;
+}
 
-    char sH[6], nH[6];
-    snprintf(sH, sizeof(sH), "%02d:%02d", stateDt.hour(), stateDt.minute());
-    snprintf(nH, sizeof(nH), "%02d:%02d", nowDt.hour(), nowDt.minute());
-    int bootDiff = diffForwardMinutes(lastImpulseMinutes, minutesOfDay(nowDt));
-    logger->info(String("BOOT: state.txt=") + sH + " | NOW=" + nH + " | diff=" + String(bootDiff) + " min");
+/**
+ * @brief Run the per-channel minute check only when it can matter.
+ *
+ * Between edges this is one gettimeofday() compare. The check runs once the
+ * boundary has passed, on a retry request (deferred tick, re-plan), or if the
+ * clock was stepped back so far that the stored edge is more than a minute out.
+ */
+void SystemManager::serviceMinuteEdge() {
+    const int64_t nowUs = TimeSource::epochUs();
+    if (!minuteRetry && nowUs < nextMinuteUs && nextMinuteUs - nowUs <= MINUTE_US) return;
 
-    // --- DST guard: align without catch-up only on a *real* DST flip (~1h) ---
-    if (realDstFlip && sysDelta >= 55*60 && sysDelta <= 65*60) {
-        int nowMin = minutesOfDay(nowDt);
-        lastImpulseMinutes = nowMin;
-        stateManager->saveClockTime(DateTime(2000, 1, 1, nowDt.hour(), nowDt.minute(), 0));
-        logger->info("⛳ Detected ~1h DST/TZ shift — aligned without catch-up.");
+    minuteRetry  = false;
+    minuteEdgeUs = nowUs - nowUs % MINUTE_US;
+    for (int i = 0; i < channelCount; i++) {
+        if (!checkMinuteChange(channels[i])) minuteRetry = true;
     }
+    nextMinuteUs = minuteEdgeUs + MINUTE_US;
+}
 
-    // --- Pulse timing & anti-duplicate gap ---
-    pulseManager->setImpulseTiming(cfg.impulseDelayMs, 150);
-    uint32_t minGap = (uint32_t)cfg.impulseDelayMs + 150 + 50;
-    if (minGap < 600) minGap = 600;
-    pulseManager->setMinGapMs(minGap);
+/**
+ * @brief Time until loop() next has work: a pulse edge, a catch-up step,
+ *        a deferred tick or the next minute boundary (rounded up, never early).
+ */
+uint32_t SystemManager::idleWaitMs() const {
+    if (needsFastService()) return 1;
+    if (minuteRetry) return ENGINE_RETRY_MS;
 
-    // --- Decide catch-up after init/DST alignment ---
-    doCatchUpIfNeeded();
+    uint32_t wait = ENGINE_IDLE_MAX_MS;
+    const int64_t toEdgeUs = nextMinuteUs - TimeSource::epochUs();
+    if (toEdgeUs <= 0) return 1;
+    if (toEdgeUs < (int64_t)wait * 1000) wait = (uint32_t)((toEdgeUs + 999) / 1000);
 
-    // --- Periodic NTP re-sync timer (AUTO) ---
-    lastNtpSyncMs = millis();
+    const uint32_t nowMs = millis();
+    for (int i = 0; i < channelCount; i++) {
+        const Channel& ch = channels[i];
+        if (ch.verifyPending && !ch.catchupActive) { wait = min(wait, ENGINE_RETRY_MS); continue; } // minute pulse: save/verdict
+        if (!ch.catchupActive) continue;
+        if (ch.pulse->busy()) { wait = min(wait, ENGINE_RETRY_MS / 4); continue; } // esp_timer edges: poll finish
+        if (ch.catchupDone == 0) return 1;
+        const uint32_t since = nowMs - ch.catchupLastPulseMs;
+        const uint32_t due   = (since >= ch.catchupIntervalMs) ? 0 : ch.catchupIntervalMs - since;
+        wait = min(wait, due);
+    }
+    return wait ? wait : 1;
+}
 
-    logger->info("✅ System ready.");
+/**
+ * @brief Cut the engine task's idle wait short (new command / NTP result).
+ */
+void SystemManager::wakeEngine() {
+    if (engineTask) xTaskNotifyGive(engineTask);
 }
 
 /**
- * @brief Main loop: minute tick + non-blocking catch-up + periodic NTP (AUTO).
+ * @brief True if any loop-timed pulse is mid-waveform.
  */
-void SystemManager::loop() {
-    checkMinuteChange();
-    tickCatchUp();
+bool SystemManager::needsFastService() const {
+    for (int i = 0; i < channelCount; i++) {
+        if (channels[i].pulse->needsFastService()) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Power budget: a new pulse may start only while fewer than
+ *        max_concurrent_drives coils are energized (coast does not count).
+ */
+bool SystemManager::driveSlotFree() const {
+    int driving = 0;
+    for (int i = 0; i < channelCount; i++) {
+        if (channels[i].pulse->driving()) driving++;
+    }
+    return driving < configManager->getConfig().maxConcurrentDrives;
+}
 
+/**
+ * @brief Network-side step: async NTP boot sync / periodic re-sync (AUTO),
+ *        periodic RTC → system clock discipline (MANUAL).
+ *
+ * Runs on the network/I-O task and never blocks: a pending sync is polled,
+ * otherwise a new one is started when the re-sync interval elapses. The
+ * outcome is posted to the clock engine, which decides on DST alignment or
+ * re-catch-up. In MANUAL the clock engine reads the system clock only, so
+ * the DS1307 is read here once every RTC_DISCIPLINE_EVERY_MS to keep it honest.
+ * A locked fleet follower does neither: it only refreshes the RTC cache from
+ * the leader-disciplined system clock once every FLEET_RTC_EVERY_MS.
+ */
+void SystemManager::serviceNetwork() {
     const auto& cfg = configManager->getConfig();
-    if (cfg.mode != "auto") return;
+    if (fleetFollower) {
+        // A session started before the lock still resolves; the leader keeps time otherwise
+        if (ntpSessionActive) {
+            pollNtpSession();
+            return;
+        }
+        uint32_t nowMs = millis();
+        if ((uint32_t)(nowMs - lastFleetRtcMs) < FLEET_RTC_EVERY_MS) return;
+        lastFleetRtcMs = nowMs;
+        rtcManager->refreshRtcFromSystemClock(cfg.resyncRtcIfDiffSeconds);
+        return;
+    }
+    if (cfg.mode != ClockMode::AUTO) {
+        uint32_t nowMs = millis();
+        if ((uint32_t)(nowMs - lastRtcDisciplineMs) < RTC_DISCIPLINE_EVERY_MS) return;
+        lastRtcDisciplineMs = nowMs;
+        rtcManager->disciplineSystemClock();
+        return;
+    }
 
-    const uint32_t SYNC_EVERY_MS =
-        (uint32_t)cfg.ntpResyncEveryMinutes * 60UL * 1000UL;
-    if (SYNC_EVERY_MS == 0) return;
+    if (networkUpSignal) {
+        networkUpSignal = false;
+        if (ntpSessionActive) {
+            rtcManager->kickNtpSync();
+        } else if (!ntpSynced) {
+            lastNtpSyncMs = millis();
+            startNtpSession(/*boot=*/false);
+            return;
+        }
+    }
+
+    if (ntpSessionActive) {
+        pollNtpSession();
+        return;
+    }
+
+    // Adaptive: grows from ntp_resync_every_minutes while the drift model holds
+    uint32_t syncEveryMs = (uint32_t)rtcManager->ntpPollMinutes() * 60UL * 1000UL;
+    // No NTP yet since boot: retry sooner (backing off), even if periodic re-sync is off
+    if (!ntpSynced && (syncEveryMs == 0 || ntpRetryMs < syncEveryMs)) syncEveryMs = ntpRetryMs;
+    if (syncEveryMs == 0) return;
 
     uint32_t nowMs = millis();
-    if ((uint32_t)(nowMs - lastNtpSyncMs) < SYNC_EVERY_MS) return;
+    if ((uint32_t)(nowMs - lastNtpSyncMs) < syncEveryMs) return;
     lastNtpSyncMs = nowMs;
 
-    // Snapshot SYSTEM clock BEFORE sync
-    time_t sysBefore = time(nullptr);
-    tm ltBefore; localtime_r(&sysBefore, &ltBefore);
-    char zBefore[8]; strftime(zBefore, sizeof(zBefore), "%z", &ltBefore);
+    if (!ntpSynced) ntpRetryMs = min(ntpRetryMs * 2, NTP_RETRY_MAX_MS);
+    startNtpSession(/*boot=*/false);
+}
 
-    rtcManager->syncWithNtp(cfg.resyncRtcIfDiffSeconds);
-    delay(200);
+/**
+ * @brief Snapshot the system clock and kick an async NTP sync.
+ * @param boot true for the initial sync from begin(); it waits longer, since
+ *             Wi-Fi is usually still associating.
+ *
+ * If SNTP is not running (e.g. RTC init failed before NTP setup), a failed
+ * result is posted right away.
+ */
+void SystemManager::startNtpSession(bool boot) {
+    ntpSessionBoot = boot;
+    ntpSysBefore   = time(nullptr);
+    ntpMsBefore    = millis();
+
+    if (rtcManager->startNtpSync(boot ? BOOT_NTP_TIMEOUT_MS : 5000)) {
+        ntpSessionActive = true;
+        return;
+    }
+
+    NtpEvent ev = {};
+    ev.ok   = false;
+    ev.boot = boot;
+    xQueueSend(ntpQueue, &ev, 0);
+    wakeEngine();
+}
+
+/**
+ * @brief Poll the async sync; on completion post the outcome to the clock engine.
+ *
+ * The correction is measured against where the system clock *would* be
+ * without the sync (before + elapsed millis), so waiting for the reply never
+ * shows up as a time jump. DST flags are compared at that same instant.
+ */
+void SystemManager::pollNtpSession() {
+    const auto& cfg = configManager->getConfig();
+    // At boot the RTC cache is refreshed as soon as it is a second off (offline starts)
+    NtpSyncStatus st = rtcManager->pollNtpSync(ntpSessionBoot ? 1 : cfg.resyncRtcIfDiffSeconds);
+    if (st == NtpSyncStatus::PENDING) return;
+    ntpSessionActive = false;
+    if (st == NtpSyncStatus::DONE) ntpSynced = true;
+
+    NtpEvent ev = {};
+    ev.ok   = (st == NtpSyncStatus::DONE);
+    ev.boot = ntpSessionBoot;
+
+    if (ev.ok) {
+        const uint32_t elapsedSec = (uint32_t)(millis() - ntpMsBefore + 500) / 1000UL;
+        fillClockDelta(ev, ntpSysBefore + (time_t)elapsedSec, time(nullptr));
+    } else if (rtcManager->driftModelValid()) {
+        // No NTP: hold time on the drift-corrected RTC instead of the free-running crystal
+        rtcManager->disciplineSystemClock();
+    }
+    const RtcDriftModel& dm = rtcManager->driftModel();
+    ev.driftPpm    = dm.ppm;
+    ev.driftErrPpm = dm.errPpm;
+    ev.pollMinutes = rtcManager->ntpPollMinutes();
+
+    if (xQueueSend(ntpQueue, &ev, 0) != pdTRUE) {
+        logger->warn("⚠️ NTP result dropped (clock engine queue full).");
+    }
+    wakeEngine();
+}
 
-    // Snapshot SYSTEM clock AFTER sync
-    time_t sysAfter = time(nullptr);
-    tm ltAfter; localtime_r(&sysAfter, &ltAfter);
-    char zAfter[8];  strftime(zAfter,  sizeof(zAfter),  "%z", &ltAfter);
+/**
+ * @brief Offsets, DST flags and |delta| between where the clock would be
+ *        (@p sysExpected) and where it is after a correction (@p sysAfter).
+ */
+void SystemManager::fillClockDelta(NtpEvent& ev, time_t sysExpected, time_t sysAfter) {
+    tm ltBefore; localtime_r(&sysExpected, &ltBefore);
+    tm ltAfter;  localtime_r(&sysAfter,    &ltAfter);
+    strftime(ev.zBefore, sizeof(ev.zBefore), "%z", &ltBefore);
+    strftime(ev.zAfter,  sizeof(ev.zAfter),  "%z", &ltAfter);
 
-    const bool dstFlip = (ltBefore.tm_isdst != ltAfter.tm_isdst);
-    const uint32_t sysDelta = (uint32_t) llabs((long long)(sysAfter - sysBefore));
+    ev.isdstBefore = (int8_t)ltBefore.tm_isdst;
+    ev.isdstAfter  = (int8_t)ltAfter.tm_isdst;
+    ev.dstFlip     = (ltBefore.tm_isdst != ltAfter.tm_isdst);
+    ev.sysDelta    = (uint32_t) llabs((long long)(sysAfter - sysExpected));
+}
 
-    logger->info(String("🧭 TZ before/after: ") + zBefore + " → " + zAfter +
-                 String(", isdst: ") + String(ltBefore.tm_isdst) + " → " + String(ltAfter.tm_isdst));
+// ──────────────────────────────────────────────────────────────────────────────
+// Fleet follower (see FleetManager)
+// ──────────────────────────────────────────────────────────────────────────────
 
-    if (sysDelta == 0) return;
+/**
+ * @brief Enter/leave the fleet follower lock (network task).
+ *
+ * Locking pauses SNTP so the follower's own polls do not fight the leader.
+ * Unlocking resumes it and, in AUTO, asks NTP right away: the node is on its
+ * own again and the last beacon may be a while ago.
+ */
+void SystemManager::setFleetFollower(bool locked) {
+    if (locked == fleetFollower) return;
+    fleetFollower = locked;
+    const auto& cfg = configManager->getConfig();
+
+    if (locked) {
+        lastFleetRtcMs = millis();
+        rtcManager->setNtpPaused(true);
+        logger->info("🛰️ Fleet: following the leader's time (local NTP paused).");
+        return;
+    }
+    rtcManager->setNtpPaused(false);
+    logger->warn("🛰️ Fleet: leader lost — keeping time locally.");
+    if (cfg.mode == ClockMode::AUTO && !ntpSessionActive) {
+        lastNtpSyncMs = millis();
+        startNtpSession(/*boot=*/false);
+    }
+}
+
+/**
+ * @brief Step the system clock by @p offsetUs (leader − local), network task.
+ *
+ * Steps are small (ms) once locked and the engine picks them up at its next
+ * wake-up; the minute edge is re-derived from the system clock, so the next
+ * tick lands on the leader's edge. A step of a second or more, or one that
+ * crosses a DST change, is posted like an NTP correction so the engine can
+ * re-plan (see handleNtpResult()).
+ */
+void SystemManager::applyFleetOffset(int64_t offsetUs) {
+    const time_t  sysBefore = time(nullptr);
+    const int64_t targetUs  = TimeSource::epochUs() + offsetUs;
+    timeval tv = { (time_t)(targetUs / 1000000), (suseconds_t)(targetUs % 1000000) };
+    settimeofday(&tv, nullptr);
+
+    NtpEvent ev = {};
+    ev.ok    = true;
+    ev.fleet = true;
+    fillClockDelta(ev, sysBefore, sysBefore + (time_t)(offsetUs / 1000000));
+    ev.sysDelta = (uint32_t)((llabs((long long)offsetUs) + 500000) / 1000000);
+    if (ev.sysDelta == 0 && !ev.dstFlip) {
+        wakeEngine();   // re-derive the idle wait against the stepped clock
+        return;
+    }
+
+    const RtcDriftModel& dm = rtcManager->driftModel();
+    ev.driftPpm    = dm.ppm;
+    ev.driftErrPpm = dm.errPpm;
+    ev.pollMinutes = rtcManager->ntpPollMinutes();
+    if (xQueueSend(ntpQueue, &ev, 0) != pdTRUE) {
+        logger->warn("⚠️ Fleet step dropped (clock engine queue full).");
+    }
+    wakeEngine();
+}
+
+/**
+ * @brief Drain manual-set commands posted by the web task.
+ */
+void SystemManager::processCommands() {
+    ClockCommand cmd;
+    while (xQueueReceive(cmdQueue, &cmd, 0) == pdTRUE) {
+        PlanReply reply = { cmd.seq, applyManualClockSet(channels[cmd.channel], cmd.clockMinutes) };
+        reply.plan.seq = cmd.seq;
+        xQueueOverwrite(planQueue, &reply);
+        publishPlan(cmd.channel, cmd.clockMinutes, reply.plan);
+    }
+}
+
+/**
+ * @brief Drain NTP re-sync outcomes posted by serviceNetwork().
+ */
+void SystemManager::processNtpEvents() {
+    NtpEvent ev;
+    while (xQueueReceive(ntpQueue, &ev, 0) == pdTRUE) {
+        handleNtpResult(ev);
+    }
+}
+
+/**
+ * @brief React to one NTP re-sync (or fleet step): align on a real DST flip,
+ *        re-catch-up on drift.
+ */
+void SystemManager::handleNtpResult(const NtpEvent& ev) {
+    const auto& cfg = configManager->getConfig();
+    publishNtp(ev);
 
-    if (dstFlip && sysDelta >= 55*60 && sysDelta <= 65*60) {
-        // Align state to *current system local time* without catch-up
-        DateTime after = SystemLocalNow();
-        int nowMin = minutesOfDay(after);
-        lastImpulseMinutes = nowMin;
-        stateManager->saveClockTime(DateTime(2000, 1, 1, after.hour(), after.minute(), 0));
-        logger->info("🌐 NTP: detected ~1h DST/TZ shift. Aligned without catch-up.");
+    if (!ev.ok) {
+        logger->warn(ev.boot ? "⚠️ NTP: boot-time sync failed — running on RTC time."
+                             : "⚠️ NTP: re-sync failed.");
         return;
     }
 
-    if (sysDelta >= (uint32_t)cfg.resyncRtcIfDiffSeconds) {
-        logger->info(String("🌐 NTP: corrected by ") + sysDelta + " s — starting re-catch-up.");
-        tryStartCatchUp("ntp-resync");
+    logger->infof("🧭 TZ before/after: %s → %s, isdst: %d → %d",
+                  ev.zBefore, ev.zAfter, ev.isdstBefore, ev.isdstAfter);
+    if (!ev.fleet && ev.driftErrPpm > 0.0f) {
+        logger->infof("📈 RTC drift %+.2f ppm (±%.2f); next NTP poll in %d min",
+                      ev.driftPpm, ev.driftErrPpm, ev.pollMinutes);
+    }
+    if (ev.boot) {
+        if (ev.sysDelta >= (uint32_t)cfg.resyncRtcIfDiffSeconds) {
+            logger->infof("🌐 NTP: boot-time correction by %lu s", (unsigned long)ev.sysDelta);
+        } else {
+            logger->info("🌐 NTP: no boot-time correction");
+        }
+    }
+
+    if (ev.sysDelta == 0) return;
+
+    // A DST/TZ flip or a real correction goes through the same planner:
+    // spring-forward steps, fall-back usually holds (see planConvergence()).
+    if (!ev.dstFlip && ev.sysDelta < (uint32_t)cfg.resyncRtcIfDiffSeconds) return;
+
+    const char* src = ev.fleet ? "🛰️ Fleet" : "🌐 NTP";
+    logger->infof("%s: corrected by %lu s%s — re-planning.",
+                  src, (unsigned long)ev.sysDelta, ev.dstFlip ? " (DST/TZ flip)" : "");
+    for (int i = 0; i < channelCount; i++) {
+        Channel& ch = channels[i];
+        if (ch.catchupActive) {
+            // The session re-plans against current local time when it finishes.
+            logger->infof("%s%s: time moved during catch-up — final re-plan covers it.", ch.tag, src);
+            continue;
+        }
+        tryStartCatchUp(ch, ev.fleet ? "fleet" : ev.boot ? "ntp-boot" : "ntp-resync");
     }
 }
 
@@ -216,7 +547,7 @@ void SystemManager::loop() {
  */
 uint32_t SystemManager::initialNtpSyncDeltaSecIfAuto() {
     const auto& cfg = configManager->getConfig();
-    if (cfg.mode != "auto") return 0;
+    if (cfg.mode != ClockMode::AUTO) return 0;
     DateTime before = rtcManager->now();
     rtcManager->syncWithNtp(cfg.resyncRtcIfDiffSeconds);
     delay(200);
@@ -228,144 +559,535 @@ uint32_t SystemManager::initialNtpSyncDeltaSecIfAuto() {
  * @brief Decide whether to start catch-up after boot/init.
  */
 void SystemManager::doCatchUpIfNeeded() {
-    tryStartCatchUp("boot");
+    for (int i = 0; i < channelCount; i++) tryStartCatchUp(channels[i], "boot");
 }
 
 /**
  * @brief Centralized gate to start a catch-up session.
  */
-void SystemManager::tryStartCatchUp(const char* reason) {
-    if (catchupActive) return;
+void SystemManager::tryStartCatchUp(Channel& ch, const char* reason) {
+    if (ch.catchupActive) return;
+    planConvergence(ch, reason);
+}
+
+/**
+ * @brief Bring the dial to real time by the faster of two strategies.
+ * @param reason Tag for the log line.
+ * @return The chosen plan (also used as the manual-set reply).
+ *
+ * - Forward: step `forward` minutes along the catch-up profile, grown by the
+ *   minutes that pass while stepping (forwardConvergeMs()).
+ * - Hold:   the dial is `back` minutes ahead; pause minute pulses until real
+ *   time reaches it (≈ back × 60 s).
+ * Each strategy is allowed only up to max_catchup_minutes; if neither is,
+ * the plan is REJECTED and the dial keeps ticking from its current offset.
+ * This also covers DST fall-back (dial 60 min ahead) without a special case.
+ */
+CatchUpPlan SystemManager::planConvergence(Channel& ch, const char* reason) {
+    CatchUpPlan plan;
+    ch.holdActive = false;
 
-    // In AUTO use system time; in MANUAL use RTC
-    const bool isAuto = (configManager->getConfig().mode == "auto");
-    DateTime now = isAuto ? SystemLocalNow() : rtcManager->now();
-    int realMin  = minutesOfDay(now);
+    const int realMin  = TimeSource::minutesOfDay();
+    const int forward  = diffForwardMinutes(ch.lastImpulseMinutes, realMin);
+    const int maxCatch = configManager->getConfig().maxCatchupMinutes;
 
-    int diff = diffForwardMinutes(lastImpulseMinutes, realMin);
-    if (diff == 0) {
-        logger->info("⏱ Clocks are up-to-date — no catch-up needed.");
-        return;
+    plan.status = CatchUpPlanStatus::PLANNED;
+    if (forward == 0) {
+        logger->infof("%s⏱ Clocks are up-to-date — no catch-up needed.", ch.tag);
+        return plan;
     }
 
-    int maxCatch = configManager->getConfig().maxCatchupMinutes;
-    if (diff > maxCatch) {
-        logger->error("❌ Catch-up exceeds limit! Difference: " + String(diff) + " minutes");
-        return;
+    const int back = 1440 - forward;
+    int       pulses = forward;
+    const uint32_t fwdMs  = forwardConvergeMs(ch, pulses);
+    const uint32_t holdMs = (uint32_t)back * 60000UL - TimeSource::msIntoMinute();
+
+    const bool fwdOk  = forward <= maxCatch;
+    const bool holdOk = back    <= maxCatch;
+
+    if (holdOk && (!fwdOk || holdMs < fwdMs)) {
+        ch.holdActive    = true;
+        plan.status      = CatchUpPlanStatus::HOLD;
+        plan.holdMinutes = back;
+        plan.etaMs       = holdMs;
+        logger->infof("%s⏸️ Dial %d min ahead (%s) — holding ~%lu s instead of %d pulses.", ch.tag,
+                      back, reason, (unsigned long)(holdMs / 1000), pulses);
+        recordEvent(ch, EvlType::HOLD_START, back, (int32_t)holdMs);
+        publishCatchUp(ch, true);
+        return plan;
+    }
+
+    if (!fwdOk) {
+        logger->errorf("%s❌ Catch-up exceeds limit! Difference: %d minutes", ch.tag, forward);
+        plan.status = CatchUpPlanStatus::REJECTED;
+        plan.pulses = forward;
+        // Keep ticking from the current offset: the next minute check (right
+        // away, not at the next edge) emits one pulse and re-bases on real time.
+        ch.lastImpulseMinutes = (realMin + 1439) % 1440;
+        minuteRetry = true;
+        return plan;
+    }
+
+    startCatchUp(ch, pulses, reason);
+    plan.pulses     = pulses;
+    plan.intervalMs = ch.learnedMinMs;
+    plan.etaMs      = fwdMs;
+    return plan;
+}
+
+/**
+ * @brief Time for a forward catch-up that also absorbs the minutes that tick
+ *        over while it runs; @p pulses is updated to the total step count.
+ */
+uint32_t SystemManager::forwardConvergeMs(const Channel& ch, int& pulses) {
+    const uint32_t toNextMinute = 60000UL - TimeSource::msIntoMinute();
+    const int      base = pulses;
+    uint32_t       eta  = catchUpEtaMs(ch, 0, pulses);
+
+    for (int i = 0; i < 8; i++) {
+        const int ticks = (eta < toNextMinute) ? 0 : 1 + (int)((eta - toNextMinute) / 60000UL);
+        if (base + ticks == pulses) break;
+        pulses = base + ticks;
+        eta    = catchUpEtaMs(ch, 0, pulses);
     }
+    return eta;
+}
+
+/**
+ * @brief Enter catch-up mode along the configured speed profile (cfg.catchup).
+ */
+void SystemManager::startCatchUp(Channel& ch, int diffMinutes, const char* reason) {
+    const CatchUpProfile& p = ch.cfg->catchup;
+
+    ch.catchupRemaining   = diffMinutes;
+    ch.catchupTotal       = diffMinutes;
+    ch.catchupDone        = 0;
+    ch.catchupStartMs     = millis();
+    ch.catchupIntervalMs  = catchUpPeriodMs(ch, 0, diffMinutes);
+    ch.catchupLastPulseMs = 0;
+    ch.catchupActive      = true;
 
-    startCatchUp(diff, reason);
+    const uint32_t eta = catchUpEtaMs(ch, 0, diffMinutes);
+    logger->infof("%s⚙️ Catch-up start: %d pulses (%s), %d→%lu ms, ETA %lu.%lu s", ch.tag,
+                  diffMinutes, reason, max(p.startIntervalMs, (int)ch.learnedMinMs), (unsigned long)ch.learnedMinMs,
+                  (unsigned long)(eta / 1000), (unsigned long)(eta % 1000 / 100));
+    recordEvent(ch, EvlType::CATCHUP_START, diffMinutes, (int32_t)eta);
+    publishCatchUp(ch, true);
 }
 
 /**
- * @brief Enter catch-up mode with a fixed interval between pulses.
+ * @brief Start-to-start period before step @p index of a @p total-step session.
+ *
+ * max(ramp-up, slow-down): the first rampPulses steps accelerate from
+ * startIntervalMs to the cruise period, the last slowdownPulses steps
+ * decelerate back, so short sessions never reach cruise speed. The cruise
+ * period is minIntervalMs, or what step feedback has learned (learnedMinMs).
+ */
+uint32_t SystemManager::catchUpPeriodMs(const Channel& ch, int index, int total) {
+    const CatchUpProfile& p = ch.cfg->catchup;
+    const int cruise  = ch.learnedMinMs ? (int)ch.learnedMinMs : p.minIntervalMs;
+    const int startMs = max(p.startIntervalMs, cruise);
+    const int span    = startMs - cruise;
+
+    int accel = cruise;
+    if (index < p.rampPulses) accel = startMs - span * index / p.rampPulses;
+
+    const int left = total - 1 - index;   // steps after this one
+    int decel = cruise;
+    if (left < p.slowdownPulses) decel = startMs - span * left / p.slowdownPulses;
+
+    return (uint32_t)max(accel, decel);
+}
+
+/**
+ * @brief Estimated time until step total-1 completes, if step @p nextIndex fires now.
  */
-void SystemManager::startCatchUp(int diffMinutes, const char* reason) {
-    catchupRemaining   = diffMinutes;
-    catchupIntervalMs  = (uint32_t)configManager->getConfig().impulseDelayMs + 150 + 50;
-    catchupLastPulseMs = 0;
-    catchupActive      = true;
+uint32_t SystemManager::catchUpEtaMs(const Channel& ch, int nextIndex, int total) {
+    if (nextIndex >= total) return 0;
+    uint32_t eta = pulseCycleMs(ch);
+    for (int i = nextIndex + 1; i < total; i++) eta += catchUpPeriodMs(ch, i, total);
+    return eta;
+}
+
+/**
+ * @brief Live catch-up progress for the status endpoint.
+ */
+bool SystemManager::catchUpStatus(int channel, CatchUpStatus& st) const {
+    if (channel < 0 || channel >= channelCount) return false;
+    const Channel& ch = channels[channel];
+
+    st = CatchUpStatus();
+    strlcpy(st.name, ch.cfg->name, sizeof(st.name));
+    st.clockMinutes = ch.state->clockMinutes();
+    st.edgeOffsetUs = ch.edgeOffsetUs;
+    st.feedback      = ch.feedbackFault ? "fault" : ConfigManager::feedbackModeName(ch.cfg->feedback);
+    st.minIntervalMs = ch.learnedMinMs;
+    st.missed        = ch.missedTotal;
+    st.active = ch.catchupActive;
+    if (!st.active) {
+        st.holding = ch.holdActive;
+        if (st.holding) {
+            const int ahead = diffForwardMinutes(TimeSource::minutesOfDay(), ch.lastImpulseMinutes);
+            st.etaMs = (uint32_t)ahead * 60000UL - TimeSource::msIntoMinute();
+        }
+        return true;
+    }
+
+    st.done       = ch.catchupDone;
+    st.remaining  = ch.catchupRemaining;
+    st.intervalMs = ch.catchupIntervalMs;
+    st.etaMs      = catchUpEtaMs(ch, ch.catchupDone, ch.catchupTotal);
 
-    logger->info(String("⚙️ Catch-up start: ") + diffMinutes + " pulses (" + reason + "), interval "
-                 + String(catchupIntervalMs) + " ms");
+    const uint32_t elapsed = millis() - ch.catchupStartMs;
+    if (elapsed > 0) st.pulsesPerSec = st.done * 1000.0f / (float)elapsed;
+    return true;
 }
 
 /**
- * @brief Non-blocking catch-up engine; emits pulses at catchupIntervalMs until done.
+ * @brief Non-blocking catch-up engine; emits pulses along the profile until done.
+ *
+ * Each step fires once ch.catchupIntervalMs has passed since the previous step
+ * *started*; while a pulse is still driving/coasting (or its save and feedback
+ * verdict are pending) this returns immediately.
  */
-void SystemManager::tickCatchUp() {
-    if (!catchupActive) return;
+void SystemManager::tickCatchUp(Channel& ch) {
+    if (!ch.catchupActive) return;
+    if (ch.pulse->busy() || ch.verifyPending) return; // previous step still in flight
+    if (!driveSlotFree()) return;  // power budget: another coil is energized
 
     uint32_t nowMs = millis();
-    if (catchupLastPulseMs == 0 || (nowMs - catchupLastPulseMs) >= catchupIntervalMs) {
-        bool sent = pulseManager->triggerPulse(true); // burst=true during catch-up
+    if (ch.catchupDone == 0 || (nowMs - ch.catchupLastPulseMs) >= ch.catchupIntervalMs) {
+        bool sent = ch.pulse->triggerPulse(true); // burst=true during catch-up
         if (!sent) return;
 
-        catchupLastPulseMs = millis();
+        ch.verifyPending  = true;   // saved (and verified) once the pulse has finished
+        ch.verifyCatchUp  = true;
+        ch.verifyAtCruise = ch.catchupDone > 0 && ch.catchupIntervalMs <= ch.learnedMinMs;
 
-        // advance internal clock by +1 minute
-        lastImpulseMinutes = (lastImpulseMinutes + 1) % 1440;
+        ch.catchupLastPulseMs = nowMs;
+        ch.catchupDone++;
+        ch.catchupIntervalMs  = catchUpPeriodMs(ch, ch.catchupDone, ch.catchupTotal);
 
-        // persist intermediate state (2000-01-01 HH:MM:00)
-        int h = lastImpulseMinutes / 60;
-        int m = lastImpulseMinutes % 60;
-        stateManager->saveClockTime(DateTime(2000, 1, 1, h, m, 0));
+        // advance internal clock by +1 minute (persisted by verifyPulse())
+        ch.lastImpulseMinutes = (ch.lastImpulseMinutes + 1) % 1440;
 
-        logger->info(String("📌 Catch-up remaining: ") + String(catchupRemaining - 1));
+        if (eventLog) {
+            recordEvent(ch, EvlType::CATCHUP_STEP, ch.catchupRemaining - 1, ch.lastImpulseMinutes);
+            logger->tracef("%s📌 Catch-up remaining: %d", ch.tag, ch.catchupRemaining - 1);
+        } else {
+            logger->infof("%s📌 Catch-up remaining: %d", ch.tag, ch.catchupRemaining - 1);
+        }
 
-        if (--catchupRemaining <= 0) {
-            catchupActive = false;
-            logger->info("✅ Catch-up finished.");
+        if (--ch.catchupRemaining <= 0) {
+            ch.catchupActive = false;
+            const uint32_t elapsed = nowMs - ch.catchupStartMs + pulseCycleMs(ch);
+            logger->infof("%s✅ Catch-up finished: %d pulses in %lu ms (%.2f pulses/s).", ch.tag,
+                          ch.catchupDone, (unsigned long)elapsed,
+                          ch.catchupDone * 1000.0f / (float)elapsed);
+            recordEvent(ch, EvlType::CATCHUP_END, ch.catchupDone, (int32_t)elapsed);
+            publishCatchUp(ch, true);
 
-            // Align to actual *current local time*
-            const bool isAuto = (configManager->getConfig().mode == "auto");
-            DateTime now = isAuto ? SystemLocalNow() : rtcManager->now();
-            lastImpulseMinutes = minutesOfDay(now);
-            stateManager->saveClockTime(DateTime(2000, 1, 1, now.hour(), now.minute(), 0));
+            // Minutes that passed (or a DST/TZ jump) meanwhile: re-plan from the dial position
+            if (ch.lastImpulseMinutes != TimeSource::minutesOfDay()) planConvergence(ch, "residual");
+        } else {
+            publishCatchUp(ch, false);
         }
     }
 }
 
 /**
- * @brief Regular minute tick handler (disabled during catch-up).
+ * @brief Persist the new position once the pulse has completed, acting on
+ *        the feedback verdict if there is one.
+ *
+ * The save never happens while the coil is still driven: a power loss
+ * mid-pulse leaves the stored position equal to the dial, and one right after
+ * the pulse (save not yet committed) heals itself at boot, because the next
+ * pulse repeats the polarity the movement has just taken and is ignored.
+ * Without feedback the position is saved as assumed.
+ *
+ * Confirmed: the position advanced as assumed and is saved now. Missed: the dial
+ * did not move, so the position steps back a minute, the alternation repeats
+ * the missed polarity and the step is retried at once — as one extra step of
+ * a running catch-up, otherwise through planConvergence(). The one exception
+ * is a position sensor's first verdict since boot, see below. FEEDBACK_MAX_MISSES misses in
+ * a row mean the input itself is suspect: the channel runs open loop until
+ * reboot.
  */
-void SystemManager::checkMinuteChange() {
-    if (catchupActive) return;
+void SystemManager::verifyPulse(Channel& ch) {
+    if (!ch.verifyPending || ch.pulse->busy()) return;
+    ch.verifyPending = false;
+
+    const PulseFeedback fb = ch.pulse->lastFeedback();
+    if (fb == PulseFeedback::NONE) {   // open loop
+        ch.state->queueSave(DateTime(2000, 1, 1, ch.lastImpulseMinutes / 60, ch.lastImpulseMinutes % 60, 0));
+        return;
+    }
+    if (fb == PulseFeedback::OK) {
+        Metrics::count(Metric::PULSES_CONFIRMED);
+        ch.missStreak = 0;
+        ch.polarityVerified = true;
+        ch.state->queueSave(DateTime(2000, 1, 1, ch.lastImpulseMinutes / 60, ch.lastImpulseMinutes % 60, 0));
+        if (ch.verifyCatchUp) adaptCatchUpRate(ch, true);
+        return;
+    }
+
+    Metrics::count(Metric::PULSES_MISSED);
+    ch.missedTotal++;
+    const int sample = ch.pulse->lastFeedbackSample();
+    if (++ch.missStreak >= FEEDBACK_MAX_MISSES) {
+        ch.feedbackFault = true;
+        ch.pulse->setFeedback(PulseSense::NONE, -1);
+        logger->errorf("%s❌ Step feedback: %d misses in a row (last reading %d) — open loop until reboot, check the dial.",
+                       ch.tag, ch.missStreak, sample);
+        return;
+    }
 
-    // In AUTO use system time; in MANUAL use RTC
-    const bool isAuto = (configManager->getConfig().mode == "auto");
-    DateTime now = isAuto ? SystemLocalNow() : rtcManager->now();
+    if (!ch.polarityVerified && ch.pulse->feedbackSense() == PulseSense::SENSOR) {
+        // First verdict since boot: the movement ignored this polarity because
+        // it already made that step — taken right before the power loss, its
+        // save lost. The position is right; only the stored one was behind.
+        // (No coil current, in contrast, means the pulse never drove: retried.)
+        ch.polarityVerified = true;
+        ch.missStreak       = 0;
+        ch.state->queueSave(DateTime(2000, 1, 1, ch.lastImpulseMinutes / 60, ch.lastImpulseMinutes % 60, 0));
+        recordEvent(ch, EvlType::PULSE_MISSED, ch.lastImpulseMinutes, sample);
+        logger->warnf("%s⚠️ Step not taken (feedback %d) — dial already at %02d:%02d (unsaved step before power loss).",
+                      ch.tag, sample, ch.lastImpulseMinutes / 60, ch.lastImpulseMinutes % 60);
+        return;
+    }
+
+    // Slip: the dial is still where it was before the pulse
+    ch.lastImpulseMinutes = (ch.lastImpulseMinutes + 1439) % 1440;
+    ch.pulse->setLastPolarity(ch.lastImpulseMinutes % 2 != 0);
+    ch.state->queueSave(DateTime(2000, 1, 1, ch.lastImpulseMinutes / 60, ch.lastImpulseMinutes % 60, 0));
+    recordEvent(ch, EvlType::PULSE_MISSED, ch.lastImpulseMinutes, sample);
+    logger->warnf("%s⚠️ Step missed (feedback %d) — dial still at %02d:%02d, retrying.", ch.tag, sample,
+                  ch.lastImpulseMinutes / 60, ch.lastImpulseMinutes % 60);
+
+    if (ch.verifyCatchUp) adaptCatchUpRate(ch, false);
+    if (ch.catchupActive) {
+        ch.catchupRemaining++;
+        ch.catchupTotal++;
+        ch.catchupIntervalMs = catchUpPeriodMs(ch, ch.catchupDone, ch.catchupTotal);
+    } else {
+        planConvergence(ch, "retry");
+    }
+}
+
+/**
+ * @brief Closed-loop catch-up speed: additive speed-up, multiplicative back-off.
+ *
+ * Only steps fired at the cruise period count as evidence for going faster
+ * (ADAPT_SPEEDUP_MS each, after ADAPT_HOLD_STEPS of them, never below one
+ * pulse + 20 ms). A missed step slows the cruise by a quarter, up to twice
+ * the start period. Learned in RAM only; each boot starts from the profile.
+ */
+void SystemManager::adaptCatchUpRate(Channel& ch, bool confirmed) {
+    const uint32_t floorMs = pulseCycleMs(ch) + 20;   // as ConfigManager::clampCatchUpProfile()
+    if (confirmed) {
+        if (!ch.verifyAtCruise) return;
+        if (ch.adaptHold > 0) { ch.adaptHold--; return; }
+        if (ch.learnedMinMs > floorMs) ch.learnedMinMs = max(floorMs, ch.learnedMinMs - ADAPT_SPEEDUP_MS);
+        return;
+    }
+    const uint32_t ceilMs = 2UL * (uint32_t)ch.cfg->catchup.startIntervalMs;
+    ch.learnedMinMs = min(ceilMs, ch.learnedMinMs + ch.learnedMinMs / 4);
+    ch.adaptHold    = ADAPT_HOLD_STEPS;
+    logger->infof("%s🐢 Catch-up cruise backed off to %lu ms.", ch.tag, (unsigned long)ch.learnedMinMs);
+}
+
+/**
+ * @brief Regular minute tick handler (disabled during catch-up and hold).
+ * @return false if the tick is deferred and must be retried shortly.
+ *
+ * Exactly one step forward → one pulse. Any other difference (DST/TZ jump,
+ * clock step) goes through planConvergence(). On a fleet follower the system
+ * clock read here is stepped to the leader's beacons (applyFleetOffset()), so
+ * the tick follows the leader's minute edge.
+ */
+bool SystemManager::checkMinuteChange(Channel& ch) {
+    if (ch.catchupActive) return true;      // the session's final re-plan covers this minute
+    if (ch.pulse->busy() || ch.verifyPending) return false; // let the last pulse finish (and verify)
+
+    // System clock in both modes (MANUAL keeps it disciplined from the RTC)
+    DateTime now = TimeSource::localNow();
     int nowMin = minutesOfDay(now);
 
-    if (nowMin != lastImpulseMinutes) {
-        bool sent = pulseManager->triggerPulse(false); // normal mode — min-gap applies
-        if (!sent) {
-            logger->info("⏭️ Pulse skipped (min-gap).");
-            return;
+    if (nowMin == ch.lastImpulseMinutes) {
+        if (ch.holdActive) {
+            ch.holdActive = false;
+            logger->infof("%s▶️ Hold finished — dial matches real time.", ch.tag);
+            recordEvent(ch, EvlType::HOLD_END, nowMin, 0);
+            publishCatchUp(ch, true);
         }
+        return true;
+    }
+    if (ch.holdActive) return true; // dial ahead; wait for real time
+
+    if (diffForwardMinutes(ch.lastImpulseMinutes, nowMin) != 1) {
+        planConvergence(ch, "jump");
+        return true;
+    }
+
+    if (!driveSlotFree()) return false;  // power budget: retried shortly
 
-        char hhmm[6];
-        snprintf(hhmm, sizeof(hhmm), "%02d:%02d", now.hour(), now.minute());
-        logger->info(String("🕒 Pulse for ") + hhmm);
+    bool sent = ch.pulse->triggerPulse(false); // normal mode — min-gap applies
+    if (!sent) {
+        logger->infof("%s⏭️ Pulse skipped (min-gap).", ch.tag);
+        return false;
+    }
+    ch.verifyPending = true;   // saved (and verified) once the pulse has finished
+    ch.verifyCatchUp = false;
+    ch.edgeOffsetUs = (int32_t)(TimeSource::epochUs() - minuteEdgeUs);
+    if (ch.edgeOffsetUs >= 0) Metrics::observe(Latency::MINUTE_EDGE_US, (uint32_t)ch.edgeOffsetUs);
 
-        lastImpulseMinutes = nowMin;
-        stateManager->saveClockTime(DateTime(2000, 1, 1, now.hour(), now.minute(), 0));
+    if (eventLog) {
+        recordEvent(ch, EvlType::PULSE, nowMin, ch.edgeOffsetUs);
+        logger->tracef("%s🕒 Pulse for %02d:%02d (+%ld.%ld ms)", ch.tag, now.hour(), now.minute(),
+                       (long)(ch.edgeOffsetUs / 1000), (long)(ch.edgeOffsetUs % 1000 / 100));
+    } else {
+        logger->infof("%s🕒 Pulse for %02d:%02d (+%ld.%ld ms)", ch.tag, now.hour(), now.minute(),
+                      (long)(ch.edgeOffsetUs / 1000), (long)(ch.edgeOffsetUs % 1000 / 100));
     }
+
+    ch.lastImpulseMinutes = nowMin;
+    publishPulse(ch, nowMin);
+    return true;
 }
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Live events (/api/events)
+// ──────────────────────────────────────────────────────────────────────────────
+
 /**
- * @brief Handle manual HH:MM entry (from Web UI).
+ * @brief "pulse": one regular minute pulse and how late after :00 it started.
  */
-void SystemManager::OnManualClockSet(int clockMinutes) {
-    // In AUTO use system time; in MANUAL use RTC
-    const bool isAuto = (configManager->getConfig().mode == "auto");
-    DateTime now = isAuto ? SystemLocalNow() : rtcManager->now();
-    int nowMin = minutesOfDay(now);
-    int diff = diffForwardMinutes(clockMinutes, nowMin);
+void SystemManager::publishPulse(const Channel& ch, int clockMinutes) {
+    if (!events || !events->active()) return;
+    events->publishf(EventType::PULSE,
+                     "{\"channel\":%d,\"name\":\"%s\",\"clock_time\":\"%02d:%02d\",\"edge_offset_ms\":%.1f}",
+                     (int)(&ch - channels), ch.cfg->name, clockMinutes / 60, clockMinutes % 60,
+                     ch.edgeOffsetUs / 1000.0f);
+}
 
-    int ch = clockMinutes / 60, cm = clockMinutes % 60;
-    logger->info(String("🛠️ Manual set: entered ")
-                 + (ch < 10 ? "0" : "") + ch + ":" + (cm < 10 ? "0" : "") + cm
-                 + " (min=" + String(clockMinutes) + "), target NOW "
-                 + String(now.hour()<10?"0":"") + now.hour() + ":" + String(now.minute()<10?"0":"") + now.minute()
-                 + " (min=" + String(nowMin) + "), forward diff = " + String(diff) + " min");
-
-    int maxCatch = configManager->getConfig().maxCatchupMinutes;
-    if (diff > maxCatch) {
-        logger->error("❌ Manual set: difference " + String(diff) + " min exceeds limit "
-                      + String(maxCatch) + ". Stop.");
-        lastImpulseMinutes = clockMinutes % 1440; // still persist for consistent ticks
-        stateManager->saveClockTime(DateTime(2000,1,1, ch, cm, 0));
-        return;
+/**
+ * @brief "catchup": same fields as /api/status "catchup", plus channel/clock_time.
+ *
+ * Steps are rate-limited to one event per CATCHUP_EVENT_MS; start, finish
+ * and hold transitions (@p force) always go out.
+ */
+void SystemManager::publishCatchUp(Channel& ch, bool force) {
+    if (!events || !events->active()) return;
+    const uint32_t nowMs = millis();
+    if (!force && (uint32_t)(nowMs - ch.catchupEventMs) < CATCHUP_EVENT_MS) return;
+    ch.catchupEventMs = nowMs;
+
+    const int idx = (int)(&ch - channels);
+    CatchUpStatus cu;
+    if (!catchUpStatus(idx, cu)) return;
+
+    const int pos = ch.lastImpulseMinutes >= 0 ? ch.lastImpulseMinutes : 0;
+    events->publishf(EventType::CATCHUP,
+                     "{\"channel\":%d,\"name\":\"%s\",\"clock_time\":\"%02d:%02d\",\"active\":%s,\"holding\":%s,"
+                     "\"done\":%d,\"remaining\":%d,\"interval_ms\":%lu,\"eta_ms\":%lu,\"pps\":%.2f}",
+                     idx, cu.name, pos / 60, pos % 60, cu.active ? "true" : "false", cu.holding ? "true" : "false",
+                     cu.done, cu.remaining, (unsigned long)cu.intervalMs, (unsigned long)cu.etaMs, cu.pulsesPerSec);
+}
+
+/**
+ * @brief Append one binary record for @p ch (no-op without an EventLog).
+ */
+void SystemManager::recordEvent(const Channel& ch, EvlType type, int a, int32_t b) {
+    if (!eventLog) return;
+    eventLog->record(type, (uint8_t)(&ch - channels), (uint16_t)a, b);
+}
+
+/**
+ * @brief "ntp": outcome of a sync (or fleet step, source "fleet"), with the
+ *        drift model and next poll interval.
+ */
+void SystemManager::publishNtp(const NtpEvent& ev) {
+    if (!events || !events->active()) return;
+    events->publishf(EventType::NTP,
+                     "{\"ok\":%s,\"boot\":%s,\"source\":\"%s\",\"delta_s\":%lu,\"dst_flip\":%s,"
+                     "\"drift_ppm\":%.2f,\"drift_err_ppm\":%.2f,\"poll_min\":%d}",
+                     ev.ok ? "true" : "false", ev.boot ? "true" : "false", ev.fleet ? "fleet" : "ntp",
+                     (unsigned long)ev.sysDelta,
+                     ev.dstFlip ? "true" : "false", ev.driftPpm, ev.driftErrPpm, ev.pollMinutes);
+}
+
+/**
+ * @brief "plan": the engine's answer to manual-set command @p plan.seq.
+ */
+void SystemManager::publishPlan(int channel, int clockMinutes, const CatchUpPlan& plan) {
+    if (!events || !events->active()) return;
+    events->publishf(EventType::PLAN,
+                     "{\"seq\":%lu,\"channel\":%d,\"status\":\"%s\",\"clock_time\":\"%02d:%02d\",\"pulses\":%d,"
+                     "\"hold_minutes\":%d,\"interval_ms\":%lu,\"eta_ms\":%lu}",
+                     (unsigned long)plan.seq, channel, catchUpPlanStatusName(plan.status),
+                     clockMinutes / 60, clockMinutes % 60, plan.pulses, plan.holdMinutes,
+                     (unsigned long)plan.intervalMs, (unsigned long)plan.etaMs);
+}
+
+/**
+ * @brief Handle manual HH:MM entry (from Web UI); safe from any task.
+ *
+ * Posts one command to the clock engine and waits up to @p waitMs for its
+ * plan (the engine polls every few ms). The position is persisted once, by
+ * the engine, through the write-behind path. A reply left over from an
+ * earlier timed-out command is told apart by its seq and skipped; the
+ * depth-1 reply queue is only ever written by the engine.
+ */
+CatchUpPlan SystemManager::OnManualClockSet(int channel, int clockMinutes, uint32_t waitMs) {
+    CatchUpPlan plan;
+    if (channel < 0 || channel >= channelCount) {
+        plan.status = CatchUpPlanStatus::INVALID;
+        return plan;
     }
 
-    lastImpulseMinutes = clockMinutes % 1440;
-    stateManager->saveClockTime(DateTime(2000,1,1, ch, cm, 0));
+    ClockCommand cmd = { channel, clockMinutes, ++cmdSeq };
+    plan.seq = cmd.seq;
+    if (xQueueSend(cmdQueue, &cmd, 0) != pdTRUE) {
+        logger->error("❌ Manual set dropped (clock engine queue full).");
+        plan.status = CatchUpPlanStatus::DROPPED;
+        return plan;
+    }
+    wakeEngine();
 
-    if (diff == 0) {
-        logger->info("ℹ️ Manual set: already aligned (0 min difference) — no catch-up needed.");
-        return;
+    const TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(waitMs);
+    PlanReply reply;
+    for (;;) {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0) break;
+        if (xQueueReceive(planQueue, &reply, deadline - now) != pdTRUE) break;
+        if (reply.seq == cmd.seq) return reply.plan;
     }
 
-    startCatchUp(diff, "manual");
+    plan.status = CatchUpPlanStatus::QUEUED;
+    return plan;
+}
+
+/**
+ * @brief Apply a manual HH:MM entry on the clock engine.
+ * @return The resulting plan (pulses, spacing, ETA).
+ */
+CatchUpPlan SystemManager::applyManualClockSet(Channel& ch, int clockMinutes) {
+    // System clock in both modes (MANUAL keeps it disciplined from the RTC)
+    DateTime now = TimeSource::localNow();
+    int nowMin = minutesOfDay(now);
+    int diff = diffForwardMinutes(clockMinutes, nowMin);
+
+    int eh = clockMinutes / 60, em = clockMinutes % 60;
+    logger->infof("%s🛠️ Manual set: entered %02d:%02d (min=%d), target NOW %02d:%02d (min=%d), forward diff = %d min",
+                  ch.tag, eh, em, clockMinutes, now.hour(), now.minute(), nowMin, diff);
+
+    // Single persisted commit for the new dial position (supersedes any pending verdict)
+    ch.lastImpulseMinutes = clockMinutes % 1440;
+    ch.verifyPending      = false;
+    ch.missStreak         = 0;
+    ch.state->queueSave(DateTime(2000,1,1, eh, em, 0));
+
+    // Any running session is superseded by the new position.
+    ch.catchupActive = false;
+    return planConvergence(ch, "manual");
 }
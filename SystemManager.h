@@ -7,71 +7,287 @@
 
 #include <Arduino.h>
 #include <RTClib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 #include "ConfigManager.h"
 #include "Logger.h"
 #include "RTCManager.h"
 #include "PulseManager.h"
 #include "StateManager.h"
+#include "CatchUpPlan.h"
+#include "EventManager.h"
+#include "EventLog.h"
 
 /**
  * @class SystemManager
- * @brief Drives the Pragotron minute-clock lifecycle.
+ * @brief Drives the Pragotron minute-clock lifecycle for 1..MAX_CHANNELS lines.
  *
  * Flow:
- *  - Init RTC/TZ (AUTO→with NTP, MANUAL→no NTP) per ConfigManager.
- *  - Read persisted HH:MM (StateManager), compare to RTC, and catch up if needed.
- *  - On every loop: emit minute pulses or progress catch-up (non-blocking).
+ *  - Init RTC/TZ (AUTO→with NTP, MANUAL→no NTP) per ConfigManager. Boot never
+ *    waits for Wi-Fi/NTP: the engine starts from the RTC and the first NTP
+ *    result arrives later like any re-sync (re-planning only on a real change).
+ *  - Per channel: read persisted HH:MM (StateManager), compare to local time,
+ *    and catch up if needed.
+ *  - Minute edges are event-driven: the next boundary is computed once in
+ *    epoch µs and the engine task sleeps until it (idleWaitMs()); catch-up
+ *    steps interleave channels within the max_concurrent_drives power budget.
+ *  - With step feedback (coil current or a position sensor) each pulse is
+ *    verified once it completes: a missed step is rolled back and retried,
+ *    and the catch-up cruise period adapts to what the movement achieves.
  *  - AUTO: periodically re-sync with NTP; handle DST/TZ jumps and drift.
+ *
+ * Threading:
+ *  - loop() is the clock engine (clock task): pulses, minute detection,
+ *    catch-up. It never touches the network and never waits for SD.
+ *  - serviceNetwork() runs on the network/I-O task and drives the async NTP
+ *    sync (or, in MANUAL, the periodic RTC discipline); NTP outcomes reach the
+ *    clock engine through a queue.
+ *  - OnManualClockSet() may be called from any task; it posts a command and
+ *    waits briefly (or not at all) for the engine's CatchUpPlan reply, which
+ *    is also published as a "plan" event (never touches SD).
  */
 class SystemManager {
 public:
+    /**
+     * @param pulses       One PulseManager per channel (channelCount entries).
+     * @param states       One StateManager per channel (channelCount entries).
+     * @param channelCount 1..MAX_CHANNELS; must match config channelCount.
+     */
     SystemManager(
         ConfigManager* config,
         Logger* logger,
         RTCManager* rtc,
-        PulseManager* pulse,
-        StateManager* state
+        PulseManager* const* pulses,
+        StateManager* states,
+        int channelCount
     );
 
     /// Perform initialization as described in the class brief.
     void begin();
 
-    /// Main loop: minute tick, catch-up progression, periodic NTP (AUTO).
+    /// Clock engine step: commands, NTP results, minute tick, catch-up progression.
     void loop();
 
-    /// Callback from Web UI: user set visible clock to HH:MM (minutes since midnight).
-    void OnManualClockSet(int clockMinutes);
+    /// Network-side step: async NTP sync (AUTO) or RTC → system clock discipline (MANUAL).
+    void serviceNetwork();
+
+    /// Station got an IP (any task, e.g. the Wi-Fi event handler): the pending
+    /// boot-time NTP sync is kicked, or a new one started if it already gave up.
+    void onNetworkUp() { networkUpSignal = true; }
+
+    /// True once an NTP sync has succeeded since boot (fleet leader eligibility).
+    bool timeSynced() const { return ntpSynced; }
+
+    /// Fleet follower lock (network task): while set, SNTP and the MANUAL RTC
+    /// discipline stand down and the leader's beacons keep the system clock.
+    void setFleetFollower(bool locked);
+
+    /// Step the system clock by @p offsetUs towards the fleet leader (network
+    /// task). Steps the engine must re-plan for go through the NTP result path.
+    void applyFleetOffset(int64_t offsetUs);
+
+    /// True if any channel needs its loop-timed pulse polled quickly.
+    bool needsFastService() const;
+
+    /// Optional live feed: pulse, catch-up/hold and NTP events for /api/events.
+    void setEventManager(EventManager* em) { events = em; }
+
+    /// Optional binary event log: pulses and catch-up steps are recorded there
+    /// instead of as text lines (the text log keeps start/finish/hold).
+    void setEventLog(EventLog* el) { eventLog = el; }
+
+    /// Register the task running loop(); commands and NTP results notify it.
+    void attachEngineTask(TaskHandle_t task) { engineTask = task; }
+
+    /// How long the engine task may block before loop() has work (ms, ≥ 1).
+    /// Task notifications from OnManualClockSet()/NTP cut the wait short.
+    uint32_t idleWaitMs() const;
+
+    /**
+     * @brief Callback from Web UI: user set visible clock to HH:MM (minutes since midnight).
+     * @param channel      Channel index (0 = main line).
+     * @param clockMinutes Dial position entered by the user (0..1439).
+     * @param waitMs       How long to wait for the clock engine's plan; 0 returns
+     *                     QUEUED at once (the plan then only goes out as a "plan" event).
+     * @return The engine's plan; status QUEUED if it did not answer within waitMs,
+     *         INVALID for an unknown channel. seq identifies the command either way.
+     */
+    CatchUpPlan OnManualClockSet(int channel, int clockMinutes, uint32_t waitMs = 200);
+
+    /// Catch-up progress for one channel; false if @p channel is out of range.
+    /// Fields may be one step apart when read cross-task (diagnostics only).
+    bool catchUpStatus(int channel, CatchUpStatus& out) const;
 
 private:
+    /**
+     * @struct Channel
+     * @brief One slave-clock line: bridge, persisted position, catch-up/hold session.
+     */
+    struct Channel {
+        PulseManager*        pulse   = nullptr;
+        StateManager*        state   = nullptr;
+        const ChannelConfig* cfg     = nullptr;
+        char                 tag[20] = "";           ///< "[name] " log prefix (empty with one channel).
+
+        // We keep time as minutes of day (0..1439) for the physical clock position.
+        int       lastImpulseMinutes = -1;
+
+        // Catch-up state (speed curve from cfg->catchup, periods start-to-start)
+        bool      catchupActive      = false;
+        int       catchupRemaining   = 0;
+        int       catchupTotal       = 0;
+        int       catchupDone        = 0;
+        uint32_t  catchupStartMs     = 0;
+        uint32_t  catchupLastPulseMs = 0;   ///< millis() at the start of the previous step (valid once catchupDone > 0).
+        uint32_t  catchupIntervalMs  = 0;   ///< Period before the next step.
+
+        // Hold state: dial ahead of real time, minute pulses paused until they meet
+        bool      holdActive         = false;
+
+        // Minute-edge accuracy: start of the last minute pulse after :00
+        int32_t   edgeOffsetUs       = -1;
+
+        uint32_t  catchupEventMs     = 0;   ///< millis() of the last "catchup" event.
+
+        // Pulse in flight: position saved (and, with cfg->feedback, verified) once it has finished
+        bool      verifyPending      = false;
+        bool      verifyCatchUp      = false;   ///< That pulse was a catch-up step...
+        bool      verifyAtCruise     = false;   ///< ...fired at the learned cruise period.
+        bool      feedbackFault      = false;   ///< Too many misses in a row: open loop until reboot.
+        bool      polarityVerified   = false;   ///< A verdict since boot has tied the alternation to the dial.
+        int       missStreak         = 0;
+        int       adaptHold          = 0;       ///< Confirmed cruise steps before speeding up again.
+        uint32_t  learnedMinMs       = 0;       ///< Cruise period in use (cfg->catchup.minIntervalMs at boot).
+        uint32_t  missedTotal        = 0;
+    };
+
     ConfigManager* configManager;
     Logger*        logger;
     RTCManager*    rtcManager;
-    PulseManager*  pulseManager;
-    StateManager*  stateManager;
+    EventManager*  events   = nullptr;
+    EventLog*      eventLog = nullptr;
 
-    // We keep time as minutes of day (0..1439) for the physical clock position.
-    int       lastImpulseMinutes = -1;
+    Channel        channels[MAX_CHANNELS];
+    int            channelCount = 0;
+    int            rrNext       = 0;        ///< Round-robin start for catch-up steps.
+
+    // Event-driven minute edge (epoch µs); minuteRetry re-runs the check next loop
+    static constexpr uint32_t ENGINE_IDLE_MAX_MS  = 1000; ///< Safety wake-up when nothing is due.
+    static constexpr uint32_t ENGINE_RETRY_MS     = 20;   ///< Deferred tick (busy bridge, budget, min-gap).
+    static constexpr int64_t  MINUTE_US           = 60LL * 1000000LL;
+    int64_t        nextMinuteUs = 0;
+    int64_t        minuteEdgeUs = 0;        ///< Boundary the pending tick belongs to.
+    bool           minuteRetry  = true;
+    TaskHandle_t   engineTask   = nullptr;
+    void           wakeEngine();
 
     // NTP re-sync timer (AUTO mode)
     uint32_t  lastNtpSyncMs = 0;
 
-    // Catch-up state
-    bool      catchupActive      = false;
-    int       catchupRemaining   = 0;
-    uint32_t  catchupLastPulseMs = 0;
-    uint32_t  catchupIntervalMs  = 0;
+    // Until the first NTP success: the boot session may wait for Wi-Fi, then
+    // retries back off from NTP_RETRY_MIN_MS to NTP_RETRY_MAX_MS.
+    static constexpr uint32_t BOOT_NTP_TIMEOUT_MS = 30UL * 1000UL;
+    static constexpr uint32_t NTP_RETRY_MIN_MS    = 60UL * 1000UL;
+    static constexpr uint32_t NTP_RETRY_MAX_MS    = 60UL * 60UL * 1000UL;
+    bool           ntpSynced       = false;
+    uint32_t       ntpRetryMs      = NTP_RETRY_MIN_MS;
+    volatile bool  networkUpSignal = false;
+
+    // Fleet follower: time from the leader's beacons; RTC cache refreshed hourly
+    static constexpr uint32_t FLEET_RTC_EVERY_MS = 60UL * 60UL * 1000UL;
+    bool           fleetFollower  = false;
+    uint32_t       lastFleetRtcMs = 0;
+
+    // Step feedback: misses in a row before a channel drops to open loop; a
+    // miss backs the cruise period off by a quarter, confirmed steps then
+    // shave ADAPT_SPEEDUP_MS each (after ADAPT_HOLD_STEPS) down to cycle + 20 ms
+    static constexpr int      FEEDBACK_MAX_MISSES = 4;
+    static constexpr uint32_t ADAPT_SPEEDUP_MS    = 2;
+    static constexpr int      ADAPT_HOLD_STEPS    = 16;
+
+    // RTC → system clock discipline timer (MANUAL mode)
+    static constexpr uint32_t RTC_DISCIPLINE_EVERY_MS = 10UL * 60UL * 1000UL;
+    uint32_t  lastRtcDisciplineMs = 0;
+
+    // Cross-task messages (network/web task → clock engine)
+    struct NtpEvent {
+        bool     ok;            ///< false → sync failed / timed out.
+        bool     boot;          ///< true for the initial sync started by begin().
+        bool     fleet;         ///< Step from a fleet beacon (applyFleetOffset()), not SNTP.
+        uint32_t sysDelta;      ///< |system time after − before| in seconds.
+        bool     dstFlip;       ///< tm_isdst changed across the sync.
+        int8_t   isdstBefore;
+        int8_t   isdstAfter;
+        char     zBefore[8];    ///< "%z" before the sync.
+        char     zAfter[8];     ///< "%z" after the sync.
+        float    driftPpm;      ///< RTC rate estimate after the sync.
+        float    driftErrPpm;   ///< Its uncertainty (0 = not learned yet).
+        int      pollMinutes;   ///< Next NTP poll interval.
+    };
+    struct ClockCommand {
+        int      channel;       ///< Target channel index.
+        int      clockMinutes;  ///< Manual set: visible dial position (0..1439).
+        uint32_t seq;           ///< Echoed in the PlanReply.
+    };
+    struct PlanReply {
+        uint32_t    seq;
+        CatchUpPlan plan;
+    };
+    QueueHandle_t ntpQueue  = nullptr;
+    QueueHandle_t cmdQueue  = nullptr;
+    QueueHandle_t planQueue = nullptr;  ///< Depth-1 reply channel for OnManualClockSet().
+    uint32_t      cmdSeq    = 0;
+
+    // Async NTP session (network task)
+    bool      ntpSessionActive = false;
+    bool      ntpSessionBoot   = false;
+    time_t    ntpSysBefore     = 0;     ///< time() when the session started.
+    uint32_t  ntpMsBefore      = 0;     ///< millis() when the session started.
 
     // --- Core logic ---
     void doCatchUpIfNeeded();           ///< Decide on catch-up at boot/init (after initial NTP).
-    void checkMinuteChange();           ///< Regular minute tick (disabled during catch-up).
-    void startCatchUp(int diffMinutes, const char* reason);
-    void tickCatchUp();                 ///< Non-blocking catch-up engine.
+    void setupChannel(Channel& ch);     ///< Load state, configure pulse backend/timing.
+    void serviceMinuteEdge();           ///< Run the minute check once the boundary has passed.
+    bool checkMinuteChange(Channel& ch);///< Minute tick; false if it must be retried (disabled during catch-up/hold).
+    void startCatchUp(Channel& ch, int diffMinutes, const char* reason);
+    void tickCatchUp(Channel& ch);      ///< Non-blocking catch-up engine.
+    void verifyPulse(Channel& ch);      ///< Act on the feedback verdict of a completed pulse.
+    void adaptCatchUpRate(Channel& ch, bool confirmed); ///< AIMD on ch.learnedMinMs.
+    void processCommands();             ///< Apply queued manual-set commands.
+    void processNtpEvents();            ///< React to queued NTP re-sync outcomes.
+    CatchUpPlan applyManualClockSet(Channel& ch, int clockMinutes);
+    void handleNtpResult(const NtpEvent& ev);
+    void startNtpSession(bool boot);    ///< Snapshot + RTCManager::startNtpSync().
+    void pollNtpSession();              ///< Post NtpEvent once the sync resolves.
+    static void fillClockDelta(NtpEvent& ev, time_t sysExpected, time_t sysAfter); ///< TZ/DST + delta fields.
+
+    // --- Live events (no-ops without subscribers) ---
+    static constexpr uint32_t CATCHUP_EVENT_MS = 1000; ///< Step events at most this often per channel.
+    void publishPulse(const Channel& ch, int clockMinutes);
+    void publishCatchUp(Channel& ch, bool force);      ///< force: start/finish/hold changes.
+    void publishNtp(const NtpEvent& ev);
+    void publishPlan(int channel, int clockMinutes, const CatchUpPlan& plan);
+    void recordEvent(const Channel& ch, EvlType type, int a, int32_t b);  ///< Binary event log, if attached.
+
+    // --- Power budget ---
+    bool driveSlotFree() const;         ///< Fewer than max_concurrent_drives coils energized.
 
     // --- NTP/catch-up integration helpers ---
     uint32_t initialNtpSyncDeltaSecIfAuto(); ///< Return seconds changed by initial NTP (0 if MANUAL).
-    void     tryStartCatchUp(const char* reason); ///< Central gate to (re)start catch-up.
+    void     tryStartCatchUp(Channel& ch, const char* reason); ///< Central gate to (re)start catch-up.
+    CatchUpPlan planConvergence(Channel& ch, const char* reason); ///< Pick hold vs forward and start it.
+    static uint32_t forwardConvergeMs(const Channel& ch, int& pulses); ///< Grow @p pulses by minutes passing meanwhile.
+
+    // --- Catch-up speed curve ---
+    static uint32_t catchUpPeriodMs(const Channel& ch, int index, int total); ///< Period before step @p index.
+    static uint32_t catchUpEtaMs(const Channel& ch, int nextIndex, int total); ///< Steps nextIndex..total-1 from now.
 
     // --- Utilities ---
+    /// Width + dead-time of one pulse in ms for a channel (µs resolution).
+    static uint32_t pulseCycleMs(const Channel& ch) {
+        return ((uint32_t)ch.cfg->pulseWidthUs + (uint32_t)ch.cfg->pulseDeadTimeUs) / 1000UL;
+    }
     static int minutesOfDay(const DateTime& dt) {
         return dt.hour() * 60 + dt.minute();
     }
@@ -0,0 +1,109 @@
+/**
+ * @file    TimeSource.cpp
+ * @brief   System-clock time access with a once-per-second formatted cache.
+ *
+ * Notes
+ * -----
+ * - localtime_r() may take newlib locks, so formatting happens outside the
+ *   spinlock; only the 20-byte copy in/out of the cache is guarded.
+ * - The DS1307 is not touched here; it only disciplines the system clock
+ *   (see RTCManager::applyRtcToSystemClock / disciplineSystemClock).
+ */
+
+#include "TimeSource.h"
+#include <sys/time.h>
+
+static portMUX_TYPE cacheLock     = portMUX_INITIALIZER_UNLOCKED;
+static time_t       cacheSec      = (time_t)-1;                 ///< Second the cache was built for.
+static char         cacheText[20] = "0000-00-00 00:00:00";
+
+/**
+ * @brief Current local time from the system clock.
+ */
+DateTime TimeSource::localNow() {
+    time_t t = time(nullptr);
+    tm lt;
+    localtime_r(&t, &lt);
+    return DateTime(lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
+                    lt.tm_hour, lt.tm_min, lt.tm_sec);
+}
+
+/**
+ * @brief Minutes since local midnight from the system clock.
+ */
+int TimeSource::minutesOfDay() {
+    time_t t = time(nullptr);
+    tm lt;
+    localtime_r(&t, &lt);
+    return lt.tm_hour * 60 + lt.tm_min;
+}
+
+/**
+ * @brief Milliseconds into the current minute (TZ offsets are whole minutes).
+ */
+uint32_t TimeSource::msIntoMinute() {
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (uint32_t)(tv.tv_sec % 60) * 1000UL + (uint32_t)(tv.tv_usec / 1000);
+}
+
+/**
+ * @brief Microseconds since the epoch; local minute edges fall on multiples
+ *        of 60 s because TZ offsets are whole minutes.
+ */
+int64_t TimeSource::epochUs() {
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/**
+ * @brief True if the system clock has been set (SNTP or RTC) to a real date.
+ */
+bool TimeSource::isValid() {
+    return time(nullptr) >= MIN_VALID_EPOCH;
+}
+
+/**
+ * @brief Return the cached timestamp, rebuilding it when the second changed.
+ */
+void TimeSource::cachedStamp(char out[20]) {
+    const time_t t = time(nullptr);
+
+    portENTER_CRITICAL(&cacheLock);
+    const bool fresh = (t == cacheSec);
+    if (fresh) memcpy(out, cacheText, 20);
+    portEXIT_CRITICAL(&cacheLock);
+    if (fresh) return;
+
+    if (t < MIN_VALID_EPOCH) {
+        strcpy(out, "0000-00-00 00:00:00");
+    } else {
+        tm lt;
+        localtime_r(&t, &lt);
+        strftime(out, 20, "%Y-%m-%d %H:%M:%S", &lt);
+    }
+
+    portENTER_CRITICAL(&cacheLock);
+    memcpy(cacheText, out, 20);
+    cacheSec = t;
+    portEXIT_CRITICAL(&cacheLock);
+}
+
+void TimeSource::timestamp(char out[20]) {
+    cachedStamp(out);
+}
+
+void TimeSource::date(char out[11]) {
+    char ts[20];
+    cachedStamp(ts);
+    memcpy(out, ts, 10);
+    out[10] = '\0';
+}
+
+void TimeSource::hhmm(char out[6]) {
+    char ts[20];
+    cachedStamp(ts);
+    memcpy(out, ts + 11, 5);
+    out[5] = '\0';
+}
@@ -0,0 +1,60 @@
+/**
+ * @file    TimeSource.h
+ * @brief   Cheap local-time access from the ESP32 system clock (no I2C).
+ *
+ * Usage:
+ *   DateTime now = TimeSource::localNow();   // time() + localtime_r
+ *   char ts[20]; TimeSource::timestamp(ts);   // "YYYY-MM-DD HH:MM:SS"
+ *   char d[11];  TimeSource::date(d);         // "YYYY-MM-DD"
+ *   char hm[6];  TimeSource::hhmm(hm);        // "HH:MM"
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include <time.h>
+
+/**
+ * @class TimeSource
+ * @brief Single read path for "what time is it" across the firmware.
+ *
+ * The system clock is the source of truth at runtime: SNTP sets it in AUTO,
+ * RTCManager applies the DS1307 to it in MANUAL/offline and re-disciplines
+ * it periodically. Reading it costs no bus traffic, and the formatted
+ * timestamp is cached so repeated callers within the same second share one
+ * localtime_r/snprintf.
+ *
+ * All methods are static and safe from any task.
+ */
+class TimeSource {
+public:
+    /// Current local time as DateTime (system clock).
+    static DateTime localNow();
+
+    /// Minutes since local midnight (0..1439).
+    static int minutesOfDay();
+
+    /// Milliseconds elapsed in the current local minute (0..59999).
+    static uint32_t msIntoMinute();
+
+    /// System clock as µs since the Unix epoch (gettimeofday, no localtime_r).
+    static int64_t epochUs();
+
+    /// True once the system clock holds a plausible date (≥ 2020).
+    static bool isValid();
+
+    /// "YYYY-MM-DD HH:MM:SS" or "0000-00-00 00:00:00" if the clock is unset.
+    static void timestamp(char out[20]);
+
+    /// "YYYY-MM-DD" or "0000-00-00" if the clock is unset.
+    static void date(char out[11]);
+
+    /// "HH:MM" or "00:00" if the clock is unset.
+    static void hhmm(char out[6]);
+
+private:
+    static constexpr time_t MIN_VALID_EPOCH = 1577836800; ///< 2020-01-01T00:00:00Z
+
+    static void cachedStamp(char out[20]);  ///< Copy of the per-second cache.
+};
@@ -6,85 +6,487 @@
  * Endpoints
  * ---------
  *   GET  /                 → serves /index.html from SD
- *   GET  /<asset>          → serves files from SD with basic content-type mapping
- *   GET  /api/status       → JSON with device/Wi-Fi/mode and HH:MM times (RTC & clock state)
- *   POST /api/set-state    → { "clock_time": "HH:MM" } → updates state.txt and triggers callback
- *   GET  /api/log          → streams today's log or newest log from /logs
- *   GET  /api/logs         → JSON array of available log files in /logs
- *   GET  /api/logfile?file=YYYY-MM-DD.txt → streams a specific log (name sanitized)
+ *   GET  /<asset>          → serves static files (RAM cache, else SD; "<asset>.gz" preferred)
+ *   GET  /api/status       → JSON with device/Wi-Fi/mode and HH:MM times (local time & clock state)
+ *   POST /api/set-state    → { "clock_time": "HH:MM" } → one command to the clock engine, JSON plan back
+ *   GET  /api/log          → streams today's log or newest log from /logs (Range, ?tail=N, ?since=offset)
+ *   GET  /api/logs         → JSON array of daily logs, newest first (?offset=&limit=, from the RAM index)
+ *   GET  /api/logfile?file=YYYY-MM-DD.txt → streams a specific log (name sanitized; same options)
+ *   GET  /api/eventlog     → decoded binary event log of one day (?date=, type=, channel=, format=json|text)
+ *   GET  /api/metrics      → counters + latency histograms (Prometheus text; ?format=json for JSON)
+ *   GET  /api/fleet        → fleet role/leader; on the leader, every node's dials and offset
+ *   GET  /api/events       → Server-Sent Events: log, pulse, catchup, ntp (needs setEventManager();
+ *                            sync backend: 307 to the stream socket on port 81)
  *
  * Notes
  * -----
  * - SD must be initialized by the application before begin().
- * - Content-Type is inferred by file extension via contentTypeFor().
+ * - Backend: the synchronous WebServer (default, polled by handleClient()) or,
+ *   with WEB_ASYNC=1, ESPAsyncWebServer: requests are served from the AsyncTCP
+ *   task, up to web_max_clients at once (503 beyond), and files go out as
+ *   chunked responses read as the socket drains. Handlers only see
+ *   HttpExchange, so both backends share the routes below.
+ * - Content-Type is inferred by file extension via contentTypeFor() (table lookup).
+ * - Static files: small ones are cached in RAM (PSRAM if present) at begin(),
+ *   pre-gzipped "<file>.gz" siblings are preferred when the client accepts
+ *   gzip, and every response carries ETag + Cache-Control so revalidation is
+ *   a 304 without touching SD. The synchronous WebServer closes the
+ *   connection after each response, so browser caching is what saves the
+ *   round trips there; the async backend keeps connections alive.
  * - /api/set-state requires config.webEditEnabled = true.
  * - Time strings use local time (CET/CEST or configured TZ).
  */
 
 #include "WebServerManager.h"
+#include "TimeSource.h"
+#include "FleetManager.h"
 #include <WiFi.h>
 #include <FS.h>
 #include <SD.h>
 #include <ArduinoJson.h>
+#include <esp_rom_crc.h>
+#include <lwip/sockets.h>
+#include <memory>
 
 WebServerManager::WebServerManager(StateManager* state, ConfigManager* config, RTCManager* rtc)
     : server(80), stateManager(state), configManager(config), rtcManager(rtc) {}
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Routing (one table, bound to whichever backend is built)
+// ──────────────────────────────────────────────────────────────────────────────
+
+const WebServerManager::Route WebServerManager::ROUTES[] = {
+    { "/",              false, &WebServerManager::handleRoot },
+    { "/api/status",    false, &WebServerManager::handleApiStatus },
+    { "/api/set-state", true,  &WebServerManager::handleApiSetState },
+    { "/api/log",       false, &WebServerManager::handleApiLog },
+    { "/api/logs",      false, &WebServerManager::handleApiLogsList },
+    { "/api/logfile",   false, &WebServerManager::handleApiLogsFile },
+    { "/api/eventlog",  false, &WebServerManager::handleApiEventLog },
+    { "/api/metrics",   false, &WebServerManager::handleApiMetrics },
+    { "/api/fleet",     false, &WebServerManager::handleApiFleet },
+};
+
 /**
  * @brief Start the HTTP server and register all routes.
  * @param port Unused (fixed at 80 by constructor); kept for signature compatibility.
  */
 void WebServerManager::begin(uint16_t /*port*/) {
-    server.on("/", HTTP_GET, std::bind(&WebServerManager::handleRoot, this));
-    server.onNotFound(std::bind(&WebServerManager::handleFileRequest, this));
+    loadAssetCache((size_t)configManager->getConfig().webCacheKb * 1024);
+
+#if WEB_ASYNC
+    for (const Route& r : ROUTES) {
+        const Handler fn = r.fn;
+        server.on(r.path, r.post ? HTTP_POST : HTTP_GET,
+                  [this, fn](AsyncWebServerRequest* req) { dispatch(req, fn); },
+                  nullptr,
+                  [](AsyncWebServerRequest* req, uint8_t* data, size_t len, size_t index, size_t total) {
+                      AsyncHttpExchange::collectBody(req, data, len, index, total, MAX_BODY_BYTES);
+                  });
+    }
+    server.onNotFound([this](AsyncWebServerRequest* req) { dispatch(req, &WebServerManager::handleFileRequest); });
 
-    server.on("/api/status",    HTTP_GET,  std::bind(&WebServerManager::handleApiStatus, this));
-    server.on("/api/set-state", HTTP_POST, std::bind(&WebServerManager::handleApiSetState, this));
-    server.on("/api/log",       HTTP_GET,  std::bind(&WebServerManager::handleApiLog, this));
-    // New:
-    server.on("/api/logs",      HTTP_GET,  std::bind(&WebServerManager::handleApiLogsList, this));
-    server.on("/api/logfile",   HTTP_GET,  std::bind(&WebServerManager::handleApiLogsFile, this));
+    if (events) {
+        sse.onConnect([this](AsyncEventSourceClient* c) {
+            if (sse.count() > SSE_MAX_CLIENTS) { c->close(); return; }
+            c->send("", nullptr, 0, 3000);   // retry hint only
+            events->setActive(true);
+        });
+        server.addHandler(&sse);
+    }
+#else
+    static const char* headerKeys[] = { "If-None-Match", "Accept-Encoding", "Range" };
+    server.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
+
+    for (const Route& r : ROUTES) {
+        const Handler fn = r.fn;
+        server.on(r.path, r.post ? HTTP_POST : HTTP_GET,
+                  [this, fn]() { SyncHttpExchange ex(server); timed(ex, fn); });
+    }
+    server.onNotFound([this]() { SyncHttpExchange ex(server); timed(ex, &WebServerManager::handleFileRequest); });
+
+    if (events) {
+        server.on("/api/events", HTTP_GET, [this]() { handleApiEvents(); });
+        sseServer.begin();
+        sseServer.setNoDelay(true);
+    }
+#endif
 
     server.begin();
-    Serial.println("🌐 Web server started.");
+    Serial.printf("🌐 Web server started (%s).\n", WEB_ASYNC ? "async" : "sync");
 }
 
 /**
- * @brief Pump HTTP requests; call from main loop.
+ * @brief Pump HTTP requests (sync backend) and push queued events; call from the network task.
  */
 void WebServerManager::handleClient() {
+#if !WEB_ASYNC
     server.handleClient();
+#endif
+    pumpEvents();
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Server-Sent Events (/api/events)
+// ──────────────────────────────────────────────────────────────────────────────
+
+#if WEB_ASYNC
+/**
+ * @brief Forward queued events to AsyncEventSource (it buffers per client).
+ */
+void WebServerManager::pumpEvents() {
+    if (!events) return;
+    events->setActive(sse.count() > 0);
+
+    StreamEvent ev;
+    for (int i = 0; i < SSE_EVENTS_PER_RUN && events->next(ev); i++) {
+        sse.send(ev.data, EventManager::typeName(ev.type), ev.id);
+    }
+}
+#else
+/**
+ * @brief Send the browser to the stream port.
+ *
+ * WebServer handles one connection at a time and, after a handler returns
+ * with the socket still open, waits up to 2 s for the peer to close it —
+ * a stream kept on port 80 would stall every other request. EventSource
+ * follows the 307 to SSE_PORT, where acceptEventClients() serves it.
+ */
+void WebServerManager::handleApiEvents() {
+    String host = server.hostHeader();
+    const int colon = host.lastIndexOf(':');
+    if (colon > host.lastIndexOf(']')) host.remove(colon);   // drop the port, keep IPv6 brackets
+    if (host.length() == 0) host = WiFi.localIP().toString();
+
+    server.sendHeader("Location", "http://" + host + ":" + String(SSE_PORT) + "/api/events");
+    server.sendHeader("Cache-Control", "no-store");
+    server.send(307, "text/plain", "");
+}
+
+/**
+ * @brief Take new sockets on SSE_PORT and answer their GET /api/events.
+ *
+ * Only the request line is checked; the rest of the request is discarded.
+ * The stream is another origin than the page (port), hence the CORS header.
+ */
+void WebServerManager::acceptEventClients() {
+    WiFiClient nc = sseServer.available();
+    if (nc) {
+        SseClient* slot = nullptr;
+        for (SseClient& s : sseClients) {
+            if (!s.client.connected()) { slot = &s; break; }
+        }
+        if (!slot) {
+            nc.print("HTTP/1.1 503 Service Unavailable\r\n"
+                     "Access-Control-Allow-Origin: *\r\n"
+                     "Content-Length: 0\r\n"
+                     "Connection: close\r\n\r\n");
+            nc.stop();
+        } else {
+            slot->client.stop();
+            slot->client     = nc;
+            slot->streaming  = false;
+            slot->acceptedMs = millis();
+        }
+    }
+
+    for (SseClient& s : sseClients) {
+        if (s.streaming || !s.client.connected()) continue;
+        if (s.client.available() <= 0) {
+            if ((uint32_t)(millis() - s.acceptedMs) >= SSE_REQUEST_MS) s.client.stop();
+            continue;
+        }
+        char line[24] = "";
+        const int n = s.client.read((uint8_t*)line, sizeof(line) - 1);
+        line[n > 0 ? n : 0] = '\0';
+        while (s.client.available() > 0) {
+            uint8_t rest[64];
+            s.client.read(rest, sizeof(rest));
+        }
+        if (strncmp(line, "GET /api/events", 15) != 0) {
+            s.client.print("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            s.client.stop();
+            continue;
+        }
+        s.client.setNoDelay(true);
+        s.client.print("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/event-stream\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Connection: keep-alive\r\n\r\n"
+                       "retry: 3000\n\n");
+        s.streaming = true;
+        events->setActive(true);
+    }
+}
+
+/**
+ * @brief Write queued events to every connected client as SSE frames.
+ *
+ * A client whose socket cannot take a frame at once is dropped (it
+ * reconnects by itself after the retry delay), so one stalled browser
+ * neither backs up the queue nor blocks the network task.
+ */
+void WebServerManager::pumpEvents() {
+    if (!events) return;
+    acceptEventClients();
+
+    int live = 0;
+    for (SseClient& s : sseClients) {
+        if (s.client.connected()) live += s.streaming;
+        else if (s.client) s.client.stop();
+    }
+    events->setActive(live > 0);
+    if (live == 0) return;
+
+    char frame[StreamEvent::DATA_MAX + 48];
+    StreamEvent ev;
+    int sent = 0;
+    while (sent < SSE_EVENTS_PER_RUN && events->next(ev)) {
+        int len = snprintf(frame, sizeof(frame), "id: %lu\nevent: %s\ndata: %s\n\n",
+                           (unsigned long)ev.id, EventManager::typeName(ev.type), ev.data);
+        sseBroadcast(frame, min<size_t>((size_t)len, sizeof(frame) - 1));
+        sent++;
+    }
+    if (sent == 0 && (uint32_t)(millis() - sseLastPingMs) >= SSE_PING_MS) {
+        sseBroadcast(": ping\n\n", 8);
+    }
+}
+
+/**
+ * @brief Send one frame to every streaming client without ever waiting.
+ *
+ * WiFiClient::write() retries a full socket for up to ~10 s, so the frame
+ * goes straight to the socket with MSG_DONTWAIT: a client whose send buffer
+ * cannot take the whole frame now is dropped instead (a partial frame would
+ * break the stream anyway).
+ */
+void WebServerManager::sseBroadcast(const char* frame, size_t len) {
+    sseLastPingMs = millis();
+    for (SseClient& s : sseClients) {
+        if (!s.streaming || !s.client.connected()) continue;
+        const int fd = s.client.fd();
+        if (fd < 0 || send(fd, frame, len, MSG_DONTWAIT) != (ssize_t)len) s.client.stop();
+    }
 }
+#endif
 
+#if WEB_ASYNC
 /**
- * @brief Serve /index.html from SD.
+ * @brief Admit a request within web_max_clients and run its handler.
+ *
+ * The in-flight count drops when the request object is destroyed (response
+ * fully sent or client gone), so a slow log download holds its slot until
+ * it finishes. Over the limit → 503 with Retry-After, no SD access.
  */
-void WebServerManager::handleRoot() {
-    File file = SD.open("/index.html");
-    if (!file) {
-        server.send(500, "text/plain", "index.html not found");
+void WebServerManager::dispatch(AsyncWebServerRequest* req, Handler fn) {
+    const int limit = configManager->getConfig().webMaxClients;
+    if (inFlight.fetch_add(1) >= limit) {
+        inFlight.fetch_sub(1);
+        Metrics::count(Metric::HTTP_REJECTED);
+        AsyncWebServerResponse* r = req->beginResponse(503, "text/plain", "Busy, try again");
+        r->addHeader("Retry-After", "1");
+        req->send(r);
         return;
     }
-    server.streamFile(file, "text/html");
-    file.close();
+    req->onDisconnect([this]() { inFlight.fetch_sub(1); });
+
+    const size_t len = req->contentLength();
+    if (len > MAX_BODY_BYTES) {
+        req->send(413, "text/plain", "Body too large");
+        return;
+    }
+
+    AsyncHttpExchange ex(req);
+    timed(ex, fn);
+}
+#endif
+
+/**
+ * @brief Run a route handler and record its duration (async: until the response is queued).
+ */
+void WebServerManager::timed(HttpExchange& ex, Handler fn) {
+    const uint32_t t0 = micros();
+    (this->*fn)(ex);
+    Metrics::count(Metric::HTTP_REQUESTS);
+    Metrics::observe(Latency::HTTP_US, micros() - t0);
+}
+
+/**
+ * @brief Serve /index.html (cache or SD).
+ */
+void WebServerManager::handleRoot(HttpExchange& ex) {
+    if (!serveStatic(ex, "/index.html")) {
+        ex.send(500, "text/plain", "index.html not found");
+    }
 }
 
 /**
- * @brief Serve static files from SD, or 404 if not present.
+ * @brief Serve static files (cache or SD), or 404 if not present.
  */
-void WebServerManager::handleFileRequest() {
-    String path = server.uri();
+void WebServerManager::handleFileRequest(HttpExchange& ex) {
+    String path = ex.uri();
     if (path == "/") path = "/index.html";
 
-    File file = SD.open(path);
-    if (!file) {
-        handleNotFound();
-        return;
+    if (!serveStatic(ex, path)) handleNotFound(ex);
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Static assets: RAM cache, gzip, ETag
+// ──────────────────────────────────────────────────────────────────────────────
+
+namespace {
+struct MimeEntry { const char* ext; const char* type; };
+const MimeEntry MIME_TYPES[] = {
+    { ".html", "text/html" },
+    { ".css",  "text/css" },
+    { ".js",   "application/javascript" },
+    { ".json", "application/json" },
+    { ".txt",  "text/plain" },
+    { ".ico",  "image/x-icon" },
+    { ".png",  "image/png" },
+    { ".svg",  "image/svg+xml" },
+};
+}
+
+/**
+ * @brief MIME type from the extension table; "<file>.gz" maps like "<file>".
+ */
+const char* WebServerManager::contentTypeFor(const String& path) {
+    String p = path.endsWith(".gz") ? path.substring(0, path.length() - 3) : path;
+    for (const MimeEntry& m : MIME_TYPES) {
+        if (p.endsWith(m.ext)) return m.type;
+    }
+    return "text/plain";
+}
+
+/**
+ * @brief True for UI asset types worth caching (not .txt/.json data files).
+ */
+bool WebServerManager::isStaticAsset(const String& path) {
+    String p = path.endsWith(".gz") ? path.substring(0, path.length() - 3) : path;
+    return p.endsWith(".html") || p.endsWith(".css") || p.endsWith(".js") ||
+           p.endsWith(".ico")  || p.endsWith(".png") || p.endsWith(".svg");
+}
+
+/**
+ * @brief Load small static files from the SD root into RAM, within @p budgetBytes.
+ *
+ * A "<file>.gz" sibling is cached instead of the plain file. Clients that do
+ * not accept gzip then fall back to streaming the plain file from SD.
+ */
+void WebServerManager::loadAssetCache(size_t budgetBytes) {
+    if (budgetBytes == 0) return;
+
+    File root = SD.open("/");
+    if (!root || !root.isDirectory()) return;
+
+    size_t budget = budgetBytes;
+    for (File f = root.openNextFile(); f && assetCount < ASSET_CACHE_SLOTS; f = root.openNextFile()) {
+        String path = String(f.path());
+        const bool dir = f.isDirectory();
+        f.close();
+        if (dir || !isStaticAsset(path)) continue;
+
+        if (path.endsWith(".gz")) path = path.substring(0, path.length() - 3);
+        if (findAsset(path)) continue;   // plain + .gz pair: first one seen loads the pair
+        cacheAsset(path, budget);
+    }
+    root.close();
+
+    Serial.printf("🗂️ Web cache: %u files, %u bytes (%s)\n",
+                  (unsigned)assetCount, (unsigned)(budgetBytes - budget),
+                  psramFound() ? "PSRAM" : "heap");
+}
+
+/**
+ * @brief Read one asset (its .gz variant if present) into a cache slot.
+ */
+bool WebServerManager::cacheAsset(const String& path, size_t& budget) {
+    const String gzPath = path + ".gz";
+    const bool   gz     = SD.exists(gzPath);
+
+    File f = SD.open(gz ? gzPath : path, FILE_READ);
+    if (!f) return false;
+    const size_t len = f.size();
+    if (len == 0 || len > ASSET_MAX_BYTES || len > budget) { f.close(); return false; }
+
+    uint8_t* buf = (uint8_t*)(psramFound() ? ps_malloc(len) : malloc(len));
+    if (!buf) { f.close(); return false; }
+    const size_t got = f.read(buf, len);
+    f.close();
+    if (got != len) { free(buf); return false; }
+
+    CachedAsset& a = assets[assetCount++];
+    a.path = path;
+    a.data = buf;
+    a.len  = len;
+    a.gzip = gz;
+    snprintf(a.etag, sizeof(a.etag), "\"%08lx\"", (unsigned long)esp_rom_crc32_le(0, buf, len));
+    budget -= len;
+    return true;
+}
+
+const WebServerManager::CachedAsset* WebServerManager::findAsset(const String& path) const {
+    for (size_t i = 0; i < assetCount; i++) {
+        if (assets[i].path == path) return &assets[i];
+    }
+    return nullptr;
+}
+
+bool WebServerManager::clientAcceptsGzip(HttpExchange& ex) {
+    return ex.header("Accept-Encoding").indexOf("gzip") >= 0;
+}
+
+/**
+ * @brief Answer 304 if the client's If-None-Match equals @p etag.
+ */
+bool WebServerManager::notModified(HttpExchange& ex, const char* etag) {
+    if (ex.header("If-None-Match") != etag) return false;
+    sendCacheHeaders(ex, etag);
+    ex.sendEmpty(304);
+    return true;
+}
+
+void WebServerManager::sendCacheHeaders(HttpExchange& ex, const char* etag) {
+    char cc[32];
+    snprintf(cc, sizeof(cc), "max-age=%d", configManager->getConfig().staticMaxAgeSec);
+    ex.sendHeader("Cache-Control", cc);
+    ex.sendHeader("ETag", etag);
+}
+
+/**
+ * @brief Serve @p path from the RAM cache or SD with ETag/Cache-Control.
+ * @return false if the file does not exist.
+ *
+ * SD ETags are derived from size + modification time, so a 304 needs no read.
+ */
+bool WebServerManager::serveStatic(HttpExchange& ex, const String& path) {
+    const bool gzOk = clientAcceptsGzip(ex);
+
+    const CachedAsset* a = findAsset(path);
+    if (a && (gzOk || !a->gzip)) {
+        if (notModified(ex, a->etag)) return true;
+        sendCacheHeaders(ex, a->etag);
+        if (a->gzip) ex.sendHeader("Content-Encoding", "gzip");
+        ex.send(200, contentTypeFor(path), a->data, a->len);
+        return true;
     }
 
-    String contentType = contentTypeFor(path);
-    server.streamFile(file, contentType);
-    file.close();
+    const String gzPath = path + ".gz";
+    File file;
+    if (gzOk && SD.exists(gzPath)) file = SD.open(gzPath, FILE_READ);
+    if (!file) file = SD.open(path, FILE_READ);
+    if (!file || file.isDirectory()) return false;
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%x-%lx\"", (unsigned)file.size(), (unsigned long)file.getLastWrite());
+    if (notModified(ex, etag)) { file.close(); return true; }
+
+    sendCacheHeaders(ex, etag);
+    // streamFile() adds Content-Encoding: gzip for a *.gz file name
+    ex.streamFile(file, contentTypeFor(path));
+    return true;
 }
 
 /**
@@ -97,30 +499,109 @@ void WebServerManager::handleFileRequest() {
  *   "mode": "auto",
  *   "web_edit": false,
  *   "rtc_time": "14:03",
- *   "clock_time": "14:02"
+ *   "clock_time": "14:02",
+ *   "heap_free": 181234,
+ *   "heap_min_free": 176512,
+ *   "catchup": { "active": true, "done": 40, "remaining": 80,
+ *                "interval_ms": 700, "eta_ms": 56650, "pps": 1.38 },
+ *   "edge_offset_ms": 0.8,
+ *   "power": { "mode": "low", "light_sleep": true, "wakes_clock": 3712, "wakes_net": 180034,
+ *              "wakes_per_min": 3061.2, "awake_pct": 1.8, "avg_ma_est": 5.4 },
+ *   "channels": [ { "name": "main", "clock_time": "14:02", "edge_offset_ms": 0.8, "catchup": { ... } } ]
  * }
+ *
+ * heap_min_free is the lowest free heap seen since boot (fragmentation/leak
+ * watermark). Top-level clock_time/catchup describe channel 0; "channels"
+ * lists every configured line. edge_offset_ms is how late the last minute
+ * pulse started after :00 (absent until the first regular tick). With step
+ * feedback configured, "catchup" also carries "feedback" (mode, or "fault"
+ * once the channel fell back to open loop), "missed" (steps retried) and
+ * "min_interval_ms" (the learned cruise period).
  */
-void WebServerManager::handleApiStatus() {
-    StaticJsonDocument<512> doc;
+void WebServerManager::handleApiStatus(HttpExchange& ex) {
+    StaticJsonDocument<2048> doc;
 
-    // RTC time from RTCManager
-    DateTime now = rtcManager ? rtcManager->now() : DateTime(2000,1,1,0,0,0);
+    // Current local time from the system clock (no DS1307 read per request)
+    char nowHm[6];
+    TimeSource::hhmm(nowHm);
 
-    // Clock time from state.txt (HH:MM)
-    DateTime clockDt = stateManager->loadLastKnownClockTime();
+    // Clock position from the StateManager RAM copy (no SD access)
+    DateTime clockDt = stateManager->currentClockTime();
 
     doc["device_ip"]  = WiFi.localIP().toString();
     doc["wifi_ssid"]  = WiFi.SSID();
-    doc["mode"]       = configManager->getConfig().mode;
+    doc["mode"]       = ConfigManager::modeName(configManager->getConfig().mode);
     doc["web_edit"]   = configManager->getConfig().webEditEnabled;
 
     // Send only HH:MM
-    doc["rtc_time"]   = hhmmFromDateTime(now);
+    doc["rtc_time"]   = nowHm;
     doc["clock_time"] = hhmmFromDateTime(clockDt);
 
+    // Heap health
+    doc["heap_free"]     = ESP.getFreeHeap();
+    doc["heap_min_free"] = ESP.getMinFreeHeap();
+
+    // Power mode, wake-ups and estimated current
+    if (powerManager) {
+        PowerStatus ps = powerManager->status();
+        JsonObject p = doc.createNestedObject("power");
+        p["mode"]          = ps.lowPower ? "low" : "normal";
+        p["light_sleep"]   = ps.lightSleep;
+        p["wakes_clock"]   = ps.wakes[(int)PowerTask::CLOCK];
+        p["wakes_net"]     = ps.wakes[(int)PowerTask::NET];
+        p["wakes_per_min"] = roundf(ps.wakesPerMin * 10.0f) / 10.0f;
+        p["awake_pct"]     = roundf(ps.awakePct * 100.0f) / 100.0f;
+        p["avg_ma_est"]    = roundf(ps.avgMa * 10.0f) / 10.0f;
+    }
+
+    // Catch-up progress, per channel
+    if (catchUpStatusProvider) {
+        JsonArray chans = doc.createNestedArray("channels");
+        CatchUpStatus cu;
+        for (int i = 0; catchUpStatusProvider(i, cu); i++) {
+            if (i == 0) {
+                fillCatchUp(doc.createNestedObject("catchup"), cu);
+                if (cu.edgeOffsetUs >= 0) doc["edge_offset_ms"] = roundf(cu.edgeOffsetUs / 100.0f) / 10.0f;
+            }
+
+            JsonObject o = chans.createNestedObject();
+            o["name"] = cu.name;
+            if (cu.clockMinutes >= 0) {
+                char hm[6];
+                snprintf(hm, sizeof(hm), "%02u:%02u", (unsigned)cu.clockMinutes / 60 % 24, (unsigned)cu.clockMinutes % 60);
+                o["clock_time"] = hm;
+            }
+            if (cu.edgeOffsetUs >= 0) o["edge_offset_ms"] = roundf(cu.edgeOffsetUs / 100.0f) / 10.0f;
+            fillCatchUp(o.createNestedObject("catchup"), cu);
+        }
+    }
+
     String output;
     serializeJson(doc, output);
-    server.send(200, "application/json", output);
+    ex.send(200, "application/json", output);
+}
+
+/**
+ * @brief Serialize one channel's catch-up progress into @p c.
+ */
+void WebServerManager::fillCatchUp(JsonObject c, const CatchUpStatus& cu) {
+    c["active"] = cu.active;
+    if (cu.holding) {
+        c["holding"] = true;
+        c["eta_ms"]  = cu.etaMs;
+    }
+    if (cu.active) {
+        c["done"]        = cu.done;
+        c["remaining"]   = cu.remaining;
+        c["interval_ms"] = cu.intervalMs;
+        c["eta_ms"]      = cu.etaMs;
+        c["pps"]         = roundf(cu.pulsesPerSec * 100.0f) / 100.0f;
+    }
+    if (strcmp(cu.feedback, "off") != 0) {
+        c["feedback"]        = cu.feedback;
+        c["missed"]          = cu.missed;
+        c["min_interval_ms"] = cu.minIntervalMs;
+    }
 }
 
 /**
@@ -128,31 +609,47 @@ void WebServerManager::handleApiStatus() {
  *
  * Security:
  * - Allowed only when `webEditEnabled == true`.
- * - Expects a JSON body: { "clock_time": "HH:MM" }.
+ * - Expects a JSON body: { "clock_time": "HH:MM", "channel": 0 } (channel optional, default 0).
  * - Sanitizes and validates input range (00:00..23:59).
- * - Writes to /state.txt and triggers onClockSet(minutes) if registered.
+ * - Hands the position to onClockSet(minutes), which persists it once and
+ *   answers with the planned catch-up; no SD access on this thread.
+ *
+ * Response (200):
+ * {
+ *   "status": "planned" | "hold" | "rejected" | "queued",
+ *   "seq": 12,
+ *   "clock_time": "14:02",
+ *   "pulses": 17,
+ *   "interval_ms": 400,
+ *   "eta_ms": 6750,
+ *   "message": "Catch-up: 17 pulses, ~7 s"
+ * }
+ * 400 for an unknown channel, 503 if the clock engine queue is full.
+ * On the async backend the answer is always "queued" (the AsyncTCP task must
+ * not wait for the engine); the plan follows as a "plan" event with this seq.
  */
-void WebServerManager::handleApiSetState() {
+void WebServerManager::handleApiSetState(HttpExchange& ex) {
     if (!configManager->getConfig().webEditEnabled) {
-        server.send(403, "text/plain", "Not allowed");
+        ex.send(403, "text/plain", "Not allowed");
         return;
     }
 
-    if (!server.hasArg("plain")) {
-        server.send(400, "text/plain", "No data");
+    const String body = ex.body();
+    if (body.isEmpty()) {
+        ex.send(400, "text/plain", "No data");
         return;
     }
 
     StaticJsonDocument<128> doc;
-    DeserializationError err = deserializeJson(doc, server.arg("plain"));
+    DeserializationError err = deserializeJson(doc, body);
     if (err) {
-        server.send(400, "text/plain", "Invalid JSON");
+        ex.send(400, "text/plain", "Invalid JSON");
         return;
     }
 
     const char* hhmmC = doc["clock_time"];
     if (!hhmmC) {
-        server.send(400, "text/plain", "Missing 'clock_time'");
+        ex.send(400, "text/plain", "Missing 'clock_time'");
         return;
     }
 
@@ -161,147 +658,283 @@ void WebServerManager::handleApiSetState() {
 
     int h=-1, m=-1;
     if (sscanf(hhmm.c_str(), "%d:%d", &h, &m) != 2 || h < 0 || h > 23 || m < 0 || m > 59) {
-        server.send(400, "text/plain", "Bad time format. Use HH:MM");
+        ex.send(400, "text/plain", "Bad time format. Use HH:MM");
         return;
     }
 
     int minutes = h * 60 + m;
+    int channel = doc["channel"] | 0;
 
-    // ✅ Persist to state
-    // For a minute-based API you could add: stateManager->saveClockMinutes(minutes);
-    // Backwards-compatible with DateTime (fake date):
-    DateTime dt(2000, 1, 1, h, m, 0);
-    stateManager->saveClockTime(dt);
-
-    // Optionally rewrite /state.txt explicitly (compat with other writers)
-    File f = SD.open("/state.txt", FILE_WRITE);
-    if (f) {
-        char buf[6];
-        snprintf(buf, sizeof(buf), "%02d:%02d", h, m);
-        f.seek(0);
-        f.print(buf);
-        f.flush();
-        f.close();
+    // 🟢 One command to the clock engine; it persists and plans the catch-up
+    CatchUpPlan plan;
+    if (onClockSet) {
+        plan = onClockSet(channel, minutes);
+    } else if (channel != 0) {
+        plan.status = CatchUpPlanStatus::INVALID;
     } else {
-        Serial.println("⚠️ Could not open /state.txt for write.");
+        stateManager->queueSave(DateTime(2000, 1, 1, h, m, 0));
+        plan.status = CatchUpPlanStatus::QUEUED;
     }
 
-    // 🟢 Notify the system logic so it can reconcile and adjust the clock
-    if (onClockSet) {
-        onClockSet(minutes);
+    if (plan.status == CatchUpPlanStatus::INVALID) {
+        ex.send(400, "text/plain", "Unknown channel");
+        return;
+    }
+    if (plan.status == CatchUpPlanStatus::DROPPED) {
+        ex.send(503, "text/plain", "Clock engine busy, try again");
+        return;
+    }
+
+    char msg[64];
+    switch (plan.status) {
+        case CatchUpPlanStatus::PLANNED:
+            if (plan.pulses == 0) snprintf(msg, sizeof(msg), "State updated, already aligned");
+            else snprintf(msg, sizeof(msg), "Catch-up: %d pulses, ~%lu s",
+                          plan.pulses, (unsigned long)((plan.etaMs + 999) / 1000));
+            break;
+        case CatchUpPlanStatus::HOLD:
+            snprintf(msg, sizeof(msg), "Dial %d min ahead: holding ~%lu s",
+                     plan.holdMinutes, (unsigned long)((plan.etaMs + 999) / 1000));
+            break;
+        case CatchUpPlanStatus::REJECTED:
+            snprintf(msg, sizeof(msg), "State updated; %d min exceeds catch-up limit", plan.pulses);
+            break;
+        default:
+            snprintf(msg, sizeof(msg), "State update queued");
+            break;
     }
 
-    server.send(200, "text/plain", "State updated and rescheduled");
+    char setHm[6];
+    snprintf(setHm, sizeof(setHm), "%02d:%02d", h, m);
+
+    StaticJsonDocument<256> out;
+    out["status"]      = catchUpPlanStatusName(plan.status);
+    out["seq"]         = plan.seq;
+    out["channel"]     = channel;
+    out["clock_time"]  = setHm;
+    out["pulses"]      = plan.pulses;
+    out["interval_ms"] = plan.intervalMs;
+    out["eta_ms"]      = plan.etaMs;
+    out["message"]     = msg;
+
+    String reply;
+    serializeJson(out, reply);
+    ex.send(200, "application/json", reply);
 }
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Log downloads: Range, ?since=, ?tail=
+// ──────────────────────────────────────────────────────────────────────────────
+
 /**
- * @brief Stream today's log based on RTC; if not present, stream the newest log.
+ * @brief Send all or part of a log file.
+ *
+ * Selection, first match wins:
+ *  - `Range: bytes=a-b | a- | -n` → 206 + Content-Range (416 if unsatisfiable;
+ *    multi-range requests get the whole file).
+ *  - `?since=<offset>` → bytes from offset to EOF; an offset past EOF means the
+ *    file was replaced (new day), so it restarts at 0.
+ *  - `?tail=<N>` → the last N lines (at most TAIL_MAX_LINES).
+ *  - otherwise the whole file.
+ * Every reply carries X-Log-Size (file size) so an incremental reader can
+ * pass it back as the next `since`.
  */
-void WebServerManager::handleApiLog() {
-    // 1) Try today's log per RTC
-    String todayName;
-    if (rtcManager && rtcManager->isRtcAvailable()) {
-        DateTime now = rtcManager->now();
-        char buf[16]; // "YYYY-MM-DD.txt"
-        snprintf(buf, sizeof(buf), "%04d-%02d-%02d.txt", now.year(), now.month(), now.day());
-        todayName = String(buf);
-        String path = "/logs/" + todayName;
-        File f = SD.open(path);
-        if (f) { server.streamFile(f, "text/plain"); f.close(); return; }
+void WebServerManager::sendLogFile(HttpExchange& ex, File& f) {
+    const size_t size = f.size();
+    size_t start = 0;
+    size_t len   = size;
+    int    code  = 200;
+
+    ex.sendHeader("Accept-Ranges", "bytes");
+    ex.sendHeader("X-Log-Size", String((unsigned long)size));
+
+    const String range = ex.header("Range");
+    if (range.length() > 0 && range.indexOf(',') < 0) {
+        if (!parseByteRange(range, size, start, len)) {
+            ex.sendHeader("Content-Range", "bytes */" + String((unsigned long)size));
+            ex.send(416, "text/plain", "Range not satisfiable");
+            f.close();
+            return;
+        }
+        char cr[48];
+        snprintf(cr, sizeof(cr), "bytes %lu-%lu/%lu",
+                 (unsigned long)start, (unsigned long)(start + len - 1), (unsigned long)size);
+        ex.sendHeader("Content-Range", cr);
+        code = 206;
+    } else if (ex.hasArg("since")) {
+        const long since = ex.arg("since").toInt();
+        start = (since >= 0 && (size_t)since <= size) ? (size_t)since : 0;
+        len   = size - start;
+    } else if (ex.hasArg("tail")) {
+        long lines = ex.arg("tail").toInt();
+        if (lines > TAIL_MAX_LINES) lines = TAIL_MAX_LINES;
+        start = tailOffset(f, (int)lines);
+        len   = size - start;
     }
 
-    // 2) Fallback: find the newest log in /logs
-    File dir = SD.open("/logs");
-    if (!dir || !dir.isDirectory()) {
-        server.send(404, "text/plain", "No logs directory");
+    if (start == 0 && len == size && code == 200) {
+        ex.streamFile(f, "text/plain");
         return;
     }
+    f.seek(start);
+    ex.streamFileRange(f, "text/plain", code, len);
+}
 
-    String newestBase; // "YYYY-MM-DD.txt"
-    for (;;) {
-        File f = dir.openNextFile();
-        if (!f) break;
-        if (!f.isDirectory()) {
-            String base = String(f.name());
-            // basename
-            if (base.startsWith("/")) {
-                int s = base.lastIndexOf('/');
-                if (s >= 0) base = base.substring(s + 1);
-            }
-            String lower = base; lower.toLowerCase();
-
-            // filter "YYYY-MM-DD.txt" (case-insensitive on extension)
-            bool ok = lower.endsWith(".txt") && base.length() >= 12;
-            if (ok) {
-                for (int i = 0; i < 10; ++i) {
-                    if (i == 4 || i == 7) ok &= (base[i] == '-');
-                    else ok &= isDigit(base[i]);
-                }
-            }
-            if (ok && (newestBase.isEmpty() || base > newestBase)) {
-                newestBase = base; // lexicographically latest date
-            }
+/**
+ * @brief Parse a single "bytes=" range against @p size.
+ * @return false if malformed or unsatisfiable.
+ */
+bool WebServerManager::parseByteRange(const String& header, size_t size, size_t& start, size_t& len) {
+    if (!header.startsWith("bytes=") || size == 0) return false;
+    const String spec = header.substring(6);
+    const int dash = spec.indexOf('-');
+    if (dash < 0) return false;
+
+    const String a = spec.substring(0, dash);
+    const String b = spec.substring(dash + 1);
+    if (a.isEmpty()) {                       // suffix: last n bytes
+        const long n = b.toInt();
+        if (n <= 0) return false;
+        start = (size_t)n >= size ? 0 : size - (size_t)n;
+        len   = size - start;
+        return true;
+    }
+
+    const long first = a.toInt();
+    if (first < 0 || (size_t)first >= size) return false;
+    long last = b.isEmpty() ? (long)size - 1 : b.toInt();
+    if (last < first) return false;
+    if ((size_t)last >= size) last = (long)size - 1;
+    start = (size_t)first;
+    len   = (size_t)(last - first) + 1;
+    return true;
+}
+
+/**
+ * @brief Offset of the first of the last @p lines lines, scanning backwards
+ *        in small blocks (a trailing newline does not count as a line).
+ */
+size_t WebServerManager::tailOffset(File& f, int lines) {
+    const size_t size = f.size();
+    if (lines <= 0) return size;
+
+    uint8_t buf[256];
+    size_t  pos  = size;
+    int     seen = 0;
+    while (pos > 0) {
+        const size_t n = pos < sizeof(buf) ? pos : sizeof(buf);
+        pos -= n;
+        f.seek(pos);
+        if (f.read(buf, n) != n) return 0;
+        for (size_t i = n; i-- > 0;) {
+            if (buf[i] != '\n' || pos + i == size - 1) continue;
+            if (++seen == lines) return pos + i + 1;
         }
-        f.close();
     }
-    dir.close();
+    return 0;
+}
 
-    if (!newestBase.isEmpty()) {
-        String path = "/logs/" + newestBase;
+/**
+ * @brief Stream today's log based on the system clock; if not present, stream the newest log.
+ *        Range/since/tail apply as in sendLogFile().
+ */
+void WebServerManager::handleApiLog(HttpExchange& ex) {
+    // 1) Try today's log per system clock
+    if (TimeSource::isValid()) {
+        char d[11];
+        TimeSource::date(d);
+        char path[24]; // "/logs/YYYY-MM-DD.txt"
+        snprintf(path, sizeof(path), "/logs/%s.txt", d);
         File f = SD.open(path);
-        if (f) { server.streamFile(f, "text/plain"); f.close(); return; }
+        if (f) { sendLogFile(ex, f); return; }
+    }
+
+    // 2) Fallback: newest text log of the log index (no directory walk)
+    LogIndexEntry newest;
+    size_t i = 0;
+    while (logIndex && logIndex->at(i, newest) && !newest.hasText()) i++;
+    if (logIndex && logIndex->at(i, newest)) {
+        char name[LogIndex::NAME_LEN];
+        LogIndex::formatName(newest.date, name);
+        File f = SD.open(String("/logs/") + name);
+        if (f) { sendLogFile(ex, f); return; }
     }
 
     // 3) Nothing found
-    server.send(404, "text/plain", "No logs available");
+    ex.send(404, "text/plain", "No logs available");
 }
 
 /**
  * @brief 404 handler for unknown routes and missing files.
  */
-void WebServerManager::handleNotFound() {
-    server.send(404, "text/plain", "Not found");
+void WebServerManager::handleNotFound(HttpExchange& ex) {
+    ex.send(404, "text/plain", "Not found");
 }
 
 /**
- * @brief List available logs in /logs as JSON: [{ "name": "...", "size": N }, ...]
+ * @brief List daily logs from the RAM index, newest first, as a chunked JSON array:
+ *        [{ "name": "YYYY-MM-DD.txt", "size": N }, ...]
+ *
+ * Paging: ?offset=K (default 0) and ?limit=N (default/max LOGS_PAGE_MAX).
+ * X-Total-Count carries the number of indexed days (a day that so far has
+ * only an event log is counted but not listed). The body is generated
+ * entry by entry, so memory use does not depend on how many logs exist.
  */
-void WebServerManager::handleApiLogsList() {
-  StaticJsonDocument<4096> doc;
-  JsonArray arr = doc.to<JsonArray>();
+void WebServerManager::handleApiLogsList(HttpExchange& ex) {
+  const size_t total = logIndex ? logIndex->count() : 0;
+  long offset = ex.hasArg("offset") ? ex.arg("offset").toInt() : 0;
+  long limit  = ex.hasArg("limit")  ? ex.arg("limit").toInt()  : (long)LOGS_PAGE_MAX;
+  if (offset < 0) offset = 0;
+  if (limit <= 0 || limit > (long)LOGS_PAGE_MAX) limit = (long)LOGS_PAGE_MAX;
 
-  File dir = SD.open("/logs");
-  if (!dir || !dir.isDirectory()) {
-    server.send(200, "application/json", "[]");
+  ex.sendHeader("X-Total-Count", String((unsigned long)total));
+  if (!logIndex || (size_t)offset >= total) {
+    ex.send(200, "application/json", "[]");
     return;
   }
 
-  for (;;) {
-    File f = dir.openNextFile();
-    if (!f) break;
-    if (!f.isDirectory()) {
-      // basename
-      String base = String(f.name());
-      if (base.startsWith("/")) {
-        int s = base.lastIndexOf('/');
-        if (s >= 0) base = base.substring(s + 1);
-      }
+  // Filler state: next index, end, and one rendered item that may span calls
+  struct Cursor {
+    const LogIndex* index;
+    size_t next, end;
+    char   item[64];
+    size_t itemLen = 0, itemPos = 0;
+    bool   opened  = false;   ///< "[" written.
+    bool   closed  = false;   ///< "]" rendered.
+  };
+  auto cur = std::make_shared<Cursor>();
+  cur->index = logIndex;
+  cur->next  = (size_t)offset;
+  cur->end   = min<size_t>(total, (size_t)offset + (size_t)limit);
 
-      // case-insensitive .txt
-      String lower = base; lower.toLowerCase();
-      if (lower.endsWith(".txt")) {
-        JsonObject o = arr.createNestedObject();
-        o["name"] = base;
-        o["size"] = f.size();
+  ex.sendChunked(200, "application/json", [cur](uint8_t* buf, size_t maxLen) -> size_t {
+    size_t out = 0;
+    while (out < maxLen) {
+      if (cur->itemPos == cur->itemLen) {
+        if (cur->closed) break;
+        const bool first = !cur->opened;
+        cur->opened = true;
+        LogIndexEntry e;
+        while (cur->next < cur->end && cur->index->at(cur->next, e) && !e.hasText()) cur->next++;  // event log only
+        if (cur->next < cur->end && cur->index->at(cur->next, e)) {
+          char name[LogIndex::NAME_LEN];
+          LogIndex::formatName(e.date, name);
+          cur->itemLen = (size_t)snprintf(cur->item, sizeof(cur->item), "%s{\"name\":\"%s\",\"size\":%lu}",
+                                          first ? "[" : ",", name, (unsigned long)e.size);
+          cur->next++;
+        } else {
+          cur->itemLen = (size_t)snprintf(cur->item, sizeof(cur->item), "%s]", first ? "[" : "");
+          cur->closed  = true;
+        }
+        cur->itemPos = 0;
       }
+      const size_t n = min(maxLen - out, cur->itemLen - cur->itemPos);
+      memcpy(buf + out, cur->item + cur->itemPos, n);
+      cur->itemPos += n;
+      out += n;
     }
-    f.close();
-  }
-  dir.close();
-
-  String out;
-  serializeJson(arr, out);
-  server.send(200, "application/json", out);
+    return out;
+  });
 }
 
 /**
@@ -312,33 +945,302 @@ void WebServerManager::handleApiLogsList() {
  * - Rejects names containing '/', '\\', or "..".
  * - Requires .txt (case-insensitive).
  */
-void WebServerManager::handleApiLogsFile() {
-  if (!server.hasArg("file")) {
-    server.send(400, "text/plain", "Missing 'file'");
+void WebServerManager::handleApiLogsFile(HttpExchange& ex) {
+  if (!ex.hasArg("file")) {
+    ex.send(400, "text/plain", "Missing 'file'");
     return;
   }
-  String name = server.arg("file");
+  String name = ex.arg("file");
 
   // Sanitization: basename only, no paths or traversal
   if (name.indexOf('/') >= 0 || name.indexOf('\\') >= 0 || name.indexOf("..") >= 0) {
-    server.send(400, "text/plain", "Bad file name");
+    ex.send(400, "text/plain", "Bad file name");
     return;
   }
 
   // Must end with .txt (case-insensitive)
   String lower = name; lower.toLowerCase();
   if (!lower.endsWith(".txt")) {
-    server.send(400, "text/plain", "Bad file name");
+    ex.send(400, "text/plain", "Bad file name");
     return;
   }
 
   String path = "/logs/" + name;
   File f = SD.open(path);
   if (!f) {
-    server.send(404, "text/plain", "Not found");
+    ex.send(404, "text/plain", "Not found");
+    return;
+  }
+
+  sendLogFile(ex, f);
+}
+
+/**
+ * @brief Decode one day's binary event log (EventLog) to JSON or text, streamed.
+ *        Example: GET /api/eventlog?date=2025-08-19&type=pulse&channel=0
+ *
+ * Parameters (all optional):
+ * - date=YYYY-MM-DD (default: today), type=<EventLog::typeName()>, channel=N
+ * - format=json (array, default) | text (one line per record)
+ * - offset=K: skip the first K records of the file (before filtering), so a
+ *   poller can pass the previous X-Record-Count to get only new records
+ * - limit=N: at most N records in the reply (default/max EVENTLOG_LIMIT_MAX)
+ *
+ * X-Record-Count is the number of records in the file.
+ */
+void WebServerManager::handleApiEventLog(HttpExchange& ex) {
+  if (!eventLog) {
+    ex.send(404, "text/plain", "Event log disabled");
+    return;
+  }
+
+  char date[11];
+  if (ex.hasArg("date")) {
+    const String d = ex.arg("date");
+    uint32_t key;
+    if (d.length() != 10 || !LogIndex::parseName((d + ".txt").c_str(), key)) {
+      ex.send(400, "text/plain", "Bad date. Use YYYY-MM-DD");
+      return;
+    }
+    strlcpy(date, d.c_str(), sizeof(date));
+  } else {
+    TimeSource::date(date);
+  }
+
+  uint8_t type = 0;
+  if (ex.hasArg("type") && !EventLog::typeFromName(ex.arg("type").c_str(), type)) {
+    ex.send(400, "text/plain", "Unknown type");
+    return;
+  }
+  const long channel = ex.hasArg("channel") ? ex.arg("channel").toInt() : -1;
+  const bool text    = ex.arg("format") == "text";
+  long offset = ex.hasArg("offset") ? ex.arg("offset").toInt() : 0;
+  long limit  = ex.hasArg("limit")  ? ex.arg("limit").toInt()  : EVENTLOG_LIMIT_MAX;
+  if (offset < 0) offset = 0;
+  if (limit <= 0 || limit > EVENTLOG_LIMIT_MAX) limit = EVENTLOG_LIMIT_MAX;
+
+  char path[40];
+  eventLog->pathFor(date, path, sizeof(path));
+  File f = SD.open(path, FILE_READ);
+  if (!f) {
+    ex.send(404, "text/plain", "No event log for that date");
+    return;
+  }
+
+  // Skip the magic, then whole records
+  const size_t hdr = sizeof(EventLog::MAGIC);
+  const size_t records = f.size() > hdr ? (f.size() - hdr) / sizeof(EventRecord) : 0;
+  ex.sendHeader("X-Record-Count", String((unsigned long)records));
+  f.seek(hdr + (size_t)offset * sizeof(EventRecord));
+
+  struct Cursor {
+    File     file;
+    uint8_t  type;
+    long     channel;
+    bool     text;
+    long     left;                    ///< Records still allowed in the reply.
+    EventRecord block[32];
+    size_t   blockLen = 0, blockPos = 0;
+    char     item[128];
+    size_t   itemLen = 0, itemPos = 0;
+    bool     opened = false, closed = false;
+  };
+  auto cur = std::make_shared<Cursor>();
+  cur->file    = f;
+  cur->type    = type;
+  cur->channel = channel;
+  cur->text    = text;
+  cur->left    = limit;
+
+  auto nextRecord = [](Cursor& c, EventRecord& r) -> bool {
+    while (c.left > 0) {
+      if (c.blockPos == c.blockLen) {
+        c.blockLen = c.file.read((uint8_t*)c.block, sizeof(c.block)) / sizeof(EventRecord);
+        c.blockPos = 0;
+        if (c.blockLen == 0) return false;
+      }
+      r = c.block[c.blockPos++];
+      if (c.type && r.type != c.type) continue;
+      if (c.channel >= 0 && r.channel != c.channel) continue;
+      c.left--;
+      return true;
+    }
+    return false;
+  };
+
+  ex.sendChunked(200, text ? "text/plain" : "application/json", [cur, nextRecord](uint8_t* buf, size_t maxLen) -> size_t {
+    size_t out = 0;
+    while (out < maxLen) {
+      if (cur->itemPos == cur->itemLen) {
+        if (cur->closed) break;
+        const bool first = !cur->opened;
+        cur->opened = true;
+        EventRecord r;
+        int n = 0;
+        if (nextRecord(*cur, r)) {
+          if (cur->text) {
+            n = EventLog::formatText(r, cur->item, sizeof(cur->item) - 1);
+            n = min<int>(n, (int)sizeof(cur->item) - 2);
+            cur->item[n++] = '\n';
+          } else {
+            cur->item[0] = first ? '[' : ',';
+            n = 1 + EventLog::formatJson(r, cur->item + 1, sizeof(cur->item) - 1);
+            n = min<int>(n, (int)sizeof(cur->item) - 1);
+          }
+        } else {
+          if (!cur->text) n = snprintf(cur->item, sizeof(cur->item), "%s]", first ? "[" : "");
+          cur->closed = true;
+          cur->file.close();
+        }
+        cur->itemLen = (size_t)max(n, 0);
+        cur->itemPos = 0;
+        if (cur->itemLen == 0) continue;
+      }
+      const size_t n = min(maxLen - out, cur->itemLen - cur->itemPos);
+      memcpy(buf + out, cur->item + cur->itemPos, n);
+      cur->itemPos += n;
+      out += n;
+    }
+    return out;
+  });
+}
+
+/**
+ * @brief Performance counters for field diagnostics.
+ *        Example: GET /api/metrics (Prometheus text) or /api/metrics?format=json
+ *
+ * One snapshot is taken per request; the Prometheus text is rendered one
+ * metric family or bucket line at a time as the response drains. JSON gives
+ * count/avg/max and estimated p50/p90/p99 per histogram instead of buckets.
+ */
+void WebServerManager::handleApiMetrics(HttpExchange& ex) {
+  struct Cursor {
+    MetricsSnapshot snap;
+    size_t next = 0;
+    char   item[Metrics::PROM_ITEM_MAX];
+    size_t itemLen = 0, itemPos = 0;
+    bool   done    = false;
+  };
+  auto cur = std::make_shared<Cursor>();
+  Metrics::snapshot(cur->snap);
+  const MetricsSnapshot& s = cur->snap;
+
+  if (ex.arg("format") == "json") {
+    StaticJsonDocument<1536> doc;
+    doc["uptime_s"]      = s.uptimeS;
+    doc["heap_free"]     = s.heapFree;
+    doc["heap_min_free"] = s.heapMinFree;
+
+    JsonObject c = doc.createNestedObject("counters");
+    for (int i = 0; i < (int)Metric::COUNT; i++) c[Metrics::name((Metric)i)] = s.counters[i];
+
+    JsonObject g = doc.createNestedObject("gauges");
+    for (int i = 0; i < (int)Gauge::COUNT; i++) g[Metrics::name((Gauge)i)] = roundf(s.gauges[i] * 1000.0f) / 1000.0f;
+
+    JsonObject h = doc.createNestedObject("latency");
+    for (int i = 0; i < (int)Latency::COUNT; i++) {
+      const Latency       l  = (Latency)i;
+      const LatencyStats& st = s.latency[i];
+      JsonObject o = h.createNestedObject(Metrics::name(l));
+      o["count"] = st.count;
+      o["avg"]   = st.count ? (uint32_t)(st.sum / st.count) : 0;
+      o["max"]   = st.max;
+      o["p50"]   = Metrics::percentile(st, l, 0.50f);
+      o["p90"]   = Metrics::percentile(st, l, 0.90f);
+      o["p99"]   = Metrics::percentile(st, l, 0.99f);
+    }
+
+    String output;
+    serializeJson(doc, output);
+    ex.send(200, "application/json", output);
+    return;
+  }
+
+  ex.sendChunked(200, "text/plain; version=0.0.4", [cur](uint8_t* buf, size_t maxLen) -> size_t {
+    size_t out = 0;
+    while (out < maxLen) {
+      if (cur->itemPos == cur->itemLen) {
+        if (cur->done) break;
+        const int n = Metrics::formatPrometheus(cur->snap, cur->next++, cur->item, sizeof(cur->item));
+        if (n < 0) { cur->done = true; break; }
+        cur->itemLen = min<size_t>((size_t)n, sizeof(cur->item) - 1);
+        cur->itemPos = 0;
+      }
+      const size_t n = min(maxLen - out, cur->itemLen - cur->itemPos);
+      memcpy(buf + out, cur->item + cur->itemPos, n);
+      cur->itemPos += n;
+      out += n;
+    }
+    return out;
+  });
+}
+
+/**
+ * @brief Fleet role and, on the leader, the aggregated node dashboard.
+ *        Example: GET /api/fleet
+ *
+ * {
+ *   "mode": "auto", "role": "leader", "node_id": "a4cf12…", "leader_id": "a4cf12…",
+ *   "nodes": [ { "name": "hall-2", "ip": "10.0.0.31", "role": "follower", "priority": 100,
+ *                "synced": true, "offset_ms": 0.4, "age_s": 12,
+ *                "channels": [ { "clock_time": "14:02", "edge_offset_ms": 0.9, "catchup": false } ] } ]
+ * }
+ *
+ * The first node is this controller. Followers list only themselves; their
+ * offset_ms is the last filtered offset to the leader before it was applied.
+ */
+void WebServerManager::handleApiFleet(HttpExchange& ex) {
+  if (!fleetManager) {
+    ex.send(404, "text/plain", "Fleet mode disabled");
     return;
   }
+  std::unique_ptr<FleetSnapshot> snap(new FleetSnapshot);   // ~2 KB: off the handler's stack
+  fleetManager->snapshot(*snap);
+  const FleetSnapshot& s = *snap;
+
+  DynamicJsonDocument doc(512 + (size_t)s.nodeCount * (256 + MAX_CHANNELS * 128));
+  char id[17];
+  doc["mode"] = ConfigManager::fleetModeName(s.mode);
+  doc["role"] = FleetManager::roleName(s.role);
+  snprintf(id, sizeof(id), "%012llx", (unsigned long long)s.selfId);
+  doc["node_id"] = id;
+  if (s.leaderId) {
+    snprintf(id, sizeof(id), "%012llx", (unsigned long long)s.leaderId);
+    doc["leader_id"] = id;
+    if (s.role == FleetRole::FOLLOWER) doc["leader_age_s"] = s.leaderAgeMs / 1000;
+  }
+
+  JsonArray nodes = doc.createNestedArray("nodes");
+  for (int i = 0; i < s.nodeCount; i++) {
+    const FleetNodeStatus& n = s.nodes[i];
+    JsonObject o = nodes.createNestedObject();
+    snprintf(id, sizeof(id), "%012llx", (unsigned long long)n.nodeId);
+    o["id"]       = id;
+    o["name"]     = n.name;
+    o["ip"]       = IPAddress(n.ip).toString();
+    o["role"]     = FleetManager::roleName(n.role);
+    o["priority"] = n.priority;
+    o["synced"]   = n.synced;
+    if (n.role == FleetRole::FOLLOWER) o["offset_ms"] = roundf(n.offsetUs / 100.0f) / 10.0f;
+    o["age_s"]    = n.ageMs / 1000;
+
+    JsonArray chans = o.createNestedArray("channels");
+    for (int c = 0; c < n.channelCount; c++) {
+      const FleetChannelStatus& ch = n.ch[c];
+      JsonObject co = chans.createNestedObject();
+      if (ch.clockMinutes >= 0) {
+        char hm[6];
+        snprintf(hm, sizeof(hm), "%02u:%02u", (unsigned)ch.clockMinutes / 60 % 24, (unsigned)ch.clockMinutes % 60);
+        co["clock_time"] = hm;
+      }
+      if (ch.edgeOffsetUs >= 0) co["edge_offset_ms"] = roundf(ch.edgeOffsetUs / 100.0f) / 10.0f;
+      co["catchup"] = (ch.flags & FLEET_CH_CATCHUP) != 0;
+      if (ch.flags & FLEET_CH_HOLD) co["holding"] = true;
+      if (ch.remaining) co["remaining"] = ch.remaining;
+    }
+  }
 
-  server.streamFile(f, "text/plain");
-  f.close();
+  String output;
+  serializeJson(doc, output);
+  ex.send(200, "application/json", output);
 }
@@ -5,17 +5,29 @@
 
 #pragma once
 
-#include <WebServer.h>
 #include <Arduino.h>
+#include <atomic>
 #include <RTClib.h>
 #include "StateManager.h"
 #include "ConfigManager.h"
 #include "RTCManager.h"
+#include "CatchUpPlan.h"
+#include "PowerManager.h"
+#include "HttpExchange.h"
+#include "EventManager.h"
+#include "LogIndex.h"
+#include "EventLog.h"
+#include "Metrics.h"
+
+class FleetManager;
 
 /**
  * @class WebServerManager
  * @brief Exposes REST-style endpoints and serves a static UI from SD.
  *
+ * The backend is chosen at build time (WEB_ASYNC, see HttpExchange.h); route
+ * handlers are written against HttpExchange and are shared by both.
+ *
  * Usage:
  *   WebServerManager web(&state, &config, &rtc);
  *   web.begin(80);
@@ -29,46 +41,139 @@ public:
     /// Start the server and register routes (port parameter kept for API symmetry).
     void begin(uint16_t port = 80);
 
-    /// Process client requests; call frequently from the main loop.
+    /// Process client requests and push queued events; call frequently from the network task.
     void handleClient();
 
-    // SystemManager registers a handler that will be called after manual time set.
-    using ClockSetHandler = void (*)(int newClockMinutes);
+    // SystemManager registers a handler that applies a manual time set and returns its plan.
+    using ClockSetHandler = CatchUpPlan (*)(int channel, int newClockMinutes);
     void setOnClockSet(ClockSetHandler handler) { onClockSet = handler; }
 
+    // Optional catch-up progress source for /api/status; false once channel is out of range.
+    using CatchUpStatusProvider = bool (*)(int channel, CatchUpStatus& out);
+    void setCatchUpStatusProvider(CatchUpStatusProvider provider) { catchUpStatusProvider = provider; }
+
+    // Optional power/duty statistics for /api/status.
+    void setPowerManager(const PowerManager* pm) { powerManager = pm; }
+
+    // Daily log index (Logger::index()) for /api/logs and the newest-log fallback of /api/log.
+    void setLogIndex(const LogIndex* index) { logIndex = index; }
+
+    // Binary event log decoded by /api/eventlog (before begin()).
+    void setEventLog(const EventLog* el) { eventLog = el; }
+
+    // Fleet mode state and (on the leader) the node dashboard for /api/fleet.
+    void setFleetManager(const FleetManager* fm) { fleetManager = fm; }
+
+    // Optional live feed for /api/events (Server-Sent Events); drained by handleClient().
+    void setEventManager(EventManager* em) { events = em; }
+
 private:
+#if WEB_ASYNC
+    AsyncWebServer server;
+    std::atomic<int> inFlight{0};         ///< Requests admitted and not yet destroyed.
+#else
     WebServer     server;
+#endif
     StateManager* stateManager;
     ConfigManager* configManager;
     RTCManager*   rtcManager;
 
     ClockSetHandler onClockSet = nullptr; // callback invoked after /api/set-state
+    CatchUpStatusProvider catchUpStatusProvider = nullptr;
+    const PowerManager*   powerManager = nullptr;
+    const LogIndex*       logIndex     = nullptr;
+    const EventLog*       eventLog     = nullptr;
+    const FleetManager*   fleetManager = nullptr;
+    static constexpr long EVENTLOG_LIMIT_MAX = 10000;  ///< Records per /api/eventlog reply.
+    static constexpr size_t LOGS_PAGE_MAX = 100;   ///< Largest /api/logs page.
+
+    // Server-Sent Events (/api/events)
+    static constexpr size_t   SSE_MAX_CLIENTS    = 4;
+    static constexpr int      SSE_EVENTS_PER_RUN = 8;      ///< Bound the work per handleClient().
+    static constexpr uint32_t SSE_PING_MS        = 15000;  ///< Comment line keeps proxies and dead-peer detection going.
+    EventManager* events = nullptr;
+#if WEB_ASYNC
+    AsyncEventSource sse{"/api/events"};
+#else
+    // WebServer serves one connection at a time, so streams get their own port
+    static constexpr uint16_t SSE_PORT       = 81;
+    static constexpr uint32_t SSE_REQUEST_MS = 2000;   ///< A new socket must send its GET within.
+    struct SseClient {
+        WiFiClient client;
+        bool       streaming = false;   ///< Request answered, frames go out.
+        uint32_t   acceptedMs = 0;
+    };
+    WiFiServer    sseServer{SSE_PORT};
+    SseClient     sseClients[SSE_MAX_CLIENTS];
+    uint32_t      sseLastPingMs = 0;
+    void handleApiEvents();            // GET /api/events → 307 to SSE_PORT
+    void acceptEventClients();         ///< New stream sockets and their requests.
+    void sseBroadcast(const char* frame, size_t len);   ///< Non-blocking; drops clients with a full socket.
+#endif
+    void pumpEvents();                 ///< Queue → connected SSE clients.
+
+    // Static assets cached in RAM (PSRAM if present) at begin()
+    struct CachedAsset {
+        String         path;             ///< URI, without ".gz".
+        uint8_t*       data = nullptr;
+        size_t         len  = 0;
+        bool           gzip = false;     ///< data is the pre-gzipped "<path>.gz".
+        char           etag[12] = "";    ///< "\"crc32\"" of data.
+    };
+    static constexpr size_t ASSET_CACHE_SLOTS = 12;
+    static constexpr size_t ASSET_MAX_BYTES   = 16 * 1024;  ///< Larger files always stream from SD.
+    CachedAsset assets[ASSET_CACHE_SLOTS];
+    size_t      assetCount = 0;
+
+    void loadAssetCache(size_t budgetBytes);
+    bool cacheAsset(const String& path, size_t& budget);
+    const CachedAsset* findAsset(const String& path) const;
+    bool serveStatic(HttpExchange& ex, const String& path);   ///< false → not found.
+    bool clientAcceptsGzip(HttpExchange& ex);
+    bool notModified(HttpExchange& ex, const char* etag);      ///< Sends 304 when If-None-Match matches.
+    void sendCacheHeaders(HttpExchange& ex, const char* etag);
+
+    // Route table (registered on either backend in begin())
+    using Handler = void (WebServerManager::*)(HttpExchange&);
+    struct Route {
+        const char* path;
+        bool        post;              ///< POST, else GET.
+        Handler     fn;
+    };
+    static const Route ROUTES[];
+    static constexpr size_t MAX_BODY_BYTES = 512;  ///< Request bodies are small JSON commands.
+#if WEB_ASYNC
+    void dispatch(AsyncWebServerRequest* req, Handler fn);   ///< Connection limit, then handler.
+#endif
+    void timed(HttpExchange& ex, Handler fn);                 ///< Handler + HTTP metrics.
 
     // Route handlers
-    void handleRoot();
-    void handleFileRequest();
-    void handleApiStatus();
-    void handleApiSetState();
-    void handleApiLog();
-    void handleNotFound();
-    void handleApiLogsList();          // GET /api/logs
-    void handleApiLogsFile();          // GET /api/logfile?file=YYYY-MM-DD.txt
+    void handleRoot(HttpExchange& ex);
+    void handleFileRequest(HttpExchange& ex);
+    void handleApiStatus(HttpExchange& ex);
+    void handleApiSetState(HttpExchange& ex);
+    void handleApiLog(HttpExchange& ex);
+    void handleNotFound(HttpExchange& ex);
+    void handleApiLogsList(HttpExchange& ex);          // GET /api/logs
+    void handleApiLogsFile(HttpExchange& ex);          // GET /api/logfile?file=YYYY-MM-DD.txt
+    void handleApiEventLog(HttpExchange& ex);          // GET /api/eventlog?date=YYYY-MM-DD
+    void handleApiMetrics(HttpExchange& ex);           // GET /api/metrics[?format=json]
+    void handleApiFleet(HttpExchange& ex);             // GET /api/fleet
+
+    // Partial log reads
+    static constexpr long TAIL_MAX_LINES = 2000;
+    void sendLogFile(HttpExchange& ex, File& f);       ///< Range / ?since= / ?tail= or whole file.
+    static bool   parseByteRange(const String& header, size_t size, size_t& start, size_t& len);
+    static size_t tailOffset(File& f, int lines);
 
     // Utilities
+    static void fillCatchUp(JsonObject c, const CatchUpStatus& cu);
     static String hhmmFromDateTime(const DateTime& dt) {
         char buf[6];
         snprintf(buf, sizeof(buf), "%02d:%02d", dt.hour(), dt.minute());
         return String(buf);
     }
-    static String contentTypeFor(const String& path) {
-        if (path.endsWith(".html")) return "text/html";
-        if (path.endsWith(".css"))  return "text/css";
-        if (path.endsWith(".js"))   return "application/javascript";
-        if (path.endsWith(".json")) return "application/json";
-        if (path.endsWith(".txt"))  return "text/plain";
-        if (path.endsWith(".ico"))  return "image/x-icon";
-        if (path.endsWith(".png"))  return "image/png";
-        if (path.endsWith(".svg"))  return "image/svg+xml";
-        return "text/plain";
-    }
+    /// MIME type by extension (a trailing ".gz" is ignored); text/plain if unknown.
+    static const char* contentTypeFor(const String& path);
+    static bool        isStaticAsset(const String& path);   ///< Known, cacheable extension.
 };
@@ -0,0 +1,850 @@
+/**
+ * @file    SimHal.cpp
+ * @brief   Implementation of the host HAL (sim/hal) over the virtual world.
+ */
+
+#include "SimHal.h"
+#include <FS.h>
+#include <SD.h>
+#include <RTClib.h>
+#include <Preferences.h>
+#include <esp_sntp.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_rom_crc.h>
+#include <climits>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+// ──────────────────────────────────────────────────────────────────────────────
+// World state
+// ──────────────────────────────────────────────────────────────────────────────
+
+struct esp_timer {
+    esp_timer_cb_t cb     = nullptr;
+    void*          arg    = nullptr;
+    bool           active = false;
+    uint64_t       dueUs  = 0;       ///< Uptime µs.
+    uint64_t       periodUs = 0;     ///< 0 = one-shot.
+};
+
+struct SimTask { sim::Task task; };
+
+namespace {
+
+struct World {
+    sim::Params params;
+
+    int64_t  trueUs      = 0;
+    int64_t  bootTrueUs  = 0;
+    bool     powered     = false;
+
+    // System clock: sysBaseUs at sysBaseTrueUs, running at params.sysPpm
+    int64_t  sysBaseUs     = 0;
+    int64_t  sysBaseTrueUs = 0;
+
+    // DS1307 (local wall time, battery-backed)
+    bool     rtcRunning    = false;
+    uint32_t rtcBaseLocal  = 0;
+    int64_t  rtcBaseTrueUs = 0;
+    uint8_t  rtcNvram[56]  = {};
+
+    // Network / SNTP
+    bool     network        = true;
+    int64_t  wifiUpTrueUs   = 0;          ///< Association done (per boot).
+    int64_t  ntpErrUs       = 0;
+    bool     sntpOn         = false;
+    int64_t  sntpNextUs     = -1;         ///< True µs of the next request attempt.
+    uint32_t sntpIntervalMs = 3600000;    ///< ESP-IDF default re-sync period.
+    sntp_sync_time_cb_t sntpCb = nullptr;
+
+    std::vector<std::unique_ptr<esp_timer>> timers;
+    std::vector<shutdown_handler_t>         shutdownHandlers;
+
+    SimTask  tasks[2] = { { sim::Task::CLOCK }, { sim::Task::NET } };
+    sim::Task current = sim::Task::CLOCK;
+    bool     notified[2] = {};
+
+    std::map<int, int>          pins;
+    std::vector<sim::Movement>  movements;
+
+    std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+
+    sim::CardStats card;
+    uint64_t       serialBytes = 0;
+};
+
+World world;   // nothing firmware-side touches it during static initialization
+
+inline World& w() { return world; }
+
+int64_t sysNowUs() {
+    const World& g = w();
+    const int64_t dt = g.trueUs - g.sysBaseTrueUs;
+    return g.sysBaseUs + dt + (int64_t)((double)dt * g.params.sysPpm * 1e-6);
+}
+
+void setSysUs(int64_t us) {
+    World& g = w();
+    g.sysBaseUs     = us;
+    g.sysBaseTrueUs = g.trueUs;
+}
+
+/// One SNTP request: answered (clock stepped, callback) or retried later.
+void sntpAttempt() {
+    World& g = w();
+    if (!g.network || g.trueUs < g.wifiUpTrueUs) {
+        g.sntpNextUs = g.trueUs + (int64_t)g.params.ntpRetryMs * 1000;
+        return;
+    }
+    setSysUs(g.trueUs + g.ntpErrUs);
+    g.sntpNextUs = g.trueUs + (int64_t)g.sntpIntervalMs * 1000;
+    if (g.sntpCb) {
+        timeval tv;
+        const int64_t s = sysNowUs();
+        tv.tv_sec  = (time_t)(s / 1000000);
+        tv.tv_usec = (suseconds_t)(s % 1000000);
+        g.sntpCb(&tv);
+    }
+}
+
+void scheduleSntp() {
+    World& g = w();
+    g.sntpNextUs = g.trueUs + (int64_t)g.params.ntpLatencyMs * 1000;
+}
+
+/// Apply the end of a drive to a movement (normal end or power cut).
+void endDrive(sim::Movement& m) {
+    World& g = w();
+    m.driving = false;
+    if (g.trueUs - m.driveStartUs < (int64_t)g.params.minDriveUs) {
+        m.tooShort++;
+        return;
+    }
+    if (m.polarity == m.lastPolarity) {
+        m.samePolarity++;
+        return;
+    }
+    if (g.params.minStepMs && m.lastStepUs >= 0 &&
+        m.driveStartUs - m.lastStepUs < (int64_t)g.params.minStepMs * 1000) {
+        m.slipped++;
+        return;
+    }
+    m.lastStepUs   = m.driveStartUs;
+    m.lastPolarity = m.polarity;
+    m.dial = (m.dial + 1) % 1440;
+    m.steps++;
+}
+
+void updateMovements(int pin) {
+    World& g = w();
+    for (sim::Movement& m : g.movements) {
+        if (pin != m.pin1 && pin != m.pin2) continue;
+        const int  l1 = g.pins[m.pin1];
+        const int  l2 = g.pins[m.pin2];
+        const bool drive = (l1 != l2);
+        if (drive && !m.driving) {
+            m.driving      = true;
+            m.polarity     = l1 ? 0 : 1;
+            m.driveStartUs = g.trueUs;
+        } else if (!drive && m.driving) {
+            endDrive(m);
+        }
+    }
+}
+
+sim::FileKind kindOf(const std::string& path) {
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".evl") == 0) return sim::FileKind::EVENT_LOG;
+    if (path.compare(0, 6, "/logs/") == 0)  return sim::FileKind::LOG;
+    if (path.compare(0, 6, "/state") == 0)  return sim::FileKind::STATE;
+    return sim::FileKind::OTHER;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────────────────────────
+// sim:: control API
+// ──────────────────────────────────────────────────────────────────────────────
+
+namespace sim {
+
+Params& params() { return w().params; }
+
+int64_t  trueUtcUs() { return w().trueUs; }
+uint64_t uptimeUs()  { return (uint64_t)(w().trueUs - w().bootTrueUs); }
+
+int64_t nextEventUs() {
+    const World& g = w();
+    int64_t next = INT64_MAX;
+    for (const auto& t : g.timers) {
+        if (t->active) next = std::min(next, g.bootTrueUs + (int64_t)t->dueUs);
+    }
+    if (g.sntpOn && g.sntpNextUs >= 0) next = std::min(next, g.sntpNextUs);
+    return next;
+}
+
+void runUntil(int64_t target) {
+    World& g = w();
+    for (;;) {
+        const int64_t next = nextEventUs();
+        if (next > target) break;
+        if (next > g.trueUs) g.trueUs = next;
+
+        if (g.sntpOn && g.sntpNextUs >= 0 && g.sntpNextUs <= g.trueUs) {
+            sntpAttempt();
+            continue;
+        }
+        for (auto& t : g.timers) {
+            if (!t->active || g.bootTrueUs + (int64_t)t->dueUs > g.trueUs) continue;
+            if (t->periodUs) t->dueUs += t->periodUs; else t->active = false;
+            t->cb(t->arg);
+            break;
+        }
+    }
+    if (target > g.trueUs) g.trueUs = target;
+}
+
+void setTrueUtcUs(int64_t us) { w().trueUs = us; }
+
+void setNetwork(bool up)            { w().network = up; }
+bool networkUp()                    { return w().network; }
+int64_t wifiUpUs()                  { return w().wifiUpTrueUs; }
+void setNtpServerErrorMs(int64_t ms) { w().ntpErrUs = ms * 1000; }
+
+void powerOff() {
+    World& g = w();
+    for (Movement& m : g.movements) {
+        if (m.driving) endDrive(m);
+    }
+    for (auto& t : g.timers) t->active = false;
+    g.timers.clear();              // the firmware objects owning them are gone too
+    g.shutdownHandlers.clear();
+    g.sntpOn     = false;
+    g.sntpNextUs = -1;
+    g.sntpCb     = nullptr;
+    g.pins.clear();
+    g.notified[0] = g.notified[1] = false;
+    g.powered = false;
+}
+
+void powerOn() {
+    World& g = w();
+    g.bootTrueUs = g.trueUs;
+    g.wifiUpTrueUs = g.trueUs + (int64_t)g.params.wifiAssocMs * 1000;
+    g.sysBaseUs  = 0;              // cold boot: time() starts at the epoch
+    g.sysBaseTrueUs = g.trueUs;
+    g.sntpIntervalMs = 3600000;
+    g.powered = true;
+}
+
+void setRtcLocal(uint32_t localUnix) {
+    World& g = w();
+    g.rtcBaseLocal  = localUnix;
+    g.rtcBaseTrueUs = g.trueUs;
+    g.rtcRunning    = true;
+}
+
+uint32_t rtcLocal() {
+    const World& g = w();
+    if (!g.rtcRunning) return g.rtcBaseLocal;
+    const double dt = (double)(g.trueUs - g.rtcBaseTrueUs) * (1.0 + g.params.rtcPpm * 1e-6);
+    return g.rtcBaseLocal + (uint32_t)(dt / 1e6);
+}
+
+void         setCurrentTask(Task t) { w().current = t; }
+TaskHandle_t taskHandle(Task t)     { return &w().tasks[(int)t]; }
+bool takeNotify(Task t) {
+    bool& n = w().notified[(int)t];
+    const bool was = n;
+    n = false;
+    return was;
+}
+
+int addMovement(int pin1, int pin2, int dialMinutes, int8_t lastPolarity) {
+    Movement m;
+    m.pin1 = pin1;
+    m.pin2 = pin2;
+    m.dial = dialMinutes;
+    m.lastPolarity = lastPolarity;
+    w().movements.push_back(m);
+    return (int)w().movements.size() - 1;
+}
+Movement& movement(int index) { return w().movements[index]; }
+int       movementCount()     { return (int)w().movements.size(); }
+
+const CardStats& cardStats() { return w().card; }
+
+const char* fileKindName(FileKind k) {
+    static const char* const NAMES[] = { "log", "eventlog", "state", "other" };
+    return NAMES[(int)k];
+}
+
+uint64_t serialBytes() { return w().serialBytes; }
+
+} // namespace sim
+
+// ──────────────────────────────────────────────────────────────────────────────
+// libc time redirects (see hal/sim_time.h)
+// ──────────────────────────────────────────────────────────────────────────────
+
+extern "C" time_t sim_time(time_t* out) {
+    const time_t t = (time_t)(sysNowUs() / 1000000);
+    if (out) *out = t;
+    return t;
+}
+
+extern "C" int sim_gettimeofday(struct timeval* tv, void* /*tz*/) {
+    const int64_t us = sysNowUs();
+    tv->tv_sec  = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+extern "C" int sim_settimeofday(const struct timeval* tv, const void* /*tz*/) {
+    setSysUs((int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+    return 0;
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Arduino core
+// ──────────────────────────────────────────────────────────────────────────────
+
+HardwareSerial Serial;
+EspClass       ESP;
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+    World& g = w();
+    g.serialBytes += n;
+    if (g.params.verbose) {
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] != '\r') fputc(buf[i], stdout);
+        }
+    }
+    return n;
+}
+
+uint32_t millis() { return (uint32_t)(sim::uptimeUs() / 1000); }
+uint32_t micros() { return (uint32_t)sim::uptimeUs(); }
+void delay(unsigned long ms)         { sim::runUntil(w().trueUs + (int64_t)ms * 1000); }
+void delayMicroseconds(unsigned us)  { sim::runUntil(w().trueUs + us); }
+void yield() {}
+
+void pinMode(int pin, int) { w().pins[pin]; }
+void digitalWrite(int pin, int value) {
+    w().pins[pin] = value ? HIGH : LOW;
+    updateMovements(pin);
+}
+int digitalRead(int pin) {
+    for (const sim::Movement& m : w().movements) {
+        if (pin == m.sensePin) return m.dial & 1;
+    }
+    return w().pins[pin];
+}
+int analogRead(int pin) {
+    for (const sim::Movement& m : w().movements) {
+        if (pin == m.sensePin) return m.driving ? 2000 : 0;
+    }
+    return 0;
+}
+
+void EspClass::restart() { esp_restart(); }
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+    const uint32_t start = millis();
+    while ((uint32_t)(millis() - start) <= ms) {
+        time_t now = sim_time(nullptr);
+        localtime_r(&now, info);
+        if (info->tm_year > (2016 - 1900)) return true;
+        delay(10);
+    }
+    return false;
+}
+
+void configTzTime(const char* tz, const char*, const char*, const char*) {
+    World& g = w();
+    g.sntpOn = true;
+    scheduleSntp();
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    const size_t len = strlen(src);
+    if (size) {
+        const size_t n = std::min(len, size - 1);
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+size_t strlcat(char* dst, const char* src, size_t size) {
+    const size_t used = strnlen(dst, size);
+    if (used == size) return size + strlen(src);
+    return used + strlcpy(dst + used, src, size - used);
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// ESP-IDF
+// ──────────────────────────────────────────────────────────────────────────────
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    auto t = std::make_unique<esp_timer>();
+    t->cb  = args->callback;
+    t->arg = args->arg;
+    *out = t.get();
+    w().timers.push_back(std::move(t));
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeoutUs) {
+    if (t->active) return ESP_FAIL;
+    t->active   = true;
+    t->periodUs = 0;
+    t->dueUs    = sim::uptimeUs() + timeoutUs;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t periodUs) {
+    if (t->active) return ESP_FAIL;
+    t->active   = true;
+    t->periodUs = periodUs;
+    t->dueUs    = sim::uptimeUs() + periodUs;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    if (!t->active) return ESP_FAIL;
+    t->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t) {
+    auto& v = w().timers;
+    for (size_t i = 0; i < v.size(); i++) {
+        if (v[i].get() == t) { v.erase(v.begin() + i); return ESP_OK; }
+    }
+    return ESP_FAIL;
+}
+
+int64_t esp_timer_get_time(void) { return (int64_t)sim::uptimeUs(); }
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    w().shutdownHandlers.push_back(handler);
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    for (shutdown_handler_t h : w().shutdownHandlers) h();
+    fprintf(stderr, "sim: firmware called esp_restart(); software resets are not simulated\n");
+    exit(3);
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb) { w().sntpCb = cb; }
+bool sntp_enabled(void) { return w().sntpOn; }
+bool sntp_restart(void) {
+    if (!w().sntpOn) return false;
+    scheduleSntp();
+    return true;
+}
+void sntp_stop(void) {
+    w().sntpOn     = false;
+    w().sntpNextUs = -1;
+}
+void sntp_init(void) {
+    w().sntpOn = true;
+    scheduleSntp();
+}
+void     sntp_set_sync_interval(uint32_t ms) { w().sntpIntervalMs = ms; }
+uint32_t sntp_get_sync_interval(void)        { return w().sntpIntervalMs; }
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const* buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// FreeRTOS
+// ──────────────────────────────────────────────────────────────────────────────
+
+struct SimQueue {
+    size_t length;
+    size_t itemSize;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    return new SimQueue{ length, itemSize, {} };
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t) {
+    if (q->items.size() >= q->length) return pdFALSE;
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    return pdTRUE;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item) {
+    q->items.clear();
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t) {
+    if (q->items.empty()) return pdFALSE;
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    q->items.clear();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return (UBaseType_t)q->items.size(); }
+
+TickType_t   xTaskGetTickCount() { return millis(); }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return sim::taskHandle(w().current); }
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (task) w().notified[(int)task->task] = true;
+    return pdPASS;
+}
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+// ──────────────────────────────────────────────────────────────────────────────
+// DS1307 / DateTime
+// ──────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+int64_t daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int      era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (int64_t)era * 146097 + (int64_t)doe - 719468;
+}
+
+void civilFromDays(int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t  era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp  = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)(yoe + era * 400) + (m <= 2);
+}
+
+} // namespace
+
+DateTime::DateTime(uint32_t t) {
+    if (t < 946684800UL) t = 946684800UL;
+    int y; unsigned mo, dd;
+    civilFromDays(t / 86400UL, y, mo, dd);
+    yOff = (uint8_t)(y - 2000); m = (uint8_t)mo; d = (uint8_t)dd;
+    const uint32_t s = t % 86400UL;
+    hh = (uint8_t)(s / 3600); mm = (uint8_t)(s / 60 % 60); ss = (uint8_t)(s % 60);
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec) {
+    if (year >= 2000) year -= 2000;
+    yOff = (uint8_t)year; m = month; d = day; hh = hour; mm = min; ss = sec;
+}
+
+DateTime::DateTime(const char* date, const char* time) {
+    static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mon[4] = {};
+    int dd = 1, yy = 2000, h = 0, mi = 0, s = 0;
+    sscanf(date, "%3s %d %d", mon, &dd, &yy);
+    sscanf(time, "%d:%d:%d", &h, &mi, &s);
+    const char* p = strstr(MONTHS, mon);
+    yOff = (uint8_t)(yy - 2000); m = (uint8_t)(p ? (p - MONTHS) / 3 + 1 : 1); d = (uint8_t)dd;
+    hh = (uint8_t)h; mm = (uint8_t)mi; ss = (uint8_t)s;
+}
+
+uint32_t DateTime::unixtime() const {
+    return (uint32_t)(daysFromCivil(year(), m, d) * 86400 + hh * 3600L + mm * 60L + ss);
+}
+
+bool     RTC_DS1307::begin()     { return true; }
+bool     RTC_DS1307::isrunning() { return w().rtcRunning; }
+void     RTC_DS1307::adjust(const DateTime& dt) { sim::setRtcLocal(dt.unixtime()); }
+DateTime RTC_DS1307::now()       { return DateTime(sim::rtcLocal()); }
+
+uint8_t RTC_DS1307::readnvram(uint8_t address) { return address < 56 ? w().rtcNvram[address] : 0; }
+void RTC_DS1307::readnvram(uint8_t* buf, uint8_t size, uint8_t address) {
+    for (uint8_t i = 0; i < size; i++) buf[i] = readnvram(address + i);
+}
+void RTC_DS1307::writenvram(uint8_t address, uint8_t data) { if (address < 56) w().rtcNvram[address] = data; }
+void RTC_DS1307::writenvram(uint8_t address, const uint8_t* buf, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) writenvram(address + i, buf[i]);
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// NVS (Preferences)
+// ──────────────────────────────────────────────────────────────────────────────
+
+bool Preferences::begin(const char* name, bool ro) {
+    if (ro && !w().nvs.count(name)) return false;   // like nvs_open() in read-only mode
+    ns = name;
+    readOnly = ro;
+    w().nvs[ns];
+    return true;
+}
+
+bool Preferences::clear() {
+    if (ns.empty() || readOnly) return false;
+    w().nvs[ns].clear();
+    return true;
+}
+
+bool Preferences::isKey(const char* key) { return !ns.empty() && w().nvs[ns].count(key); }
+
+bool Preferences::remove(const char* key) {
+    if (ns.empty() || readOnly) return false;
+    return w().nvs[ns].erase(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (ns.empty() || readOnly) return 0;
+    const uint8_t* p = (const uint8_t*)value;
+    w().nvs[ns][key].assign(p, p + len);
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (ns.empty()) return 0;
+    auto& space = w().nvs[ns];
+    auto it = space.find(key);
+    if (it == space.end() || it->second.size() > maxLen) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (ns.empty()) return 0;
+    auto& space = w().nvs[ns];
+    auto it = space.find(key);
+    return it == space.end() ? 0 : it->second.size();
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// SD card (in memory)
+// ──────────────────────────────────────────────────────────────────────────────
+
+SDFS SD;
+
+namespace {
+
+struct Node {
+    bool                 dir = false;
+    std::vector<uint8_t> data;
+};
+
+std::map<std::string, Node>& nodes() {
+    static std::map<std::string, Node> n = { { "/", Node{ true, {} } } };
+    return n;
+}
+
+std::string normalize(const char* path) {
+    std::string p = (path && *path == '/') ? path : std::string("/") + (path ? path : "");
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    return p;
+}
+
+std::string parentOf(const std::string& p) {
+    const size_t slash = p.rfind('/');
+    return slash == 0 ? "/" : p.substr(0, slash);
+}
+
+bool isDir(const std::string& p) {
+    auto it = nodes().find(p);
+    return it != nodes().end() && it->second.dir;
+}
+
+} // namespace
+
+struct SimFileHandle {
+    std::string path;
+    std::string base;
+    bool        dir      = false;
+    bool        canWrite = false;
+    bool        append   = false;
+    bool        open     = true;
+    bool        dirty    = false;
+    size_t      pos      = 0;
+    sim::FileKind kind   = sim::FileKind::OTHER;
+    std::vector<std::string> children;
+    size_t      next     = 0;
+
+    Node* node() {
+        auto it = nodes().find(path);
+        return it == nodes().end() ? nullptr : &it->second;
+    }
+};
+
+File fs::FS::open(const char* rawPath, const char* mode, bool /*create*/) {
+    const std::string p = normalize(rawPath);
+    auto& n = nodes();
+    auto it = n.find(p);
+    const bool read   = mode[0] == 'r';
+    const bool plus   = mode[1] == '+';
+
+    if (it == n.end()) {
+        if (read || !isDir(parentOf(p))) return File();
+        it = n.emplace(p, Node()).first;
+    } else if (it->second.dir) {
+        auto h = std::make_shared<SimFileHandle>();
+        h->path = p;
+        h->base = p.substr(p.rfind('/') + 1);
+        h->dir  = true;
+        const std::string prefix = (p == "/") ? "/" : p + "/";
+        for (auto c = n.lower_bound(prefix); c != n.end() && c->first.compare(0, prefix.size(), prefix) == 0; ++c) {
+            if (c->first.find('/', prefix.size()) == std::string::npos) h->children.push_back(c->first);
+        }
+        w().card.opens++;
+        return File(h);
+    }
+
+    auto h = std::make_shared<SimFileHandle>();
+    h->path     = p;
+    h->base     = p.substr(p.rfind('/') + 1);
+    h->canWrite = !read || plus;
+    h->append   = mode[0] == 'a';
+    h->kind     = kindOf(p);
+    if (mode[0] == 'w') it->second.data.clear();
+    h->pos = h->append ? it->second.data.size() : 0;
+    w().card.opens++;
+    return File(h);
+}
+
+bool fs::FS::exists(const char* path) { return nodes().count(normalize(path)) > 0; }
+
+bool fs::FS::mkdir(const char* path) {
+    const std::string p = normalize(path);
+    if (nodes().count(p) || !isDir(parentOf(p))) return false;
+    nodes()[p].dir = true;
+    return true;
+}
+
+bool fs::FS::remove(const char* path) {
+    const std::string p = normalize(path);
+    auto it = nodes().find(p);
+    if (it == nodes().end() || p == "/") return false;
+    if (it->second.dir) {
+        auto next = std::next(it);
+        if (next != nodes().end() && next->first.compare(0, p.size() + 1, p + "/") == 0) return false;
+    }
+    nodes().erase(it);
+    return true;
+}
+
+bool fs::FS::rename(const char* from, const char* to) {
+    const std::string a = normalize(from), b = normalize(to);
+    auto it = nodes().find(a);
+    if (it == nodes().end() || it->second.dir || nodes().count(b) || !isDir(parentOf(b))) return false;
+    nodes()[b] = std::move(it->second);
+    nodes().erase(a);
+    return true;
+}
+
+bool SDFS::begin(uint8_t) { return true; }
+
+uint64_t SDFS::usedBytes() { return sim::cardUsedBytes(); }
+
+uint64_t sim::cardUsedBytes() {
+    uint64_t n = 0;
+    for (const auto& kv : nodes()) n += kv.second.data.size();
+    return n;
+}
+
+File::operator bool() const { return h && h->open; }
+
+size_t File::write(const uint8_t* buf, size_t n) {
+    if (!h || !h->open || !h->canWrite) return 0;
+    Node* nd = h->node();
+    if (!nd) return 0;
+    if (h->append) h->pos = nd->data.size();
+    if (h->pos + n > nd->data.size()) nd->data.resize(h->pos + n);
+    memcpy(nd->data.data() + h->pos, buf, n);
+    h->pos  += n;
+    h->dirty = true;
+    sim::CardStats& c = w().card;
+    c.writes[(int)h->kind]++;
+    c.bytes[(int)h->kind] += n;
+    return n;
+}
+
+int File::available() {
+    Node* nd = h && h->open ? h->node() : nullptr;
+    return nd && !h->dir ? (int)(nd->data.size() - std::min(h->pos, nd->data.size())) : 0;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    Node* nd = h && h->open ? h->node() : nullptr;
+    return nd && h->pos < nd->data.size() ? nd->data[h->pos] : -1;
+}
+
+size_t File::read(uint8_t* buf, size_t n) {
+    Node* nd = h && h->open ? h->node() : nullptr;
+    if (!nd || h->dir || h->pos >= nd->data.size()) return 0;
+    n = std::min(n, nd->data.size() - h->pos);
+    memcpy(buf, nd->data.data() + h->pos, n);
+    h->pos += n;
+    return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    Node* nd = h && h->open ? h->node() : nullptr;
+    if (!nd) return false;
+    int64_t target = pos;
+    if (mode == SeekCur) target += (int64_t)h->pos;
+    if (mode == SeekEnd) target = (int64_t)nd->data.size() - (int64_t)pos;
+    if (target < 0 || (size_t)target > nd->data.size()) return false;
+    h->pos = (size_t)target;
+    return true;
+}
+
+size_t File::position() const { return h ? h->pos : 0; }
+
+size_t File::size() const {
+    Node* nd = h ? h->node() : nullptr;
+    return nd ? nd->data.size() : 0;
+}
+
+void File::flush() {
+    if (!h || !h->dirty) return;
+    h->dirty = false;
+    w().card.flushes[(int)h->kind]++;
+}
+
+void File::close() {
+    if (!h) return;
+    flush();
+    h->open = false;
+    h.reset();
+}
+
+const char* File::name() const       { return h ? h->base.c_str() : ""; }
+const char* File::path() const       { return h ? h->path.c_str() : ""; }
+bool        File::isDirectory() const { return h && h->dir; }
+void        File::rewindDirectory()  { if (h) h->next = 0; }
+
+File File::openNextFile(const char* mode) {
+    if (!h || !h->dir || h->next >= h->children.size()) return File();
+    return SD.open(h->children[h->next++].c_str(), mode);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file    SimHal.h
+ * @brief   Virtual world behind the host HAL (sim/hal): clocks, DS1307,
+ *          NTP server, power, SD card and the slave-clock movements.
+ *
+ * The firmware sources are compiled unchanged against sim/hal; everything
+ * they reach through that HAL is driven from here. Time only moves when the
+ * runner (or a firmware delay()) calls runUntil(), so a simulated year costs
+ * as much CPU as the engine's work in it, not its wall time.
+ *
+ * Clocks (all in µs):
+ *  - true UTC:  the reference every error is measured against;
+ *  - uptime:    millis()/micros()/esp_timer, restarts at 0 on power-on;
+ *  - system:    time()/gettimeofday(), runs at sysPpm, reset to 1970 by a
+ *               power cut, stepped by SNTP or settimeofday();
+ *  - DS1307:    local wall time written by the firmware, runs at rtcPpm and
+ *               keeps counting through power cuts (battery).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+namespace sim {
+
+/// World constants; change before the first powerOn().
+struct Params {
+    double   rtcPpm        = 12.0;     ///< DS1307 crystal error (+ = fast).
+    double   sysPpm        = 3.0;      ///< ESP32 system clock error while running.
+    uint32_t ntpLatencyMs  = 40;       ///< Request → reply when the network is up.
+    uint32_t ntpRetryMs    = 15000;    ///< SNTP retry while unanswered.
+    uint32_t wifiAssocMs   = 3000;     ///< Power-on → station has an IP (no NTP before).
+    uint32_t minDriveUs    = 100000;   ///< Shortest drive that still steps a movement.
+    uint32_t minStepMs     = 0;        ///< A drive starting sooner after the last step slips (0 = never).
+    bool     verbose       = false;    ///< Echo the firmware's Serial output.
+};
+Params& params();
+
+// ── Time ─────────────────────────────────────────────────────────────────────
+int64_t  trueUtcUs();
+uint64_t uptimeUs();
+int64_t  nextEventUs();             ///< Earliest pending esp_timer/SNTP event (true UTC µs), INT64_MAX if none.
+void     runUntil(int64_t trueUs);  ///< Advance true time, firing due events in order.
+void     setTrueUtcUs(int64_t us);  ///< Starting point; only before the first powerOn().
+
+// ── World changes ────────────────────────────────────────────────────────────
+void setNetwork(bool up);           ///< NTP replies only while up.
+bool networkUp();
+int64_t wifiUpUs();                 ///< True µs at which this boot's station gets its IP.
+void setNtpServerErrorMs(int64_t ms); ///< NTP server wrong by this much (bad upstream).
+void powerOff();                    ///< RAM state, timers, SNTP and system clock are lost.
+void powerOn();                     ///< Uptime 0, system clock at the epoch, GPIO low.
+void setRtcLocal(uint32_t localUnix); ///< Factory-set the DS1307 (local wall time).
+uint32_t rtcLocal();                ///< What the DS1307 reads now.
+
+// ── Scheduler support ────────────────────────────────────────────────────────
+enum class Task : uint8_t { CLOCK, NET };
+void         setCurrentTask(Task t);
+TaskHandle_t taskHandle(Task t);
+bool         takeNotify(Task t);     ///< Pending xTaskNotifyGive() (cleared).
+
+// ── Slave-clock movements ────────────────────────────────────────────────────
+/**
+ * @struct Movement
+ * @brief A polarized minute movement on two bridge pins: it advances one
+ *        minute per drive of at least minDriveUs whose polarity differs
+ *        from the previous one; a repeated polarity does nothing, and so does
+ *        a drive less than minStepMs after the last step began (slip).
+ *
+ * Optional sense pin: digitalRead() gives the dial parity (a position
+ * contact that toggles every step), analogRead() a coil current while driven.
+ */
+struct Movement {
+    int      pin1 = -1, pin2 = -1;
+    int      dial = 0;                ///< Minutes of day shown (0..1439).
+    int8_t   lastPolarity = -1;       ///< 0 = A (IN1 high), 1 = B; -1 unknown (first drive steps).
+    bool     driving = false;
+    int8_t   polarity = -1;
+    int64_t  driveStartUs = 0;
+    uint32_t steps = 0;
+    uint32_t samePolarity = 0;        ///< Drives ignored by the movement (polarity repeated).
+    uint32_t tooShort = 0;            ///< Drives cut below minDriveUs (e.g. by a power cut).
+    uint32_t slipped = 0;             ///< Drives that came too soon after the last step.
+    int64_t  lastStepUs = -1;         ///< Drive start of the last step (true µs).
+    int      sensePin = -1;           ///< Feedback input, -1 = none.
+};
+int             addMovement(int pin1, int pin2, int dialMinutes, int8_t lastPolarity);
+Movement&       movement(int index);
+int             movementCount();
+
+// ── SD card ──────────────────────────────────────────────────────────────────
+enum class FileKind : uint8_t { LOG, EVENT_LOG, STATE, OTHER, COUNT };
+struct CardStats {
+    uint64_t writes[(int)FileKind::COUNT]  = {};   ///< write() calls.
+    uint64_t bytes[(int)FileKind::COUNT]   = {};
+    uint64_t flushes[(int)FileKind::COUNT] = {};   ///< flush()/close() after writing: ≈ card writes.
+    uint64_t opens = 0;
+};
+const CardStats& cardStats();
+uint64_t         cardUsedBytes();
+const char*      fileKindName(FileKind k);
+
+// ── Serial ───────────────────────────────────────────────────────────────────
+uint64_t serialBytes();
+
+} // namespace sim
@@ -0,0 +1,197 @@
+/**
+ * @file    Arduino.h  (host simulation)
+ * @brief   The subset of the ESP32 Arduino core the clock engine uses,
+ *          backed by the simulator's virtual time, GPIO and serial sink.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#define HIGH 1
+#define LOW  0
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define F(x) x
+
+size_t strlcpy(char* dst, const char* src, size_t size);
+size_t strlcat(char* dst, const char* src, size_t size);
+
+using std::min;
+using std::max;
+
+// ──────────────────────────────────────────────────────────────────────────────
+// String (std::string underneath)
+// ──────────────────────────────────────────────────────────────────────────────
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& c) : s(c) {}
+    explicit String(char c) : s(1, c) {}
+    String(int v)                : s(std::to_string(v)) {}
+    String(unsigned v)           : s(std::to_string(v)) {}
+    String(long v)               : s(std::to_string(v)) {}
+    String(unsigned long v)      : s(std::to_string(v)) {}
+    String(long long v)          : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(double v, int decimals = 2) {
+        char b[40];
+        snprintf(b, sizeof(b), "%.*f", decimals, v);
+        s = b;
+    }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned length() const   { return (unsigned)s.size(); }
+    bool isEmpty() const      { return s.empty(); }
+    bool reserve(unsigned n)  { s.reserve(n); return true; }
+
+    bool startsWith(const String& x) const { return s.compare(0, x.s.size(), x.s) == 0; }
+    bool endsWith(const String& x) const {
+        return s.size() >= x.s.size() && s.compare(s.size() - x.s.size(), x.s.size(), x.s) == 0;
+    }
+    int indexOf(char c, unsigned from = 0) const           { return pos(s.find(c, from)); }
+    int indexOf(const String& x, unsigned from = 0) const  { return pos(s.find(x.s, from)); }
+    int lastIndexOf(char c) const                          { return pos(s.rfind(c)); }
+    String substring(unsigned a) const                     { return a < s.size() ? String(s.substr(a)) : String(); }
+    String substring(unsigned a, unsigned b) const         { return a < b && a < s.size() ? String(s.substr(a, b - a)) : String(); }
+    char charAt(unsigned i) const                          { return i < s.size() ? s[i] : '\0'; }
+    char operator[](unsigned i) const                      { return charAt(i); }
+
+    void trim() {
+        const size_t a = s.find_first_not_of(" \t\r\n");
+        const size_t b = s.find_last_not_of(" \t\r\n");
+        s = (a == std::string::npos) ? std::string() : s.substr(a, b - a + 1);
+    }
+    void toLowerCase() { for (char& c : s) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : s) c = (char)toupper((unsigned char)c); }
+    long  toInt() const   { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+    bool equalsIgnoreCase(const String& o) const { return strcasecmp(s.c_str(), o.s.c_str()) == 0; }
+
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator==(const char* o) const   { return s == (o ? o : ""); }
+    bool operator!=(const char* o) const   { return !(*this == o); }
+    bool operator<(const String& o) const  { return s < o.s; }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o)   { if (o) s += o; return *this; }
+    String& operator+=(char c)          { s += c; return *this; }
+    bool concat(const char* c)          { *this += c; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b)   { return String(a.s + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b)   { return String(std::string(a ? a : "") + b.s); }
+
+private:
+    std::string s;
+    static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+};
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Print / Stream / Serial
+// ──────────────────────────────────────────────────────────────────────────────
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t* buf, size_t n) = 0;
+    virtual void flush() {}
+    size_t write(const char* s)           { return write((const uint8_t*)s, strlen(s)); }
+    size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char* s)   { return write(s); }
+    size_t print(char c)          { return write((uint8_t)c); }
+    size_t print(int v)           { return printf("%d", v); }
+    size_t print(unsigned v)      { return printf("%u", v); }
+    size_t print(long v)          { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int d = 2) { return printf("%.*f", d, v); }
+
+    size_t println()                { return write("\r\n"); }
+    template<class T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[512];
+        va_list ap;
+        va_start(ap, fmt);
+        const int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (n <= 0) return 0;
+        return write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    String readStringUntil(char term) {
+        std::string out;
+        for (int c = read(); c >= 0 && c != term; c = read()) out += (char)c;
+        return String(out);
+    }
+    void setTimeout(unsigned long) {}
+};
+
+/// Serial output goes to stdout only when the simulator runs verbose.
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(const uint8_t* buf, size_t n) override;
+    using Print::write;
+    explicit operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Time, GPIO, system
+// ──────────────────────────────────────────────────────────────────────────────
+
+// 32-bit like on the ESP32, so a simulated year also crosses the 49.7-day millis() wrap.
+uint32_t millis();
+uint32_t micros();
+void delay(unsigned long ms);            ///< Advances virtual time (timers/SNTP fire meanwhile).
+void delayMicroseconds(unsigned us);
+void yield();
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);   ///< Feeds the simulated slave-clock movements.
+int  digitalRead(int pin);
+int  analogRead(int pin);                ///< 12-bit; a movement's sense pin reads its coil current.
+
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+void configTzTime(const char* tz, const char* server1, const char* server2 = nullptr,
+                  const char* server3 = nullptr);
+
+class EspClass {
+public:
+    uint32_t getFreeHeap()    { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    void     restart();
+};
+extern EspClass ESP;
@@ -0,0 +1,80 @@
+/**
+ * @file    ArduinoJson.h  (host simulation)
+ * @brief   Inert stand-in: every lookup is null, so `doc["key"] | fallback`
+ *          yields the fallback and deserializeJson() reports an error.
+ *
+ * The simulator does not read /config.json; scenarios start from
+ * ConfigManager's defaults and override fields directly (sim/main.cpp).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class JsonObject;
+class JsonArray;
+
+class JsonVariant {
+public:
+    JsonVariant operator[](const char*) const   { return JsonVariant(); }
+    JsonVariant operator[](const String&) const { return JsonVariant(); }
+    JsonVariant operator[](int) const           { return JsonVariant(); }
+    template<class T> JsonVariant& operator=(const T&) { return *this; }
+    template<class T> T    as() const { return T(); }
+    template<class T> bool is() const { return false; }
+    bool   isNull() const { return true; }
+    size_t size() const   { return 0; }
+
+    const char*   operator|(const char* d) const   { return d; }
+    bool          operator|(bool d) const          { return d; }
+    int           operator|(int d) const           { return d; }
+    long          operator|(long d) const          { return d; }
+    unsigned      operator|(unsigned d) const      { return d; }
+    unsigned long operator|(unsigned long d) const { return d; }
+    float         operator|(float d) const         { return d; }
+    double        operator|(double d) const        { return d; }
+
+    JsonObject createNestedObject(const char* key = nullptr) const;
+    JsonArray  createNestedArray(const char* key = nullptr) const;
+};
+
+class JsonObject : public JsonVariant {
+public:
+    struct Pair {
+        const char* key() const   { return ""; }
+        JsonVariant value() const { return JsonVariant(); }
+    };
+    Pair* begin() const { return nullptr; }
+    Pair* end() const   { return nullptr; }
+};
+
+class JsonArray : public JsonVariant {
+public:
+    JsonVariant* begin() const { return nullptr; }
+    JsonVariant* end() const   { return nullptr; }
+};
+
+inline JsonObject JsonVariant::createNestedObject(const char*) const { return JsonObject(); }
+inline JsonArray  JsonVariant::createNestedArray(const char*) const  { return JsonArray(); }
+
+class JsonDocument : public JsonVariant {
+public:
+    void clear() {}
+    size_t capacity() const { return 1; }
+};
+template<size_t N> class StaticJsonDocument : public JsonDocument {};
+class DynamicJsonDocument : public JsonDocument {
+public:
+    explicit DynamicJsonDocument(size_t) {}
+};
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+    Code code() const { return InvalidInput; }
+    bool operator==(Code c) const { return code() == c; }
+    explicit operator bool() const { return true; }
+    const char* c_str() const { return "not supported in simulation"; }
+};
+template<class T> DeserializationError deserializeJson(JsonDocument&, T&) { return DeserializationError(); }
+template<class T> size_t serializeJson(const JsonVariant&, T&) { return 0; }
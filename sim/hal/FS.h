@@ -0,0 +1,69 @@
+/**
+ * @file    FS.h  (host simulation)
+ * @brief   File API over the simulator's in-memory card (SimHal.cpp).
+ *
+ * Data is visible to readers as soon as it is written; flush() is counted
+ * as one card write so runs can compare SD traffic.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct SimFileHandle;
+
+class File : public Stream {
+public:
+    File() = default;
+    explicit File(std::shared_ptr<SimFileHandle> handle) : h(std::move(handle)) {}
+
+    explicit operator bool() const;
+
+    using Print::write;
+    size_t write(const uint8_t* buf, size_t n) override;
+    int    available() override;
+    int    read() override;
+    int    peek() override;
+    size_t read(uint8_t* buf, size_t n);
+    bool   seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void   flush() override;
+    void   close();
+
+    const char* name() const;   ///< Basename, as in ESP32 core 2.x.
+    const char* path() const;
+    bool        isDirectory() const;
+    File        openNextFile(const char* mode = FILE_READ);
+    void        rewindDirectory();
+
+private:
+    std::shared_ptr<SimFileHandle> h;
+};
+
+namespace fs {
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path)  { return mkdir(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rmdir(const char* path)    { return remove(path); }
+};
+
+} // namespace fs
+
+using fs::FS;
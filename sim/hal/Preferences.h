@@ -0,0 +1,34 @@
+/**
+ * @file    Preferences.h  (host simulation)
+ * @brief   NVS namespaces kept by the simulator across power cuts.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+    bool   begin(const char* name, bool readOnly = false);
+    void   end() { ns.clear(); }
+    bool   clear();
+    bool   isKey(const char* key);
+    bool   remove(const char* key);
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+    size_t getBytesLength(const char* key);
+
+    size_t   putUInt(const char* key, uint32_t v) { return putBytes(key, &v, sizeof(v)); }
+    uint32_t getUInt(const char* key, uint32_t d = 0) { getBytes(key, &d, sizeof(d)); return d; }
+    size_t   putInt(const char* key, int32_t v) { return putBytes(key, &v, sizeof(v)); }
+    int32_t  getInt(const char* key, int32_t d = 0) { getBytes(key, &d, sizeof(d)); return d; }
+    size_t   putFloat(const char* key, float v) { return putBytes(key, &v, sizeof(v)); }
+    float    getFloat(const char* key, float d = 0) { getBytes(key, &d, sizeof(d)); return d; }
+    size_t   putBool(const char* key, bool v) { return putBytes(key, &v, sizeof(v)); }
+    bool     getBool(const char* key, bool d = false) { getBytes(key, &d, sizeof(d)); return d; }
+
+private:
+    std::string ns;
+    bool        readOnly = true;
+};
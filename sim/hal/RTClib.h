@@ -0,0 +1,77 @@
+/**
+ * @file    RTClib.h  (host simulation)
+ * @brief   DateTime/TimeSpan as in Adafruit RTClib, and a DS1307 whose
+ *          oscillator runs at the simulator's configured error (ppm).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class TimeSpan {
+public:
+    TimeSpan(int32_t seconds = 0) : secs(seconds) {}
+    TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+        : secs((int32_t)days * 86400L + (int32_t)hours * 3600 + (int32_t)minutes * 60 + seconds) {}
+    int16_t days() const         { return (int16_t)(secs / 86400L); }
+    int8_t  hours() const        { return (int8_t)(secs / 3600 % 24); }
+    int8_t  minutes() const      { return (int8_t)(secs / 60 % 60); }
+    int8_t  seconds() const      { return (int8_t)(secs % 60); }
+    int32_t totalseconds() const { return secs; }
+    TimeSpan operator+(const TimeSpan& o) const { return TimeSpan(secs + o.secs); }
+    TimeSpan operator-(const TimeSpan& o) const { return TimeSpan(secs - o.secs); }
+
+private:
+    int32_t secs;
+};
+
+/**
+ * @class DateTime
+ * @brief Broken-down calendar time without a zone (RTClib semantics, years 2000+).
+ */
+class DateTime {
+public:
+    DateTime(uint32_t unixTime = 946684800UL);   // 2000-01-01 00:00:00
+    DateTime(uint16_t year, uint8_t month, uint8_t day,
+             uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+    DateTime(const char* date, const char* time);   ///< __DATE__, __TIME__
+
+    uint16_t year() const   { return yOff + 2000; }
+    uint8_t  month() const  { return m; }
+    uint8_t  day() const    { return d; }
+    uint8_t  hour() const   { return hh; }
+    uint8_t  minute() const { return mm; }
+    uint8_t  second() const { return ss; }
+    uint8_t  dayOfTheWeek() const { return (uint8_t)((unixtime() / 86400UL + 4) % 7); }
+    bool     isValid() const { return m >= 1 && m <= 12 && d >= 1 && d <= 31 && hh < 24 && mm < 60 && ss < 60; }
+
+    uint32_t unixtime() const;
+    uint32_t secondstime() const { return unixtime() - 946684800UL; }
+
+    DateTime operator+(const TimeSpan& span) const { return DateTime(unixtime() + span.totalseconds()); }
+    DateTime operator-(const TimeSpan& span) const { return DateTime(unixtime() - span.totalseconds()); }
+    TimeSpan operator-(const DateTime& right) const { return TimeSpan((int32_t)(unixtime() - right.unixtime())); }
+    bool operator<(const DateTime& o) const  { return unixtime() < o.unixtime(); }
+    bool operator==(const DateTime& o) const { return unixtime() == o.unixtime(); }
+
+private:
+    uint8_t yOff, m, d, hh, mm, ss;
+};
+
+/**
+ * @class RTC_DS1307
+ * @brief Simulated DS1307: keeps counting through power cuts (battery), with
+ *        56 bytes of battery-backed NVRAM.
+ */
+class RTC_DS1307 {
+public:
+    bool     begin();
+    bool     isrunning();
+    void     adjust(const DateTime& dt);
+    DateTime now();
+
+    uint8_t  readnvram(uint8_t address);
+    void     readnvram(uint8_t* buf, uint8_t size, uint8_t address);
+    void     writenvram(uint8_t address, uint8_t data);
+    void     writenvram(uint8_t address, const uint8_t* buf, uint8_t size);
+};
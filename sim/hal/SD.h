@@ -0,0 +1,17 @@
+/**
+ * @file    SD.h  (host simulation)
+ * @brief   The in-memory card (always present; contents survive power cuts).
+ */
+
+#pragma once
+
+#include "FS.h"
+
+class SDFS : public fs::FS {
+public:
+    bool     begin(uint8_t csPin = 5);
+    void     end() {}
+    uint64_t totalBytes() { return 4ULL << 30; }
+    uint64_t usedBytes();
+};
+extern SDFS SD;
@@ -0,0 +1,19 @@
+/**
+ * @file    esp_sntp.h  (host simulation)
+ * @brief   SNTP client talking to the simulator's NTP server model.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/time.h>
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void     sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t cb);
+bool     sntp_restart(void);
+void     sntp_stop(void);
+void     sntp_init(void);
+bool     sntp_enabled(void);
+void     sntp_set_sync_interval(uint32_t intervalMs);
+uint32_t sntp_get_sync_interval(void);
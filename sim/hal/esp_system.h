@@ -0,0 +1,13 @@
+/**
+ * @file    esp_system.h  (host simulation)
+ * @brief   Shutdown hooks run by ESP.restart()/esp_restart(), not by a simulated power cut.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+
+typedef void (*shutdown_handler_t)(void);
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+void      esp_restart(void);
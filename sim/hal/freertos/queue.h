@@ -0,0 +1,17 @@
+/**
+ * @file    freertos/queue.h  (host simulation)
+ * @brief   Copying FIFO queues; calls never block (the simulator runs one task at a time).
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct SimQueue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t    xQueueSend(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t    xQueueOverwrite(QueueHandle_t q, const void* item);
+BaseType_t    xQueueReceive(QueueHandle_t q, void* item, TickType_t wait);
+BaseType_t    xQueueReset(QueueHandle_t q);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t q);
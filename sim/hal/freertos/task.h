@@ -0,0 +1,15 @@
+/**
+ * @file    freertos/task.h  (host simulation)
+ * @brief   Task notifications map onto the simulator's scheduler (see SimHal.h).
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct SimTask* TaskHandle_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t   xTaskGetTickCount();
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
@@ -0,0 +1,27 @@
+/**
+ * @file    sim_time.h  (host simulation, force-included)
+ * @brief   Routes time()/gettimeofday()/settimeofday() of the firmware
+ *          sources to the simulated ESP32 system clock.
+ *
+ * localtime_r()/mktime() stay the host's, so POSIX TZ strings (and with them
+ * every DST rule) behave exactly as on the device.
+ */
+
+#pragma once
+
+#include <time.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+time_t sim_time(time_t* out);
+int    sim_gettimeofday(struct timeval* tv, void* tz);
+int    sim_settimeofday(const struct timeval* tv, const void* tz);
+#ifdef __cplusplus
+}
+#endif
+
+#define time(out)             sim_time(out)
+#define gettimeofday(tv, tz)  sim_gettimeofday(tv, tz)
+#define settimeofday(tv, tz)  sim_settimeofday(tv, tz)
@@ -0,0 +1,634 @@
+/**
+ * @file    main.cpp  (host simulation)
+ * @brief   Runs the clock engine through a simulated year of power cuts,
+ *          NTP outages and DST changes, and reports how well the dials keep up.
+ *
+ * The boot sequence mirrors PragotronController.ino (without web and power
+ * management; Wi-Fi is an association delay after power-on that ends with the
+ * GOT_IP notification); the two FreeRTOS tasks are stepped cooperatively:
+ *  - clock: SystemManager::loop() whenever its idleWaitMs() expires or a task
+ *    notification arrives (as ulTaskNotifyTake() would return);
+ *  - net:   serviceNetwork() and the deferred SD writers once per second and
+ *    right after every clock step that is not polling a pulse edge.
+ *
+ * A movement is "in sync" while its dial shows the true local minute. Out-of-
+ * sync stretches of 5 s or more are episodes, attributed to the most recent
+ * disturbance (power cut, DST change, bad NTP) within the preceding 6 h.
+ *
+ * Usage: pragotron-sim [--days N] [--seed N] [--channels N] [--backend loop|esp_timer]
+ *                      [--mode auto|manual] [--cuts N] [--outages N] [--bad-ntp]
+ *                      [--rtc-ppm X] [--sys-ppm X] [--wifi-ms N]
+ *                      [--min-step-ms N] [--feedback off|current|sensor] [--json] [--verbose]
+ */
+
+#include "SimHal.h"
+#include <SD.h>
+#include "ConfigManager.h"
+#include "Logger.h"
+#include "EventManager.h"
+#include "EventLog.h"
+#include "RTCManager.h"
+#include "StateManager.h"
+#include "PulseManager.h"
+#include "SystemManager.h"
+#include "Metrics.h"
+#include "NetWake.h"
+#include <chrono>
+#include <climits>
+#include <random>
+#include <vector>
+
+#define PIN_IN1 25
+#define PIN_IN2 26
+#define PIN_SENSE 34        // + channel index
+
+static constexpr int64_t US_PER_S   = 1000000;
+static constexpr int64_t US_PER_MIN = 60 * US_PER_S;
+static constexpr int64_t NET_TICK_US = 1000 * 1000;
+static constexpr int64_t EPISODE_MIN_US = 5 * US_PER_S;
+static constexpr int64_t CAUSE_WINDOW_US = 6 * 3600 * US_PER_S;
+static const char* const TZ_EU = "CET-1CEST,M3.5.0/2,M10.5.0/3";
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Options
+// ──────────────────────────────────────────────────────────────────────────────
+
+struct Options {
+    int         days      = 365;
+    uint32_t    seed      = 1;
+    int         channels  = 1;
+    const char* backend   = "esp_timer";
+    const char* mode      = "auto";
+    double      cutsPerMonth    = 4;     ///< Power cuts, exponential inter-arrival.
+    double      outagesPerMonth = 2;     ///< Network (NTP) outages.
+    bool        badNtp    = false;       ///< One NTP server step of +1 h for 30 min mid-run.
+    const char* feedback  = "off";       ///< Step feedback mode for every channel.
+    bool        json      = false;
+};
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--days" && hasValue)          o.days = atoi(argv[++i]);
+        else if (a == "--seed" && hasValue)     o.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--channels" && hasValue) o.channels = std::max(1, std::min(MAX_CHANNELS, atoi(argv[++i])));
+        else if (a == "--backend" && hasValue)  o.backend = argv[++i];
+        else if (a == "--mode" && hasValue)     o.mode = argv[++i];
+        else if (a == "--cuts" && hasValue)     o.cutsPerMonth = atof(argv[++i]);
+        else if (a == "--outages" && hasValue)  o.outagesPerMonth = atof(argv[++i]);
+        else if (a == "--rtc-ppm" && hasValue)  sim::params().rtcPpm = atof(argv[++i]);
+        else if (a == "--sys-ppm" && hasValue)  sim::params().sysPpm = atof(argv[++i]);
+        else if (a == "--wifi-ms" && hasValue)  sim::params().wifiAssocMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--min-step-ms" && hasValue) sim::params().minStepMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (a == "--feedback" && hasValue) o.feedback = argv[++i];
+        else if (a == "--bad-ntp")              o.badNtp = true;
+        else if (a == "--json")                 o.json = true;
+        else if (a == "--verbose")              sim::params().verbose = true;
+        else {
+            fprintf(stderr, "unknown or incomplete option: %s\n"
+                    "usage: %s [--days N] [--seed N] [--channels N] [--backend loop|esp_timer]\n"
+                    "          [--mode auto|manual] [--cuts N] [--outages N] [--bad-ntp]\n"
+                    "          [--rtc-ppm X] [--sys-ppm X] [--wifi-ms N]\n"
+                    "          [--min-step-ms N] [--feedback off|current|sensor] [--json] [--verbose]\n",
+                    a.c_str(), argv[0]);
+            return false;
+        }
+    }
+    return o.days > 0;
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Firmware instance (one per boot; RAM does not survive a power cut)
+// ──────────────────────────────────────────────────────────────────────────────
+
+/**
+ * @struct Firmware
+ * @brief The globals of PragotronController.ino. A power cut abandons the
+ *        instance without running destructors, as the device would.
+ */
+struct Firmware {
+    ConfigManager  config;
+    Logger         logger;
+    EventManager   events;
+    EventLog       eventLog;
+    RTCManager     rtc;
+    StateManager   states[MAX_CHANNELS];
+    PulseManager*  pulses[MAX_CHANNELS] = {};
+    SystemManager* system = nullptr;
+    int            channelCount = 1;
+
+    /// setup(): same order as the .ino, with scenario overrides over the defaults.
+    void boot(const Options& o) {
+        sim::setCurrentTask(sim::Task::CLOCK);
+        SD.begin();
+        config.begin("/config.json");
+
+        Config& cfg = const_cast<Config&>(config.getConfig());
+        cfg.mode         = strcmp(o.mode, "auto") == 0 ? ClockMode::AUTO : ClockMode::MANUAL;
+        cfg.pulseBackend = strcmp(o.backend, "loop") == 0 ? PulseTiming::LOOP : PulseTiming::ESP_TIMER;
+        cfg.debugSerial  = sim::params().verbose;
+        cfg.channelCount = o.channels;
+        for (int i = 1; i < o.channels; i++) {
+            cfg.channels[i]        = cfg.channels[0];
+            snprintf(cfg.channels[i].name, sizeof(cfg.channels[i].name), "line%d", i);
+            cfg.channels[i].pinIn1 = PIN_IN1 + 2 * i + 2;
+            cfg.channels[i].pinIn2 = PIN_IN2 + 2 * i + 2;
+        }
+        for (int i = 0; i < o.channels; i++) {
+            cfg.channels[i].feedback    = strcmp(o.feedback, "current") == 0 ? FeedbackMode::CURRENT
+                                        : strcmp(o.feedback, "sensor")  == 0 ? FeedbackMode::SENSOR
+                                        :                                      FeedbackMode::OFF;
+            cfg.channels[i].feedbackPin = PIN_SENSE + i;
+        }
+
+        logger.begin("/logs", cfg.debugSerial);
+        logger.info("🚀 PragotronController štartuje...");
+        events.begin();
+        logger.setEventSink(&events);
+
+        channelCount = cfg.channelCount;
+        for (int i = 0; i < channelCount; i++) {
+            const ChannelConfig& chc = cfg.channels[i];
+            if (i == 0) {
+                states[i].begin("/state.txt", "/state.jnl");
+            } else {
+                char txt[16], jnl[16];
+                snprintf(txt, sizeof(txt), "/state%d.txt", i);
+                snprintf(jnl, sizeof(jnl), "/state%d.jnl", i);
+                states[i].begin(txt, jnl);
+            }
+            states[i].setNvram(&rtc, (uint8_t)i);
+            pulses[i] = new PulseManager(chc.pinIn1 >= 0 ? chc.pinIn1 : PIN_IN1,
+                                         chc.pinIn2 >= 0 ? chc.pinIn2 : PIN_IN2);
+            pulses[i]->begin();
+        }
+
+        system = new SystemManager(&config, &logger, &rtc, pulses, states, channelCount);
+        system->setEventManager(&events);
+        if (cfg.eventLog && eventLog.begin("/logs", &logger.index())) system->setEventLog(&eventLog);
+        system->begin();
+
+        logger.startDeferred();
+        system->attachEngineTask(sim::taskHandle(sim::Task::CLOCK));
+        NetWake::attach(sim::taskHandle(sim::Task::NET));
+    }
+
+    /// One ClockTask iteration; returns the engine's idle wait (µs).
+    int64_t runClock() {
+        sim::setCurrentTask(sim::Task::CLOCK);
+        const uint32_t t0 = micros();
+        system->loop();
+        Metrics::observe(Latency::CLOCK_LOOP_US, micros() - t0);
+        return (int64_t)system->idleWaitMs() * 1000;
+    }
+
+    /// One NetTask iteration (web and log retention are not simulated).
+    void runNet() {
+        sim::setCurrentTask(sim::Task::NET);
+        system->serviceNetwork();
+        logger.service();
+        eventLog.service();
+        for (int i = 0; i < channelCount; i++) states[i].service();
+    }
+};
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Scenario
+// ──────────────────────────────────────────────────────────────────────────────
+
+static int localMinuteOfDay(int64_t utcUs, bool* isDst = nullptr) {
+    const time_t t = (time_t)(utcUs / US_PER_S);
+    struct tm lt;
+    localtime_r(&t, &lt);
+    if (isDst) *isDst = lt.tm_isdst > 0;
+    return lt.tm_hour * 60 + lt.tm_min;
+}
+
+static uint32_t localUnix(int64_t utcUs) {
+    const time_t t = (time_t)(utcUs / US_PER_S);
+    struct tm lt;
+    localtime_r(&t, &lt);
+    return DateTime(lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
+                    lt.tm_hour, lt.tm_min, lt.tm_sec).unixtime();
+}
+
+/**
+ * @class Scenario
+ * @brief Random power cuts and NTP outages (seeded), plus an optional bad
+ *        NTP server window. Nothing happens during the last day, so every
+ *        run ends with a settled clock.
+ */
+class Scenario {
+public:
+    Scenario(const Options& o, int64_t startUs, int64_t endUs)
+        : opt(o), rng(o.seed), quietFromUs(endUs - 86400 * US_PER_S) {
+        cutAtUs    = draw(startUs, o.cutsPerMonth);
+        outageAtUs = draw(startUs, o.outagesPerMonth);
+        if (o.badNtp) badNtpAtUs = startUs + (endUs - startUs) / 2;
+    }
+
+    int64_t nextUs() const {
+        int64_t n = std::min(cutAtUs, outageAtUs);
+        n = std::min(n, powerOnAtUs);
+        n = std::min(n, networkUpAtUs);
+        return std::min(n, badNtpAtUs);
+    }
+
+    bool  powered     = false;
+    int   cuts        = 0;
+    int   outages     = 0;
+    int64_t cutUs     = 0;        ///< Total time without power.
+    int64_t outageUs  = 0;        ///< Total time without network.
+
+    /// Disturbance attribution for convergence episodes.
+    const char* lastCause   = "none";
+    int64_t     lastCauseUs = INT64_MIN / 2;
+
+    enum class Action { NONE, POWER_OFF, POWER_ON };
+
+    /// Apply everything due at @p now; the caller handles power transitions.
+    Action apply(int64_t now) {
+        if (powerOnAtUs <= now) {
+            powerOnAtUs = INT64_MAX;
+            return Action::POWER_ON;
+        }
+        if (cutAtUs <= now) {
+            // Log-uniform length between 1 s and 6 h
+            const double len = exp(std::uniform_real_distribution<double>(log(1.0), log(6.0 * 3600))(rng));
+            cutAtUs     = draw(now, opt.cutsPerMonth);
+            if (!powered) return Action::NONE;
+            cuts++;
+            cutUs      += (int64_t)(len * US_PER_S);
+            powerOnAtUs = now + (int64_t)(len * US_PER_S);
+            disturb("power", now);
+            return Action::POWER_OFF;
+        }
+        if (outageAtUs <= now) {
+            // Log-uniform between 1 min and 2 days
+            const double len = exp(std::uniform_real_distribution<double>(log(60.0), log(2.0 * 86400))(rng));
+            outageAtUs = draw(now, opt.outagesPerMonth);
+            if (networkUpAtUs == INT64_MAX) {
+                outages++;
+                outageUs     += (int64_t)(len * US_PER_S);
+                networkUpAtUs = now + (int64_t)(len * US_PER_S);
+                sim::setNetwork(false);
+            }
+            return Action::NONE;
+        }
+        if (networkUpAtUs <= now) {
+            networkUpAtUs = INT64_MAX;
+            sim::setNetwork(true);
+            return Action::NONE;
+        }
+        if (badNtpAtUs <= now) {
+            if (!badNtpActive) {
+                sim::setNtpServerErrorMs(3600 * 1000);
+                badNtpActive = true;
+                badNtpAtUs   = now + 30 * US_PER_MIN;
+            } else {
+                sim::setNtpServerErrorMs(0);
+                badNtpAtUs = INT64_MAX;
+            }
+            disturb("ntp", now);
+        }
+        return Action::NONE;
+    }
+
+    void disturb(const char* cause, int64_t now) {
+        lastCause   = cause;
+        lastCauseUs = now;
+    }
+
+private:
+    const Options& opt;
+    std::mt19937_64 rng;
+    int64_t quietFromUs;
+    int64_t cutAtUs       = INT64_MAX;
+    int64_t outageAtUs    = INT64_MAX;
+    int64_t powerOnAtUs   = INT64_MAX;
+    int64_t networkUpAtUs = INT64_MAX;
+    int64_t badNtpAtUs    = INT64_MAX;
+    bool    badNtpActive  = false;
+
+    int64_t draw(int64_t from, double perMonth) {
+        if (perMonth <= 0) return INT64_MAX;
+        const double mean = 30.0 * 86400 * US_PER_S / perMonth;
+        const int64_t at = from + (int64_t)std::exponential_distribution<double>(1.0 / mean)(rng);
+        return at < quietFromUs ? at : INT64_MAX;
+    }
+};
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Convergence tracking
+// ──────────────────────────────────────────────────────────────────────────────
+
+struct Episode {
+    const char* cause;
+    double      seconds;
+};
+
+/**
+ * @class Tracker
+ * @brief Compares every dial with the true local minute at each step and at
+ *        every minute boundary.
+ */
+class Tracker {
+public:
+    std::vector<Episode> episodes;
+    int64_t outOfSyncUs = 0;      ///< Summed over episodes (all channels).
+
+    void sample(int64_t now, Scenario& scn) {
+        if (now >= nextMinuteUs) {
+            bool dst;
+            trueMin = localMinuteOfDay(now, &dst);
+            if (started && dst != wasDst) scn.disturb("dst", now);
+            wasDst  = dst;
+            started = true;
+            nextMinuteUs = (now / US_PER_MIN + 1) * US_PER_MIN;
+        }
+
+        for (int i = 0; i < sim::movementCount(); i++) {
+            if ((int)state.size() <= i) state.push_back(State());
+            State& s = state[i];
+            const bool inSync = sim::movement(i).dial == trueMin;
+            if (!inSync && !s.out) {
+                s.out     = true;
+                s.sinceUs = now;
+                s.cause   = (now - scn.lastCauseUs <= CAUSE_WINDOW_US) ? scn.lastCause : "other";
+            } else if (inSync && s.out) {
+                s.out = false;
+                close(s, now);
+            }
+        }
+    }
+
+    /// Close episodes still open at the end of the run; false if any is an episode.
+    bool finish(int64_t now) {
+        bool allInSync = true;
+        for (State& s : state) {
+            if (!s.out) continue;
+            close(s, now);
+            if (now - s.sinceUs >= EPISODE_MIN_US) allInSync = false;
+        }
+        return allInSync;
+    }
+
+    int64_t nextMinuteUs = 0;
+
+private:
+    struct State {
+        bool        out     = false;
+        int64_t     sinceUs = 0;
+        const char* cause   = "";
+    };
+    std::vector<State> state;
+    bool started = false;
+    bool wasDst  = false;
+    int  trueMin = -1;
+
+    void close(const State& s, int64_t now) {
+        const int64_t len = now - s.sinceUs;
+        if (len < EPISODE_MIN_US) return;
+        episodes.push_back({ s.cause, (double)len / US_PER_S });
+        outOfSyncUs += len;
+    }
+};
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Report
+// ──────────────────────────────────────────────────────────────────────────────
+
+static double pct(std::vector<double> v, double q) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    const size_t i = (size_t)std::min<double>((double)v.size() - 1, ceil(q * (double)v.size()) - 1);
+    return v[i];
+}
+
+struct CauseStats {
+    const char*         cause;
+    std::vector<double> seconds;
+};
+
+static std::vector<CauseStats> byCause(const std::vector<Episode>& eps) {
+    std::vector<CauseStats> out;
+    for (const char* c : { "power", "dst", "ntp", "other" }) {
+        CauseStats cs{ c, {} };
+        for (const Episode& e : eps) if (strcmp(e.cause, c) == 0) cs.seconds.push_back(e.seconds);
+        out.push_back(cs);
+    }
+    return out;
+}
+
+static void printText(const Options& o, const Scenario& scn, const Tracker& tr, int boots,
+                      const std::vector<double>& readyMs, double wallS, bool inSyncAtEnd) {
+    MetricsSnapshot m;
+    Metrics::snapshot(m);
+    const double days = o.days;
+
+    printf("Pragotron simulation: %d days, seed %u, %d channel(s), backend %s, mode %s, feedback %s\n",
+           o.days, o.seed, o.channels, o.backend, o.mode, o.feedback);
+    printf("  speed           %.0f× real time (%.1f s wall)\n", days * 86400 / std::max(wallS, 1e-3), wallS);
+    printf("  world           RTC %+.1f ppm, system clock %+.1f ppm\n", sim::params().rtcPpm, sim::params().sysPpm);
+    printf("  boots           %d (%d power cuts, %.1f h dark)\n", boots, scn.cuts, (double)scn.cutUs / 3.6e9);
+    printf("  boot → engine   p50 %.0f ms, max %.0f ms after power-on\n", pct(readyMs, 0.50), pct(readyMs, 1.0));
+    printf("  network         %d outages, %.1f h without NTP\n", scn.outages, (double)scn.outageUs / 3.6e9);
+    printf("  NTP syncs       %lu ok, %lu failed\n",
+           (unsigned long)m.counters[(int)Metric::NTP_OK], (unsigned long)m.counters[(int)Metric::NTP_FAILED]);
+
+    printf("\nPulses\n");
+    printf("  issued          %lu (skipped: %lu gap, %lu busy)\n",
+           (unsigned long)m.counters[(int)Metric::PULSES],
+           (unsigned long)m.counters[(int)Metric::PULSES_SKIPPED_GAP],
+           (unsigned long)m.counters[(int)Metric::PULSES_SKIPPED_BUSY]);
+    if (strcmp(o.feedback, "off") != 0) {
+        printf("  feedback        %lu confirmed, %lu missed (retried)\n",
+               (unsigned long)m.counters[(int)Metric::PULSES_CONFIRMED],
+               (unsigned long)m.counters[(int)Metric::PULSES_MISSED]);
+    }
+    for (int i = 0; i < sim::movementCount(); i++) {
+        const sim::Movement& mv = sim::movement(i);
+        printf("  movement %d      %lu steps, %lu ignored (same polarity), %lu cut short, %lu slipped\n", i,
+               (unsigned long)mv.steps, (unsigned long)mv.samePolarity, (unsigned long)mv.tooShort,
+               (unsigned long)mv.slipped);
+    }
+    const LatencyStats& edge = m.latency[(int)Latency::MINUTE_EDGE_US];
+    printf("  minute edge     p50 %lu µs, p99 %lu µs, max %lu µs after :00\n",
+           (unsigned long)Metrics::percentile(edge, Latency::MINUTE_EDGE_US, 0.50f),
+           (unsigned long)Metrics::percentile(edge, Latency::MINUTE_EDGE_US, 0.99f),
+           (unsigned long)edge.max);
+
+    printf("\nConvergence (out-of-sync ≥ %lld s)\n", (long long)(EPISODE_MIN_US / US_PER_S));
+    printf("  %-8s %8s %10s %10s %10s\n", "cause", "episodes", "p50 s", "p95 s", "max s");
+    for (const CauseStats& cs : byCause(tr.episodes)) {
+        if (cs.seconds.empty()) continue;
+        printf("  %-8s %8zu %10.1f %10.1f %10.1f\n", cs.cause, cs.seconds.size(),
+               pct(cs.seconds, 0.50), pct(cs.seconds, 0.95), pct(cs.seconds, 1.0));
+    }
+    printf("  total           %.1f min out of sync, %s at the end\n",
+           (double)tr.outOfSyncUs / US_PER_MIN, inSyncAtEnd ? "in sync" : "OUT OF SYNC");
+
+    const sim::CardStats& c = sim::cardStats();
+    printf("\nSD card (per day)\n");
+    printf("  %-9s %10s %10s %10s\n", "file", "writes", "bytes", "flushes");
+    for (int k = 0; k < (int)sim::FileKind::COUNT; k++) {
+        if (!c.writes[k] && !c.flushes[k]) continue;
+        printf("  %-9s %10.0f %10.0f %10.0f\n", sim::fileKindName((sim::FileKind)k),
+               c.writes[k] / days, c.bytes[k] / days, c.flushes[k] / days);
+    }
+    printf("  used            %.1f KiB at the end\n", (double)sim::cardUsedBytes() / 1024);
+    printf("  DS1307 NVRAM    %.0f state commits per day\n",
+           m.counters[(int)Metric::STATE_NVRAM_COMMITS] / days);
+}
+
+static void printJson(const Options& o, const Scenario& scn, const Tracker& tr, int boots,
+                      const std::vector<double>& readyMs, double wallS, bool inSyncAtEnd) {
+    MetricsSnapshot m;
+    Metrics::snapshot(m);
+    const LatencyStats& edge = m.latency[(int)Latency::MINUTE_EDGE_US];
+
+    printf("{\"days\":%d,\"seed\":%u,\"channels\":%d,\"backend\":\"%s\",\"mode\":\"%s\",\"feedback\":\"%s\",\"wall_s\":%.3f,",
+           o.days, o.seed, o.channels, o.backend, o.mode, o.feedback, wallS);
+    printf("\"boots\":%d,\"boot_ready_ms\":{\"p50\":%.0f,\"max\":%.0f},"
+           "\"power_cuts\":%d,\"outages\":%d,\"ntp_ok\":%lu,\"ntp_failed\":%lu,",
+           boots, pct(readyMs, 0.50), pct(readyMs, 1.0), scn.cuts, scn.outages,
+           (unsigned long)m.counters[(int)Metric::NTP_OK], (unsigned long)m.counters[(int)Metric::NTP_FAILED]);
+    printf("\"pulses\":%lu,\"skipped_gap\":%lu,\"skipped_busy\":%lu,\"confirmed\":%lu,\"missed\":%lu,\"movements\":[",
+           (unsigned long)m.counters[(int)Metric::PULSES],
+           (unsigned long)m.counters[(int)Metric::PULSES_SKIPPED_GAP],
+           (unsigned long)m.counters[(int)Metric::PULSES_SKIPPED_BUSY],
+           (unsigned long)m.counters[(int)Metric::PULSES_CONFIRMED],
+           (unsigned long)m.counters[(int)Metric::PULSES_MISSED]);
+    for (int i = 0; i < sim::movementCount(); i++) {
+        const sim::Movement& mv = sim::movement(i);
+        printf("%s{\"steps\":%lu,\"same_polarity\":%lu,\"cut_short\":%lu,\"slipped\":%lu}", i ? "," : "",
+               (unsigned long)mv.steps, (unsigned long)mv.samePolarity, (unsigned long)mv.tooShort,
+               (unsigned long)mv.slipped);
+    }
+    printf("],\"minute_edge_us\":{\"p50\":%lu,\"p99\":%lu,\"max\":%lu},\"convergence\":{",
+           (unsigned long)Metrics::percentile(edge, Latency::MINUTE_EDGE_US, 0.50f),
+           (unsigned long)Metrics::percentile(edge, Latency::MINUTE_EDGE_US, 0.99f),
+           (unsigned long)edge.max);
+    bool first = true;
+    for (const CauseStats& cs : byCause(tr.episodes)) {
+        printf("%s\"%s\":{\"episodes\":%zu,\"p50_s\":%.1f,\"p95_s\":%.1f,\"max_s\":%.1f}", first ? "" : ",",
+               cs.cause, cs.seconds.size(), pct(cs.seconds, 0.50), pct(cs.seconds, 0.95), pct(cs.seconds, 1.0));
+        first = false;
+    }
+    printf("},\"out_of_sync_s\":%.1f,\"in_sync_at_end\":%s,\"sd\":{",
+           (double)tr.outOfSyncUs / US_PER_S, inSyncAtEnd ? "true" : "false");
+    const sim::CardStats& c = sim::cardStats();
+    for (int k = 0; k < (int)sim::FileKind::COUNT; k++) {
+        printf("%s\"%s\":{\"writes\":%llu,\"bytes\":%llu,\"flushes\":%llu}", k ? "," : "",
+               sim::fileKindName((sim::FileKind)k), (unsigned long long)c.writes[k],
+               (unsigned long long)c.bytes[k], (unsigned long long)c.flushes[k]);
+    }
+    printf("},\"nvram_commits\":%lu}\n", (unsigned long)m.counters[(int)Metric::STATE_NVRAM_COMMITS]);
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Main loop
+// ──────────────────────────────────────────────────────────────────────────────
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    setenv("TZ", TZ_EU, 1);
+    tzset();
+
+    // 2025-01-01 00:00:00 UTC; the installer sets the RTC, the dials and the state file.
+    const int64_t startUs = 1735689600LL * US_PER_S;
+    const int64_t endUs   = startUs + (int64_t)opt.days * 86400 * US_PER_S;
+    sim::setTrueUtcUs(startUs);
+    sim::setRtcLocal(localUnix(startUs));
+
+    const int dial = localMinuteOfDay(startUs);
+    for (int i = 0; i < opt.channels; i++) {
+        const int pin1 = i == 0 ? PIN_IN1 : PIN_IN1 + 2 * i + 2;
+        const int pin2 = i == 0 ? PIN_IN2 : PIN_IN2 + 2 * i + 2;
+        // The dial was last driven by the polarity the firmware assigns to its minute
+        const int mv = sim::addMovement(pin1, pin2, dial, dial % 2 ? 0 : 1);
+        sim::movement(mv).sensePin = PIN_SENSE + i;
+
+        char path[24];
+        if (i == 0) strlcpy(path, "/state.txt", sizeof(path));
+        else        snprintf(path, sizeof(path), "/state%d.txt", i);
+        File f = SD.open(path, FILE_WRITE);
+        f.printf("%02d:%02d\n", dial / 60, dial % 60);
+        f.close();
+    }
+
+    Scenario scn(opt, startUs, endUs);
+    Tracker  tr;
+    Firmware* fw = nullptr;
+    int boots = 0;
+    std::vector<double> readyMs;          ///< Power-on → clock task running, per boot.
+    int64_t clockWakeUs = INT64_MAX, netWakeUs = INT64_MAX, wifiUpAtUs = INT64_MAX;
+
+    auto powerOn = [&]() {
+        sim::powerOn();
+        scn.powered = true;
+        fw = new Firmware();
+        fw->boot(opt);
+        boots++;
+        readyMs.push_back((double)sim::uptimeUs() / 1000);
+        clockWakeUs = netWakeUs = sim::trueUtcUs();
+        wifiUpAtUs  = std::max(sim::wifiUpUs(), clockWakeUs);
+    };
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    powerOn();
+
+    for (;;) {
+        const int64_t now = sim::trueUtcUs();
+        if (now >= endUs) break;
+
+        int64_t next = std::min({ endUs, scn.nextUs(), tr.nextMinuteUs });
+        if (fw) next = std::min({ next, clockWakeUs, netWakeUs, wifiUpAtUs, sim::nextEventUs() });
+        sim::runUntil(std::max(next, now));
+        const int64_t t = sim::trueUtcUs();
+
+        switch (scn.apply(t)) {
+            case Scenario::Action::POWER_OFF:
+                sim::powerOff();
+                scn.powered = false;
+                fw = nullptr;      // abandoned: RAM is gone, nothing gets a chance to flush
+                clockWakeUs = netWakeUs = wifiUpAtUs = INT64_MAX;
+                break;
+            case Scenario::Action::POWER_ON:
+                powerOn();
+                break;
+            case Scenario::Action::NONE:
+                break;
+        }
+
+        if (fw) {
+            const int64_t tn = sim::trueUtcUs();
+            if (tn >= wifiUpAtUs) {            // ARDUINO_EVENT_WIFI_STA_GOT_IP
+                wifiUpAtUs = INT64_MAX;
+                fw->system->onNetworkUp();
+                netWakeUs  = tn;
+            }
+            bool clockRan = false;
+            if (tn >= clockWakeUs || sim::takeNotify(sim::Task::CLOCK)) {
+                clockWakeUs = sim::trueUtcUs() + fw->runClock();
+                clockRan = true;
+            }
+            if (tn >= netWakeUs || sim::takeNotify(sim::Task::NET) ||
+                (clockRan && !fw->system->needsFastService())) {
+                fw->runNet();
+                netWakeUs = sim::trueUtcUs() + NET_TICK_US;
+                if (sim::takeNotify(sim::Task::CLOCK)) clockWakeUs = sim::trueUtcUs();
+            }
+        }
+        tr.sample(sim::trueUtcUs(), scn);
+    }
+
+    const bool inSync = tr.finish(sim::trueUtcUs());
+    const double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (opt.json) printJson(opt, scn, tr, boots, readyMs, wallS, inSync);
+    else          printText(opt, scn, tr, boots, readyMs, wallS, inSync);
+    return inSync ? 0 : 1;
+}